@@ -1,39 +1,290 @@
 #ifndef _DG_SPARSE_BITVECTOR_H_
 #define _DG_SPARSE_BITVECTOR_H_
 
-#include <map>
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace dg {
 namespace ADT {
+namespace bitvector {
+
+// The chunk of a sparse bitvector: the bits of the elements
+// from 'shift' to 'shift + sizeof(BitsT)*8 - 1'
+template <typename ShiftT, typename BitsT>
+struct Chunk {
+    ShiftT shift;
+    BitsT bits;
+};
+
+template <typename BitsT>
+inline unsigned popcount(BitsT bits) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_popcountll(static_cast<unsigned long long>(bits)));
+#else
+    unsigned num = 0;
+    for (; bits; bits &= bits - 1)
+        ++num;
+    return num;
+#endif
+}
+
+// the position of the lowest set bit (bits must not be 0)
+template <typename BitsT>
+inline unsigned lowestBit(BitsT bits) {
+    assert(bits != 0);
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctzll(static_cast<unsigned long long>(bits)));
+#else
+    unsigned pos = 0;
+    while (!(bits & 0x1)) {
+        bits >>= 1;
+        ++pos;
+    }
+    return pos;
+#endif
+}
+
+// The operations on the bits of the chunks. Each operation is given
+// by the bits that it flips in the destination ('diff'),
+// the result is then 'dst ^ diff' and the number of the changed
+// elements is the popcount of 'diff'.
+struct UnionOp {
+    template <typename T>
+    static T diff(T d, T s) { return static_cast<T>(s & ~d); }
+#if defined(__SSE2__)
+    static __m128i diff(__m128i d, __m128i s) { return _mm_andnot_si128(d, s); }
+#endif
+#if defined(__AVX2__)
+    static __m256i diff(__m256i d, __m256i s) { return _mm256_andnot_si256(d, s); }
+#endif
+};
+
+struct IntersectionOp {
+    template <typename T>
+    static T diff(T d, T s) { return static_cast<T>(d & ~s); }
+#if defined(__SSE2__)
+    static __m128i diff(__m128i d, __m128i s) { return _mm_andnot_si128(s, d); }
+#endif
+#if defined(__AVX2__)
+    static __m256i diff(__m256i d, __m256i s) { return _mm256_andnot_si256(s, d); }
+#endif
+};
+
+struct DifferenceOp {
+    template <typename T>
+    static T diff(T d, T s) { return static_cast<T>(d & s); }
+#if defined(__SSE2__)
+    static __m128i diff(__m128i d, __m128i s) { return _mm_and_si128(d, s); }
+#endif
+#if defined(__AVX2__)
+    static __m256i diff(__m256i d, __m256i s) { return _mm256_and_si256(d, s); }
+#endif
+};
 
+///
+// Apply the operation on the bits of 'n' chunks with the same shifts.
+// Return the number of the elements that changed.
+template <typename Op, typename ShiftT, typename BitsT>
+size_t applyChunks(Chunk<ShiftT, BitsT> *dst,
+                   const Chunk<ShiftT, BitsT> *src, size_t n) {
+    size_t changed = 0;
+    for (size_t i = 0; i < n; ++i) {
+        assert(dst[i].shift == src[i].shift);
+        BitsT x = Op::diff(dst[i].bits, src[i].bits);
+        if (x) {
+            dst[i].bits ^= x;
+            changed += popcount(x);
+        }
+    }
+    return changed;
+}
+
+// The same for 64-bit shifts and bits, vectorized. A chunk is
+// a pair of words (shift, bits), the shifts are masked out
+// so that the operation does not touch them. The destination
+// is written only if the operation changes it.
+template <typename Op>
+size_t applyChunks(Chunk<uint64_t, uint64_t> *dst,
+                   const Chunk<uint64_t, uint64_t> *src, size_t n) {
+    static_assert(sizeof(Chunk<uint64_t, uint64_t>) == 16, "Unexpected chunk layout");
+
+    size_t changed = 0;
+    size_t i = 0;
+#if defined(__AVX2__)
+    const __m256i mask = _mm256_set_epi64x(-1, 0, -1, 0);
+    for (; i + 2 <= n; i += 2) {
+        __m256i d = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(dst + i));
+        __m256i s = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        __m256i x = _mm256_and_si256(Op::diff(d, s), mask);
+        if (_mm256_testz_si256(x, x))
+            continue;
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_xor_si256(d, x));
+        uint64_t words[4];
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(words), x);
+        changed += popcount(words[1]) + popcount(words[3]);
+    }
+#elif defined(__SSE2__)
+    const __m128i mask = _mm_set_epi64x(-1, 0);
+    const __m128i zero = _mm_setzero_si128();
+    for (; i < n; ++i) {
+        __m128i d = _mm_loadu_si128(reinterpret_cast<const __m128i *>(dst + i));
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        __m128i x = _mm_and_si128(Op::diff(d, s), mask);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(x, zero)) == 0xffff)
+            continue;
+
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_xor_si128(d, x));
+        uint64_t words[2];
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(words), x);
+        changed += popcount(words[1]);
+    }
+#endif
+    for (; i < n; ++i) {
+        assert(dst[i].shift == src[i].shift);
+        uint64_t x = Op::diff(dst[i].bits, src[i].bits);
+        if (x) {
+            dst[i].bits ^= x;
+            changed += popcount(x);
+        }
+    }
+    return changed;
+}
+
+} // namespace bitvector
+
+///
+// Sparse bitvector. The set bits are kept in chunks of sizeof(BitsT)*8 bits
+// that are stored in a vector sorted by their shifts, so that the operations
+// on two bitvectors go through the chunks of both at once and apply
+// the operation on the runs of the chunks with the same shifts
+// (vectorized if compiled with SSE2 or AVX2, e.g., with -march=native).
+// The bitvector does not keep empty chunks and it keeps the number
+// of the set bits.
 template <typename BitsT = uint64_t, typename ShiftT = uint64_t, size_t SCALE = 1>
 class SparseBitvectorImpl {
-    // mapping from shift to bits
-    using BitsContainerT = std::map<ShiftT, BitsT>;
-    BitsContainerT _bits{};
+    using ChunkT = bitvector::Chunk<ShiftT, BitsT>;
+    using ChunksT = std::vector<ChunkT>;
+
+    ChunksT _chunks{};
+    // the number of the set bits
+    size_t _size{0};
 
     static size_t _bitsNum() { return sizeof(BitsT) * 8; }
     static ShiftT _shift(size_t i) { return i - (i % _bitsNum()); }
+    static BitsT _bit(size_t i, ShiftT sft) { return static_cast<BitsT>(1) << (i - sft); }
+
+    // the index of the chunk with the shift or of the chunk where it
+    // should be inserted (a binary search without unpredictable branches)
+    size_t _findIdx(ShiftT sft) const {
+        size_t len = _chunks.size();
+        if (len == 0)
+            return 0;
+
+        const ChunkT *first = _chunks.data();
+        while (len > 1) {
+            size_t half = len / 2;
+            first = first[half - 1].shift < sft ? first + half : first;
+            len -= half;
+        }
+        return (first - _chunks.data()) + (first->shift < sft);
+    }
 
-    static size_t _countBits(BitsT bits) {
-        size_t num = 0;
-        while (bits) {
-            if (bits & 0x1)
-                ++num;
+    typename ChunksT::iterator _find(ShiftT sft) {
+        return _chunks.begin() + _findIdx(sft);
+    }
 
-            bits = bits >> 1;
+    typename ChunksT::const_iterator _find(ShiftT sft) const {
+        return _chunks.begin() + _findIdx(sft);
+    }
+
+    // Call 'run(i, j, n)' for each maximal run of chunks such that
+    // the chunks [i, i + n) of this bitvector have the same shifts as
+    // the chunks [j, j + n) of 'rhs', and 'other(i)' for the chunks
+    // of this bitvector that are not in 'rhs'
+    template <typename RunF, typename OtherF>
+    void _forRuns(const SparseBitvectorImpl& rhs, RunF run, OtherF other) const {
+        const auto& L = _chunks;
+        const auto& R = rhs._chunks;
+        size_t i = 0, j = 0;
+        while (i < L.size() && j < R.size()) {
+            if (L[i].shift < R[j].shift) {
+                other(i++);
+            } else if (R[j].shift < L[i].shift) {
+                ++j;
+            } else {
+                size_t n = 1;
+                while (i + n < L.size() && j + n < R.size() &&
+                       L[i + n].shift == R[j + n].shift)
+                    ++n;
+                run(i, j, n);
+                i += n;
+                j += n;
+            }
         }
 
-        return num;
+        for (; i < L.size(); ++i)
+            other(i);
     }
 
-    void _addBits(size_t i) {
-        // for now we just push it back,
-        // but we would rather do it somehow
-        // more smartly (probably not using the vector)
-        auto sft = _shift(i);
-        _bits.emplace(sft, (1UL << (i - sft)));
+    template <typename Op>
+    size_t _apply(const SparseBitvectorImpl& rhs) {
+        size_t changed = 0;
+        _forRuns(rhs, [&](size_t i, size_t j, size_t n) {
+            changed += bitvector::applyChunks<Op>(&_chunks[i], &rhs._chunks[j], n);
+        }, [](size_t) {});
+        return changed;
+    }
+
+    // add empty chunks with the shifts of 'rhs' that we do not have
+    void _addChunksOf(const SparseBitvectorImpl& rhs) {
+        size_t missing = 0;
+        size_t i = 0;
+        for (const ChunkT& c : rhs._chunks) {
+            while (i < _chunks.size() && _chunks[i].shift < c.shift)
+                ++i;
+            if (i == _chunks.size() || _chunks[i].shift != c.shift)
+                ++missing;
+        }
+
+        if (missing == 0)
+            return;
+
+        // merge the shifts from the back
+        size_t l = _chunks.size();
+        size_t r = rhs._chunks.size();
+        _chunks.resize(l + missing);
+        size_t k = _chunks.size();
+        while (r > 0) {
+            const ChunkT& c = rhs._chunks[r - 1];
+            if (l > 0 && c.shift < _chunks[l - 1].shift) {
+                _chunks[--k] = _chunks[--l];
+            } else if (l > 0 && c.shift == _chunks[l - 1].shift) {
+                _chunks[--k] = _chunks[--l];
+                --r;
+            } else {
+                _chunks[--k] = ChunkT{c.shift, 0};
+                --r;
+            }
+        }
+        assert(k == l);
+    }
+
+    // remove the chunks without bits
+    void _removeEmptyChunks() {
+        _chunks.erase(std::remove_if(_chunks.begin(), _chunks.end(),
+                                     [](const ChunkT& c) { return c.bits == 0; }),
+                      _chunks.end());
     }
 
 public:
@@ -42,113 +293,164 @@ public:
 
     SparseBitvectorImpl(const SparseBitvectorImpl&) = default;
     SparseBitvectorImpl(SparseBitvectorImpl&&) = default;
+    SparseBitvectorImpl& operator=(const SparseBitvectorImpl&) = default;
+    SparseBitvectorImpl& operator=(SparseBitvectorImpl&&) = default;
+
+    void reset() { _chunks.clear(); _size = 0; }
+    bool empty() const { return _size == 0; }
+    size_t size() const { return _size; }
+
+    void swap(SparseBitvectorImpl& oth) {
+        _chunks.swap(oth._chunks);
+        std::swap(_size, oth._size);
+    }
 
-    void reset() { _bits.clear(); }
-    bool empty() const { return _bits.empty(); }
-    void swap(SparseBitvectorImpl& oth) { _bits.swap(oth._bits); }
+    bool operator==(const SparseBitvectorImpl& rhs) const {
+        if (_size != rhs._size || _chunks.size() != rhs._chunks.size())
+            return false;
+        for (size_t i = 0; i < _chunks.size(); ++i) {
+            if (_chunks[i].shift != rhs._chunks[i].shift ||
+                _chunks[i].bits != rhs._chunks[i].bits)
+                return false;
+        }
+        return true;
+    }
+
+    bool operator!=(const SparseBitvectorImpl& rhs) const { return !operator==(rhs); }
 
     bool get(size_t i) const {
         auto sft = _shift(i);
         assert(sft % _bitsNum() == 0);
 
-        auto it = _bits.find(sft);
-        if (it == _bits.end()) {
+        auto it = _find(sft);
+        if (it == _chunks.end() || it->shift != sft)
             return false;
-        }
 
-        return (it->second & (1UL << (i - sft)));
+        return it->bits & _bit(i, sft);
     }
 
     // returns the previous value of the i-th bit
     bool set(size_t i) {
         auto sft = _shift(i);
-        auto it = _bits.find(sft);
-        if (it == _bits.end()) {
-            _addBits(i);
+        auto bit = _bit(i, sft);
+
+        // the elements are often added in the increasing order
+        if (_chunks.empty() || _chunks.back().shift < sft) {
+            _chunks.push_back(ChunkT{sft, bit});
+            ++_size;
             return false;
         }
 
-        bool prev = (it->second & (1UL << (i - sft)));
-        it->second |= (1UL << (i - sft));
+        auto it = _find(sft);
+        if (it == _chunks.end() || it->shift != sft) {
+            _chunks.insert(it, ChunkT{sft, bit});
+            ++_size;
+            return false;
+        }
+
+        if (it->bits & bit)
+            return true;
 
-        return prev;
+        it->bits |= bit;
+        ++_size;
+        return false;
     }
 
-    // union operation
+    // union operation, returns true if the bitvector changed
     bool set(const SparseBitvectorImpl& rhs) {
-        bool changed = false;
-        for (auto& pair : rhs._bits) {
-            auto& B = _bits[pair.first];
-            auto old = B;
-            B |= pair.second;
-            changed |= (old != B);
+        if (&rhs == this || rhs.empty())
+            return false;
+
+        if (empty()) {
+            *this = rhs;
+            return true;
         }
 
-        return changed;
+        _addChunksOf(rhs);
+        size_t added = _apply<bitvector::UnionOp>(rhs);
+        _size += added;
+        return added > 0;
     }
 
     // returns the previous value of the i-th bit
     bool unset(size_t i) {
         auto sft = _shift(i);
-        auto it = _bits.find(sft);
-        if (it == _bits.end()) {
+        auto it = _find(sft);
+        if (it == _chunks.end() || it->shift != sft)
+            return false;
+
+        auto bit = _bit(i, sft);
+        if (!(it->bits & bit))
             return false;
-        }
 
-        it->second &= ~(1UL << (i - sft));
-        if (it->second == 0) {
-            _bits.erase(it);
+        it->bits &= ~bit;
+        --_size;
+        if (it->bits == 0)
+            _chunks.erase(it);
+
+        return true;
+    }
+
+    // difference operation (unset the bits that are set in rhs),
+    // returns true if the bitvector changed
+    bool unset(const SparseBitvectorImpl& rhs) {
+        if (empty() || rhs.empty())
+            return false;
+
+        if (&rhs == this) {
+            reset();
+            return true;
         }
 
+        size_t removed = _apply<bitvector::DifferenceOp>(rhs);
+        if (removed == 0)
+            return false;
+
+        _size -= removed;
+        _removeEmptyChunks();
         return true;
     }
 
-    // FIXME: track the number of elements
-    // in a variable, to avoid this search...
-    size_t size() const {
-        size_t num = 0;
-        for (auto& it : _bits)
-            num += _countBits(it.second);
+    // intersection operation, returns true if the bitvector changed
+    bool intersect(const SparseBitvectorImpl& rhs) {
+        if (&rhs == this || empty())
+            return false;
 
-        return num;
+        size_t removed = 0;
+        _forRuns(rhs, [&](size_t i, size_t j, size_t n) {
+            removed += bitvector::applyChunks<bitvector::IntersectionOp>(
+                                &_chunks[i], &rhs._chunks[j], n);
+        }, [&](size_t i) {
+            removed += bitvector::popcount(_chunks[i].bits);
+            _chunks[i].bits = 0;
+        });
+
+        if (removed == 0)
+            return false;
+
+        _size -= removed;
+        _removeEmptyChunks();
+        return true;
     }
 
     class const_iterator {
-        typename BitsContainerT::const_iterator container_it;
-        typename BitsContainerT::const_iterator container_end;
-        size_t pos{0};
-
-        const_iterator(const BitsContainerT& cont, bool end = false)
-        :container_it(end ? cont.end() : cont.begin()),
-         container_end(cont.end()) {
-            // set-up the initial position
-            if (!end && !cont.empty())
-                _findClosestBit();
-        }
-
-        void _findClosestBit() {
-            assert(pos < (sizeof(BitsT)*8));
-            while (!(container_it->second & (1UL << pos))) {
-                if (++pos == sizeof(BitsT)*8)
-                    return;
-            }
-        }
+        const ChunksT *chunks{nullptr};
+        size_t idx{0};
+        // the bits of the current chunk that we did not visit yet
+        BitsT bits{0};
+
+        const_iterator(const ChunksT& cont, bool end = false)
+        : chunks(&cont), idx(end ? cont.size() : 0),
+          bits(end || cont.empty() ? 0 : cont[0].bits) {}
 
     public:
         const_iterator() = default;
         const_iterator& operator++() {
-            // shift to the next bit in the current bits
-            assert(pos < (sizeof(BitsT)*8));
-            if (++pos != 64)
-                _findClosestBit();
-
-            if (pos == 64) {
-                ++container_it;
-                pos = 0;
-                if (container_it != container_end) {
-                    _findClosestBit();
-                }
-            }
+            assert(bits != 0 && "Incrementing the end iterator");
+            // unset the lowest bit
+            bits &= bits - 1;
+            if (bits == 0 && ++idx < chunks->size())
+                bits = (*chunks)[idx].bits;
             return *this;
         }
 
@@ -159,11 +461,11 @@ public:
         }
 
         size_t operator*() const {
-            return container_it->first + pos;
+            return (*chunks)[idx].shift + bitvector::lowestBit(bits);
         }
 
         bool operator==(const const_iterator& rhs) const {
-            return pos == rhs.pos && (container_it == rhs.container_it);
+            return idx == rhs.idx && bits == rhs.bits;
         }
 
         bool operator!=(const const_iterator& rhs) const {
@@ -173,8 +475,8 @@ public:
         friend class SparseBitvectorImpl;
     };
 
-    const_iterator begin() const { return const_iterator(_bits); }
-    const_iterator end() const { return const_iterator(_bits, true /* end */); }
+    const_iterator begin() const { return const_iterator(_chunks); }
+    const_iterator end() const { return const_iterator(_chunks, true /* end */); }
 
     friend class const_iterator;
 };
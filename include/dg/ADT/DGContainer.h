@@ -2,6 +2,7 @@
 #define _DG_CONTAINER_H_
 
 #include <set>
+#include <vector>
 #include <cassert>
 #include <algorithm>
 
@@ -102,9 +103,157 @@ private:
     ContainerT container;
 };
 
+/// ------------------------------------------------------------------
+// - FlatDGContainer
+//
+//   The same interface as DGContainer, but the elements are kept
+//   in a sorted vector. Most of the nodes have only a few edges,
+//   so this is much smaller than a tree and iterating over it
+//   does not jump over the memory. Inserting or erasing
+//   single elements is linear in the size of the container,
+//   use insert(first, last) to insert more elements at once.
+//
+//   NOTE: inserting and erasing invalidates iterators
+//   (unlike with std::set), so do not modify the container
+//   while iterating over it.
+/// ------------------------------------------------------------------
+template <typename ValueT, unsigned int EXPECTED_ELEMENTS_NUM = 8>
+class FlatDGContainer
+{
+public:
+    using ContainerT = typename std::vector<ValueT>;
+    // the elements are sorted, so we do not allow to change them
+    using iterator = typename ContainerT::const_iterator;
+    using const_iterator = typename ContainerT::const_iterator;
+    using size_type = typename ContainerT::size_type;
+
+    iterator begin() const { return container.begin(); }
+    iterator end() const { return container.end(); }
+
+    size_type size() const
+    {
+        return container.size();
+    }
+
+    bool insert(ValueT n)
+    {
+        auto it = std::lower_bound(container.begin(), container.end(), n);
+        if (it != container.end() && *it == n)
+            return false;
+
+        if (container.capacity() == 0) {
+            container.reserve(EXPECTED_ELEMENTS_NUM);
+            it = container.begin();
+        }
+
+        container.insert(it, n);
+        return true;
+    }
+
+    // insert all elements from the range [first, last),
+    // returns the number of newly inserted elements
+    template <typename IT>
+    size_t insert(IT first, IT last)
+    {
+        size_t old_size = container.size();
+        container.insert(container.end(), first, last);
+        if (container.size() == old_size)
+            return 0;
+
+        auto mid = container.begin() + old_size;
+        std::sort(mid, container.end());
+        std::inplace_merge(container.begin(), mid, container.end());
+        container.erase(std::unique(container.begin(), container.end()),
+                        container.end());
+
+        return container.size() - old_size;
+    }
+
+    bool contains(ValueT n) const
+    {
+        return std::binary_search(container.begin(), container.end(), n);
+    }
+
+    size_t erase(ValueT n)
+    {
+        auto it = std::lower_bound(container.begin(), container.end(), n);
+        if (it == container.end() || *it != n)
+            return 0;
+
+        container.erase(it);
+        return 1;
+    }
+
+    void clear()
+    {
+        // release also the memory, the container is usually
+        // cleared when the node is being removed
+        ContainerT().swap(container);
+    }
+
+    bool empty() const
+    {
+        return container.empty();
+    }
+
+    void reserve(size_type n)
+    {
+        container.reserve(n);
+    }
+
+    // free the unused capacity
+    void shrink()
+    {
+        container.shrink_to_fit();
+    }
+
+    // the number of bytes that this container occupies
+    // (not counting sizeof the container itself)
+    size_t allocatedBytes() const
+    {
+        return container.capacity() * sizeof(ValueT);
+    }
+
+    void swap(FlatDGContainer<ValueT, EXPECTED_ELEMENTS_NUM>& oth)
+    {
+        container.swap(oth.container);
+    }
+
+    void intersect(const FlatDGContainer<ValueT, EXPECTED_ELEMENTS_NUM>& oth)
+    {
+        // both vectors are sorted, so we can do it in place
+        auto out = container.begin();
+        auto snd = oth.container.begin();
+        auto esnd = oth.container.end();
+        for (auto fst = container.begin(), efst = container.end();
+             fst != efst && snd != esnd; ++fst) {
+            while (snd != esnd && *snd < *fst)
+                ++snd;
+
+            if (snd != esnd && *snd == *fst)
+                *out++ = *fst;
+        }
+
+        container.erase(out, container.end());
+    }
+
+    bool operator==(const FlatDGContainer<ValueT, EXPECTED_ELEMENTS_NUM>& oth) const
+    {
+        return container == oth.container;
+    }
+
+    bool operator!=(const FlatDGContainer<ValueT, EXPECTED_ELEMENTS_NUM>& oth) const
+    {
+        return !operator==(oth);
+    }
+
+private:
+    ContainerT container;
+};
+
 // Edges are pointers to other nodes
 template <typename NodeT, unsigned int EXPECTED_EDGES_NUM = 4>
-class EdgesContainer : public DGContainer<NodeT *, EXPECTED_EDGES_NUM>
+class EdgesContainer : public FlatDGContainer<NodeT *, EXPECTED_EDGES_NUM>
 {
 };
 
@@ -0,0 +1,239 @@
+#ifndef _DG_ADT_INDEXED_MAP_H_
+#define _DG_ADT_INDEXED_MAP_H_
+
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace dg {
+namespace ADT {
+
+///
+// A map that keeps its elements in a vector in the order
+// in which they were inserted. Every element thus gets
+// a dense number (its index in the vector) and the keys
+// are mapped to these numbers by a hash table.
+//
+// For dependence graphs it means that the nodes of a function
+// are numbered in the order of instructions (that is the order
+// in which the graph is built), lookups are in constant time
+// and iterating over the nodes goes linearly through the memory
+// in a deterministic order (unlike std::map with pointers as keys).
+//
+// Erasing an element leaves a hole in the vector that is skipped
+// during iteration. Thus erasing does not invalidate iterators
+// (apart from the iterators to the erased element) and it is safe
+// to erase elements while iterating over the map.
+// Inserting elements also keeps the iterators valid
+// (they refer to the elements by the index).
+// The holes are removed by compact().
+template <typename KeyT, typename ValueT>
+class IndexedMap
+{
+public:
+    using key_type = KeyT;
+    using mapped_type = ValueT;
+    using value_type = std::pair<KeyT, ValueT>;
+    using size_type = size_t;
+
+private:
+    using IndexT = unsigned;
+
+    std::vector<value_type> _elements;
+    // holes after erased elements
+    std::vector<bool> _erased;
+    std::unordered_map<KeyT, IndexT> _index;
+
+    template <typename MapT, typename RefT>
+    class iterator_base {
+        MapT *_map{nullptr};
+        size_t _pos{0};
+
+        void skipErased()
+        {
+            while (_pos < _map->_elements.size() && _map->_erased[_pos])
+                ++_pos;
+        }
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = typename IndexedMap::value_type;
+        using difference_type = ptrdiff_t;
+        using pointer = typename std::remove_reference<RefT>::type *;
+        using reference = RefT;
+
+        iterator_base() = default;
+        iterator_base(MapT *map, size_t pos) : _map(map), _pos(pos)
+        {
+            skipErased();
+        }
+
+        // conversion from iterator to const_iterator
+        template <typename OMapT, typename ORefT>
+        iterator_base(const iterator_base<OMapT, ORefT>& oth)
+        : _map(oth.getMap()), _pos(oth.getIndex()) {}
+
+        iterator_base& operator++()
+        {
+            ++_pos;
+            skipErased();
+            return *this;
+        }
+
+        iterator_base operator++(int)
+        {
+            auto tmp = *this;
+            operator++();
+            return tmp;
+        }
+
+        reference operator*() const { return _map->_elements[_pos]; }
+        pointer operator->() const { return &_map->_elements[_pos]; }
+
+        bool operator==(const iterator_base& oth) const
+        {
+            return _pos == oth._pos && _map == oth._map;
+        }
+
+        bool operator!=(const iterator_base& oth) const
+        {
+            return !operator==(oth);
+        }
+
+        MapT *getMap() const { return _map; }
+        size_t getIndex() const { return _pos; }
+    };
+
+public:
+    using iterator = iterator_base<IndexedMap, value_type&>;
+    using const_iterator = iterator_base<const IndexedMap, const value_type&>;
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, _elements.size()); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, _elements.size()); }
+
+    size_type size() const { return _index.size(); }
+    bool empty() const { return _index.empty(); }
+
+    void reserve(size_type n)
+    {
+        _elements.reserve(n);
+        _erased.reserve(n);
+        _index.reserve(n);
+    }
+
+    iterator find(const KeyT& k)
+    {
+        auto it = _index.find(k);
+        if (it == _index.end())
+            return end();
+        return iterator(this, it->second);
+    }
+
+    const_iterator find(const KeyT& k) const
+    {
+        auto it = _index.find(k);
+        if (it == _index.end())
+            return end();
+        return const_iterator(this, it->second);
+    }
+
+    size_type count(const KeyT& k) const { return _index.count(k); }
+
+    // the dense number of the element with the key 'k'
+    // (or size of the storage if there is no such element)
+    size_t getIndex(const KeyT& k) const
+    {
+        auto it = _index.find(k);
+        if (it == _index.end())
+            return _elements.size();
+        return it->second;
+    }
+
+    std::pair<iterator, bool> emplace(const KeyT& k, const ValueT& v)
+    {
+        auto ret = _index.emplace(k, static_cast<IndexT>(_elements.size()));
+        if (!ret.second)
+            return {iterator(this, ret.first->second), false};
+
+        _elements.emplace_back(k, v);
+        _erased.push_back(false);
+        return {iterator(this, _elements.size() - 1), true};
+    }
+
+    std::pair<iterator, bool> insert(const value_type& v)
+    {
+        return emplace(v.first, v.second);
+    }
+
+    ValueT& operator[](const KeyT& k)
+    {
+        return emplace(k, ValueT()).first->second;
+    }
+
+    size_type erase(const KeyT& k)
+    {
+        auto it = _index.find(k);
+        if (it == _index.end())
+            return 0;
+
+        _erase(it->second);
+        _index.erase(it);
+        return 1;
+    }
+
+    iterator erase(iterator it)
+    {
+        assert(it.getMap() == this && "Iterator from different map");
+        erase(it->first);
+        return ++it;
+    }
+
+    void clear()
+    {
+        _elements.clear();
+        _erased.clear();
+        _index.clear();
+    }
+
+    // remove the holes after erased elements.
+    // This invalidates all iterators and renumbers the elements.
+    void compact()
+    {
+        if (_elements.size() == _index.size())
+            return;
+
+        size_t out = 0;
+        for (size_t i = 0; i < _elements.size(); ++i) {
+            if (_erased[i])
+                continue;
+
+            if (out != i)
+                _elements[out] = std::move(_elements[i]);
+            _index[_elements[out].first] = static_cast<IndexT>(out);
+            ++out;
+        }
+
+        _elements.resize(out);
+        _erased.assign(out, false);
+    }
+
+private:
+    void _erase(IndexT idx)
+    {
+        assert(!_erased[idx] && "Erasing erased element");
+        _erased[idx] = true;
+        // release the value (it may be some bigger object)
+        _elements[idx].second = ValueT();
+    }
+};
+
+} // namespace ADT
+} // namespace dg
+
+#endif // _DG_ADT_INDEXED_MAP_H_
@@ -4,11 +4,14 @@
 #include <utility>
 #include <queue>
 #include <map>
+#include <set>
+#include <vector>
 #include <cassert>
 #include <memory>
 
 #include "BBlock.h"
 #include "ADT/DGContainer.h"
+#include "ADT/IndexedMap.h"
 #include "Node.h"
 
 namespace dg {
@@ -82,11 +85,13 @@ public:
     // type of this dependence graph - so that we can refer to it in the code
     using DependenceGraphT = typename NodeT::DependenceGraphType;
 
-    using ContainerType = std::map<KeyT, NodeT *>;
+    // the nodes and blocks are numbered in the order in which
+    // they were added to the graph (see ADT::IndexedMap)
+    using ContainerType = ADT::IndexedMap<KeyT, NodeT *>;
     using iterator = typename ContainerType::iterator;
     using const_iterator = typename ContainerType::const_iterator;
 #ifdef ENABLE_CFG
-    using BBlocksMapT = std::map<KeyT, BBlock<NodeT> *>;
+    using BBlocksMapT = ADT::IndexedMap<KeyT, BBlock<NodeT> *>;
 #endif
 
 private:
@@ -382,6 +387,54 @@ public:
         return n != nullptr;
     }
 
+    // Delete more nodes at once. 'isRemoved' must return true exactly
+    // for the nodes in 'removed'. Unlike deleting the nodes one by one,
+    // the edges among the removed nodes are not removed one by one
+    // and every block is updated only once. The holes after the deleted
+    // nodes and blocks are removed, so this invalidates the iterators
+    // to the nodes and blocks of the graph.
+    template <typename PredT>
+    void deleteNodes(const std::vector<NodeT *>& removed, PredT isRemoved)
+    {
+        for (NodeT *n : removed)
+            n->isolateFromRemaining(isRemoved);
+
+#ifdef ENABLE_CFG
+        std::set<BBlock<NodeT> *> blocks;
+        for (NodeT *n : removed) {
+            BBlock<NodeT> *B = n->getBBlock();
+            if (!B)
+                continue;
+
+            // if this is a callSite it is no longer part of BBlock
+            if (n->hasSubgraphs())
+                B->removeCallSite(n);
+
+            blocks.insert(B);
+            n->setBasicBlock(nullptr);
+        }
+
+        for (BBlock<NodeT> *B : blocks) {
+            B->getNodes().remove_if(isRemoved);
+            if (B->empty())
+                B->remove();
+        }
+#endif
+
+        for (NodeT *n : removed) {
+            iterator it = nodes.find(n->getKey());
+            if (it != nodes.end() && it->second == n)
+                nodes.erase(it);
+            delete n;
+        }
+
+        // slicing removes most of the nodes, do not keep walking the holes
+        nodes.compact();
+#ifdef ENABLE_CFG
+        _blocks.compact();
+#endif
+    }
+
     bool deleteGlobalNode(KeyT k)
     {
         NodeT *n = removeGlobalNode(k);
@@ -4,6 +4,8 @@
 #ifndef _NODE_H_
 #define _NODE_H_
 
+#include <atomic>
+
 #include "DGParameters.h"
 #include "ADT/DGContainer.h"
 #include "analysis/legacy/Analysis.h"
@@ -44,7 +46,13 @@ public:
     using interference_iterator = typename InterferenceEdges::iterator;
     using const_interference_iterator = typename InterferenceEdges::const_iterator;
 
-    Node(const KeyT& k) : key(k) {}
+    Node(const KeyT& k) : key(k), id(++nodesNum) {}
+
+    // dense number of the node (unique among all the nodes of this type),
+    // so that the analyses can keep their data about nodes in arrays
+    unsigned getID() const { return id; }
+    // the number of created nodes, no node has a greater ID
+    static unsigned getNodesNum() { return nodesNum; }
 
     DependenceGraphT *setDG(DependenceGraphT *dg)
     {
@@ -88,6 +96,28 @@ public:
                                       interferenceDepEdges, n->revInterferenceDepEdges);
     }
 
+    // add control dependence edges 'this'-->'n' for all nodes
+    // from the range [first, last). Returns the number of new edges.
+    template <typename IT>
+    size_t addOutcomingCDs(IT first, IT last)
+    {
+        for (IT it = first; it != last; ++it)
+            (*it)->revControlDepEdges.insert(static_cast<NodeT *>(this));
+
+        return controlDepEdges.insert(first, last);
+    }
+
+    // add data dependence edges 'n'-->'this' for all nodes
+    // from the range [first, last). Returns the number of new edges.
+    template <typename IT>
+    size_t addIncomingDDs(IT first, IT last)
+    {
+        for (IT it = first; it != last; ++it)
+            (*it)->dataDepEdges.insert(static_cast<NodeT *>(this));
+
+        return revDataDepEdges.insert(first, last);
+    }
+
     // remove edge 'this'-->'n' from control dependencies
     bool removeControlDependence(NodeT *n)
     {
@@ -219,6 +249,22 @@ public:
 #endif
     }
 
+    // Remove the edges that isolate() removes, but only from the nodes
+    // for which 'isRemoved' is false. The other nodes are going to be
+    // deleted together with this node (see DependenceGraph::deleteNodes()),
+    // so there is no need to remove the edges among them one by one.
+    // The node is not removed from its block.
+    template <typename PredT>
+    void isolateFromRemaining(PredT isRemoved)
+    {
+        _detachEdges(controlDepEdges, &Node::revControlDepEdges, isRemoved);
+        _detachEdges(revControlDepEdges, &Node::controlDepEdges, isRemoved);
+        _detachEdges(dataDepEdges, &Node::revDataDepEdges, isRemoved);
+        _detachEdges(revDataDepEdges, &Node::dataDepEdges, isRemoved);
+        _detachEdges(useEdges, &Node::userEdges, isRemoved);
+        _detachEdges(userEdges, &Node::useEdges, isRemoved);
+    }
+
     // control dependency edges iterators
     control_iterator control_begin(void) { return controlDepEdges.begin(); }
     const_control_iterator control_begin(void) const { return controlDepEdges.begin(); }
@@ -383,6 +429,17 @@ private:
         return ret2;
     }
 
+    template <typename PredT>
+    void _detachEdges(EdgesT& edges, EdgesT Node::*revEdges, PredT isRemoved)
+    {
+        for (NodeT *n : edges) {
+            if (!isRemoved(n))
+                (n->*revEdges).erase(static_cast<NodeT *>(this));
+        }
+
+        edges.clear();
+    }
+
     // remove edge 'this'-->'n' from control dependencies
     static bool _removeBidirectionalEdge(NodeT *ths, NodeT *n,
                                          EdgesT& ths_cont, EdgesT& n_cont) {
@@ -418,6 +475,10 @@ private:
     // id of the slice this nodes is in. If it is 0, it is in no slice
     uint32_t slice_id{0};
 
+    unsigned id;
+    // the nodes are created also in more threads at once
+    static std::atomic<unsigned> nodesNum;
+
 #ifdef ENABLE_CFG
     // some analyses need classical CFG edges
     // and it is better to have even basic blocks
@@ -429,6 +490,9 @@ private:
     friend class analysis::legacy::Analysis<NodeT>;
 };
 
+template <typename DependenceGraphT, typename KeyT, typename NodeT>
+std::atomic<unsigned> Node<DependenceGraphT, KeyT, NodeT>::nodesNum{0};
+
 } // namespace dg
 
 #endif // _NODE_H_
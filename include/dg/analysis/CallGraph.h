@@ -68,6 +68,11 @@ private:
     //std::vector<FuncNode> _nodes;
 
 public:
+    FuncNode *get(const ValueT& v) {
+        auto it = _mapping.find(v);
+        return it == _mapping.end() ? nullptr : &it->second;
+    }
+
     auto begin() -> decltype(_mapping.begin()) { return _mapping.begin(); }
     auto end() -> decltype(_mapping.end()) { return _mapping.end(); }
     auto begin() const -> decltype(_mapping.begin()) { return _mapping.begin(); }
@@ -3,8 +3,8 @@
 
 #include <vector>
 
-#include "BBlock.h"
-#include "BFS.h"
+#include "dg/BBlock.h"
+#include "dg/analysis/legacy/BFS.h"
 
 namespace dg {
 namespace analysis {
@@ -59,7 +59,7 @@ public:
     void compute(BBlock<NodeT> *root)
     {
         std::vector<BBlock<NodeT> *> blocks;
-        BBlockBFS<NodeT> bfs(BFS_BB_DOM);
+        legacy::BBlockBFS<NodeT> bfs(legacy::BFS_BB_DOM);
 
         // get BBs in the order of dom tree edges (BFS),
         // so that we process it bottom-up
@@ -0,0 +1,316 @@
+#ifndef _DG_DOMINATOR_TREE_H_
+#define _DG_DOMINATOR_TREE_H_
+
+#include <cassert>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "dg/BBlock.h"
+
+namespace dg {
+namespace analysis {
+
+///
+// Compute immediate dominators in a graph with vertices 0 .. n-1,
+// where the vertex 0 is the root. The graph is kept in arrays
+// (the edges are stored in the CSR form), there are no maps involved.
+//
+// The algorithm is the semi-NCA algorithm due:
+//
+// L. Georgiadis, R. E. Tarjan, R. F. Werneck. 2006.
+// Finding Dominators in Practice.
+// Journal of Graph Algorithms and Applications, 10(1), 69-94.
+//
+// It computes semi-dominators as the Lengauer-Tarjan algorithm
+// and then gets the immediate dominators as the nearest common ancestors
+// of the semi-dominator and the parent in the DFS tree.
+class SemiNCA
+{
+public:
+    enum : unsigned { NONE = ~0u };
+
+    explicit SemiNCA(unsigned n) : _n(n) {}
+
+    void addEdge(unsigned from, unsigned to)
+    {
+        assert(from < _n && to < _n && "Invalid vertex");
+        _edges.emplace_back(from, to);
+    }
+
+    // return the immediate dominator for every vertex
+    // (NONE for the root and the vertices unreachable from the root)
+    std::vector<unsigned> compute() const
+    {
+        std::vector<unsigned> succStart, succs, predStart, preds;
+        toCSR(false, succStart, succs);
+        toCSR(true, predStart, preds);
+
+        // DFS pre-order numbering. All the arrays below
+        // are indexed by the DFS numbers, not by the vertices
+        std::vector<unsigned> num(_n, NONE);
+        std::vector<unsigned> vertex;
+        std::vector<unsigned> parent;
+        vertex.reserve(_n);
+        parent.reserve(_n);
+
+        // (vertex, the next successor to visit)
+        std::vector<std::pair<unsigned, unsigned>> stack;
+        num[0] = 0;
+        vertex.push_back(0);
+        parent.push_back(NONE);
+        stack.emplace_back(0, succStart[0]);
+        while (!stack.empty()) {
+            auto& top = stack.back();
+            if (top.second == succStart[top.first + 1]) {
+                stack.pop_back();
+                continue;
+            }
+
+            unsigned s = succs[top.second++];
+            if (num[s] != NONE)
+                continue;
+
+            num[s] = vertex.size();
+            parent.push_back(num[top.first]);
+            vertex.push_back(s);
+            stack.emplace_back(s, succStart[s]);
+        }
+
+        const unsigned N = vertex.size();
+        std::vector<unsigned> semi(N), label(N), ancestor(N, NONE);
+        for (unsigned i = 0; i < N; ++i)
+            semi[i] = label[i] = i;
+
+        std::vector<unsigned> path;
+        // compress the path in the forest of processed vertices
+        // and return the vertex with the minimal semi-dominator on it
+        auto eval = [&](unsigned v) -> unsigned {
+            if (ancestor[v] == NONE)
+                return v;
+
+            unsigned x = v;
+            while (ancestor[ancestor[x]] != NONE) {
+                path.push_back(x);
+                x = ancestor[x];
+            }
+
+            while (!path.empty()) {
+                unsigned y = path.back();
+                path.pop_back();
+
+                unsigned a = ancestor[y];
+                if (semi[label[a]] < semi[label[y]])
+                    label[y] = label[a];
+                ancestor[y] = ancestor[a];
+            }
+
+            return label[v];
+        };
+
+        // semi-dominators
+        for (unsigned w = N - 1; w > 0; --w) {
+            unsigned v = vertex[w];
+            for (unsigned i = predStart[v]; i < predStart[v + 1]; ++i) {
+                unsigned p = num[preds[i]];
+                // unreachable predecessor
+                if (p == NONE)
+                    continue;
+
+                unsigned u = eval(p);
+                if (semi[u] < semi[w])
+                    semi[w] = semi[u];
+            }
+
+            // link
+            ancestor[w] = parent[w];
+        }
+
+        // immediate dominators (nearest common ancestors)
+        std::vector<unsigned> idom(parent);
+        for (unsigned w = 1; w < N; ++w) {
+            unsigned d = idom[w];
+            while (d > semi[w])
+                d = idom[d];
+            idom[w] = d;
+        }
+
+        std::vector<unsigned> result(_n, NONE);
+        for (unsigned w = 1; w < N; ++w)
+            result[vertex[w]] = vertex[idom[w]];
+
+        return result;
+    }
+
+private:
+    unsigned _n;
+    std::vector<std::pair<unsigned, unsigned>> _edges;
+
+    void toCSR(bool reverse, std::vector<unsigned>& start,
+               std::vector<unsigned>& targets) const
+    {
+        start.assign(_n + 1, 0);
+        for (auto& e : _edges)
+            ++start[(reverse ? e.second : e.first) + 1];
+        for (unsigned i = 0; i < _n; ++i)
+            start[i + 1] += start[i];
+
+        targets.resize(_edges.size());
+        std::vector<unsigned> pos(start.begin(), start.end() - 1);
+        for (auto& e : _edges) {
+            if (reverse)
+                targets[pos[e.second]++] = e.first;
+            else
+                targets[pos[e.first]++] = e.second;
+        }
+    }
+};
+
+///
+// Dominator and post-dominator trees over BBlocks.
+// The results are stored into the BBlocks (BBlock::setIDom
+// and BBlock::setIPostDom), so that DominanceFrontiers
+// and PostDominanceFrontiers can be computed right away.
+template <typename NodeT>
+class BBlockDominators
+{
+    using BlockT = BBlock<NodeT>;
+
+public:
+    // compute immediate dominators of the blocks
+    // that are reachable from the 'entry'
+    static void computeDominators(BlockT *entry)
+    {
+        assert(entry && "Need the entry block");
+
+        // number the reachable blocks
+        std::vector<BlockT *> blocks{entry};
+        std::unordered_map<BlockT *, unsigned> index{{entry, 0}};
+        for (unsigned i = 0; i < blocks.size(); ++i) {
+            for (const auto& edge : blocks[i]->successors()) {
+                if (index.emplace(edge.target, blocks.size()).second)
+                    blocks.push_back(edge.target);
+            }
+        }
+
+        SemiNCA snca(blocks.size());
+        for (unsigned i = 0; i < blocks.size(); ++i) {
+            for (const auto& edge : blocks[i]->successors())
+                snca.addEdge(i, index[edge.target]);
+        }
+
+        auto idoms = snca.compute();
+        for (unsigned i = 1; i < blocks.size(); ++i) {
+            assert(idoms[i] != SemiNCA::NONE && "Unreachable block");
+            blocks[i]->setIDom(blocks[idoms[i]]);
+        }
+    }
+
+    // Compute immediate post-dominators of the given blocks (of one
+    // function). Only the edges between these blocks are taken into account.
+    // The blocks without immediate post-dominator (the exit blocks)
+    // get the 'root' as the immediate post-dominator.
+    // If there are blocks that cannot reach any exit block (infinite loops),
+    // then for every such region one block is taken as an additional exit
+    // (the one that was found as the last by DFS from the first unprocessed
+    // block of the region, similarly to what LLVM does), so that every
+    // block is in the post-dominator tree.
+    static void computePostDominators(const std::vector<BlockT *>& blocks,
+                                      BlockT *root)
+    {
+        assert(root && "Need the root block");
+
+        // the vertex 0 is the root, the blocks are 1 .. n
+        const unsigned n = blocks.size() + 1;
+        std::unordered_map<BlockT *, unsigned> index;
+        index.reserve(blocks.size());
+        for (unsigned i = 0; i < blocks.size(); ++i)
+            index.emplace(blocks[i], i + 1);
+
+        std::vector<std::vector<unsigned>> succs(n), preds(n);
+        for (unsigned i = 1; i < n; ++i) {
+            for (const auto& edge : blocks[i - 1]->successors()) {
+                auto it = index.find(edge.target);
+                if (it == index.end())
+                    continue;
+
+                succs[i].push_back(it->second);
+                preds[it->second].push_back(i);
+            }
+        }
+
+        // the vertices that can reach some exit (that are reachable
+        // from the root in the reversed graph)
+        std::vector<bool> reaches(n, false);
+        std::vector<unsigned> stack;
+        auto markReaching = [&](unsigned exit) {
+            reaches[exit] = true;
+            stack.push_back(exit);
+            while (!stack.empty()) {
+                unsigned v = stack.back();
+                stack.pop_back();
+                for (unsigned p : preds[v]) {
+                    if (!reaches[p]) {
+                        reaches[p] = true;
+                        stack.push_back(p);
+                    }
+                }
+            }
+        };
+
+        std::vector<unsigned> exits;
+        for (unsigned i = 1; i < n; ++i) {
+            if (succs[i].empty()) {
+                exits.push_back(i);
+                markReaching(i);
+            }
+        }
+
+        // the number of the search in which the vertex was visited
+        std::vector<unsigned> visited(n, 0);
+        for (unsigned i = 1; i < n; ++i) {
+            if (reaches[i])
+                continue;
+
+            // find the last vertex of DFS in the region from 'i'
+            unsigned last = i;
+            std::vector<unsigned> dfsStack{i};
+            visited[i] = i;
+            while (!dfsStack.empty()) {
+                unsigned v = dfsStack.back();
+                dfsStack.pop_back();
+                last = v;
+                for (unsigned s : succs[v]) {
+                    if (!reaches[s] && visited[s] != i) {
+                        visited[s] = i;
+                        dfsStack.push_back(s);
+                    }
+                }
+            }
+
+            exits.push_back(last);
+            markReaching(last);
+        }
+
+        // compute dominators in the reversed graph
+        SemiNCA snca(n);
+        for (unsigned e : exits)
+            snca.addEdge(0, e);
+        for (unsigned i = 1; i < n; ++i) {
+            for (unsigned p : preds[i])
+                snca.addEdge(i, p);
+        }
+
+        auto ipdoms = snca.compute();
+        for (unsigned i = 1; i < n; ++i) {
+            assert(ipdoms[i] != SemiNCA::NONE && "Block not in the tree");
+            BlockT *ipdom = ipdoms[i] == 0 ? root : blocks[ipdoms[i] - 1];
+            blocks[i - 1]->setIPostDom(ipdom);
+        }
+    }
+};
+
+} // namespace analysis
+} // namespace dg
+
+#endif // _DG_DOMINATOR_TREE_H_
@@ -2,6 +2,8 @@
 #define _DG_POINTER_ANALYSIS_H_
 
 #include <cassert>
+#include <cstdint>
+#include <string>
 #include <vector>
 
 #include "dg/analysis/PointsTo/Pointer.h"
@@ -10,6 +12,7 @@
 #include "dg/analysis/PointsTo/PointerAnalysisOptions.h"
 #include "dg/ADT/Queue.h"
 #include "dg/analysis/SCC.h"
+#include "dg/util/Trace.h"
 
 namespace dg {
 namespace analysis {
@@ -46,6 +49,10 @@ protected:
     std::vector<PSNode *> to_process;
     std::vector<PSNode *> changed;
 
+    // statistics of the fixpoint computation
+    uint64_t iterations_num{0};
+    uint64_t processed_nodes_num{0};
+
 public:
 
     PointerAnalysis(PointerSubgraph *ps,
@@ -87,6 +94,9 @@ public:
 
     PointerSubgraph *getPS() const { return PS; }
 
+    uint64_t getIterationsNum() const { return iterations_num; }
+    uint64_t getProcessedNodesNum() const { return processed_nodes_num; }
+
     const std::vector<std::vector<PSNode *> > &getSCCs() const { return SCCs; }
 
     virtual void enqueue(PSNode *n)
@@ -112,6 +122,11 @@ public:
 
     bool iteration() {
         assert(changed.empty());
+        DG_TRACE_SCOPE_DETAIL("PointerAnalysis::iteration",
+                              std::to_string(to_process.size()) + " nodes");
+
+        ++iterations_num;
+        processed_nodes_num += to_process.size();
 
         for (PSNode *cur : to_process) {
             bool enq = false;
@@ -145,6 +160,8 @@ public:
 
     void run()
     {
+        DG_TRACE_SCOPE("PointerAnalysis::run");
+
         // do preprocessing and queue the nodes
         preprocess();
         initialize_queue();
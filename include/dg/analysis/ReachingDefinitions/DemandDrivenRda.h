@@ -0,0 +1,90 @@
+#ifndef _DG_DEMAND_DRIVEN_RDA_H_
+#define _DG_DEMAND_DRIVEN_RDA_H_
+
+#include <cstdint>
+#include <map>
+#include <set>
+#include <utility>
+
+#include "dg/analysis/ReachingDefinitions/ReachingDefinitions.h"
+
+namespace dg {
+namespace analysis {
+namespace rd {
+
+///
+// Reaching definitions computed on demand. The analysis does not
+// run any fixpoint over the whole graph and does not fill the def_map
+// of nodes with the definitions of predecessors. Instead, every query
+// walks the graph backwards from the queried node and stops
+// on the nodes that overwrite the queried memory.
+// Results of queries are cached on the heads of linear chains of nodes,
+// so that queries from the same region of the program share the work.
+//
+// The answers are the same as the answers of the dense analysis
+// or more precise (the strong updates are checked against the queried
+// memory and not against the stored definitions).
+class DemandDrivenRda : public ReachingDefinitionsAnalysis
+{
+public:
+    struct Statistics {
+        Statistics() : queries(0), cacheHits(0), visitedNodes(0) {}
+
+        // number of queries asked to the analysis
+        uint64_t queries;
+        // number of times that we have re-used a cached answer
+        uint64_t cacheHits;
+        // total number of nodes that were visited by the queries
+        uint64_t visitedNodes;
+    };
+
+    DemandDrivenRda(ReachingDefinitionsGraph&& graph,
+                    const ReachingDefinitionsAnalysisOptions& opts)
+        : ReachingDefinitionsAnalysis(std::move(graph), opts) {}
+    DemandDrivenRda(ReachingDefinitionsGraph&& graph)
+        : DemandDrivenRda(std::move(graph), {}) {}
+
+    // there is nothing to compute in advance
+    void run() override {}
+
+    // gather definitions of memory [target + off, target + off + len]
+    // that reach the point right after the node 'where'
+    // and store them to the @ret
+    size_t getDefinitions(RDNode *where, const DefSite& ds,
+                          std::set<RDNode *>& ret);
+    size_t getDefinitions(RDNode *where, RDNode *target,
+                          const Offset& off, const Offset& len,
+                          std::set<RDNode *>& ret)
+    {
+        return getDefinitions(where, DefSite(target, off, len), ret);
+    }
+
+    size_t getReachingDefinitions(RDNode *where, RDNode *what,
+                                  const Offset& off, const Offset& len,
+                                  std::set<RDNode *>& ret) override
+    {
+        return getDefinitions(where, what, off, len, ret);
+    }
+
+    const Statistics& getStatistics() const { return statistics; }
+
+private:
+    using CacheKeyT = std::pair<RDNode *, DefSite>;
+    std::map<CacheKeyT, std::set<RDNode *>> cache;
+
+    Statistics statistics;
+
+    // is the node the first node of a linear chain of nodes?
+    static bool isChainHead(RDNode *node);
+
+    // search the definitions backwards from the 'head'
+    // without looking into the cache for the 'head' itself
+    void searchDefinitions(RDNode *head, const DefSite& ds,
+                           std::set<RDNode *>& ret);
+};
+
+} // namespace rd
+} // namespace analysis
+} // namespace dg
+
+#endif /* _DG_DEMAND_DRIVEN_RDA_H_ */
@@ -0,0 +1,88 @@
+#ifndef _DG_MEMORY_SSA_RDA_H_
+#define _DG_MEMORY_SSA_RDA_H_
+
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "dg/analysis/ReachingDefinitions/ReachingDefinitions.h"
+
+namespace dg {
+namespace analysis {
+namespace rd {
+
+///
+// Reaching definitions answered from memory-SSA-like chains.
+// For every memory object (as given by the points-to analysis that
+// was used to build the graph), every definition of the object is linked
+// to the previous definition of the same object. On the nodes with more
+// predecessors, the definitions are joined by memory phi nodes.
+// The chains are built lazily (only for the objects and nodes that are
+// queried) and there is no fixpoint computation. A query then walks
+// the chain from the queried node and skips all the nodes that do not
+// touch the queried object.
+class MemorySsaRda : public ReachingDefinitionsAnalysis
+{
+public:
+    MemorySsaRda(ReachingDefinitionsGraph&& graph,
+                 const ReachingDefinitionsAnalysisOptions& opts)
+        : ReachingDefinitionsAnalysis(std::move(graph), opts) {}
+    MemorySsaRda(ReachingDefinitionsGraph&& graph)
+        : MemorySsaRda(std::move(graph), {}) {}
+
+    // the chains are built on demand
+    void run() override {}
+
+    // gather definitions of memory [target + off, target + off + len]
+    // that reach the point right after the node 'where'
+    // and store them to the @ret
+    size_t getDefinitions(RDNode *where, const DefSite& ds,
+                          std::set<RDNode *>& ret);
+
+    size_t getReachingDefinitions(RDNode *where, RDNode *what,
+                                  const Offset& off, const Offset& len,
+                                  std::set<RDNode *>& ret) override
+    {
+        return getDefinitions(where, DefSite(what, off, len), ret);
+    }
+
+    size_t getPhisNum() const { return phi_nodes.size(); }
+
+private:
+    // (node, memory object)
+    using KeyT = std::pair<RDNode *, RDNode *>;
+
+    // the last definition of the memory object before the node
+    std::map<KeyT, RDNode *> defining;
+    // memory phi nodes placed on the nodes with more predecessors
+    std::map<KeyT, RDNode *> phis;
+    // operands of the memory phi nodes
+    std::unordered_map<RDNode *, std::vector<RDNode *>> phi_operands;
+    std::vector<std::unique_ptr<RDNode>> phi_nodes;
+
+    struct PendingPhi {
+        RDNode *phi;
+        RDNode *node;
+        RDNode *target;
+    };
+
+    // phi nodes that do not have the operands yet
+    std::vector<PendingPhi> pending;
+
+    static bool definesObject(RDNode *node, RDNode *target);
+
+    // get the last definition of 'target' that comes before the 'node'
+    // (that is a node that defines 'target' or a memory phi node)
+    RDNode *findDefinition(RDNode *node, RDNode *target);
+    RDNode *getPhi(RDNode *node, RDNode *target);
+    void completePhis();
+};
+
+} // namespace rd
+} // namespace analysis
+} // namespace dg
+
+#endif /* _DG_MEMORY_SSA_RDA_H_ */
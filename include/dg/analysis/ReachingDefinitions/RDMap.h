@@ -3,7 +3,10 @@
 
 #include <set>
 #include <map>
+#include <memory>
+#include <vector>
 #include <cassert>
+#include <cstdint>
 
 #include "dg/analysis/Offset.h"
 
@@ -161,6 +164,193 @@ public:
 
 using DefSiteSetT = std::set<DefSite>;
 
+///
+// Sorted set of def-sites of a node. Nodes have mostly one or two
+// def-sites, so the def-sites are kept in a sorted array that is stored
+// inline in the set while it is small (no allocation at all).
+// Every def-site carries flags: ELEMENT if it is a member of the set
+// (what is iterated over) and STRONG if the def-site is overwritten
+// by the node (strong update). A def-site may be only overwritten
+// and not be an element (e.g., killing local variables on return).
+class DefSiteSet
+{
+public:
+    enum : uint8_t { ELEMENT = 1 << 0, STRONG = 1 << 1 };
+
+    struct Entry {
+        Entry() : ds(nullptr), flags(0) {}
+        Entry(const DefSite& d, uint8_t f) : ds(d), flags(f) {}
+
+        DefSite ds;
+        uint8_t flags;
+    };
+
+    // iterates over the def-sites that have the given flag
+    class const_iterator {
+        const Entry *cur;
+        const Entry *end;
+        uint8_t flag;
+
+        void skip() { while (cur != end && !(cur->flags & flag)) ++cur; }
+
+    public:
+        const_iterator(const Entry *c, const Entry *e, uint8_t f)
+            : cur(c), end(e), flag(f) { skip(); }
+
+        const DefSite& operator*() const { return cur->ds; }
+        const DefSite *operator->() const { return &cur->ds; }
+        const_iterator& operator++() { ++cur; skip(); return *this; }
+        const_iterator operator++(int) { auto tmp = *this; operator++(); return tmp; }
+        bool operator==(const const_iterator& oth) const { return cur == oth.cur; }
+        bool operator!=(const const_iterator& oth) const { return cur != oth.cur; }
+    };
+
+    struct Range {
+        const_iterator b, e;
+        const_iterator begin() const { return b; }
+        const_iterator end() const { return e; }
+        bool empty() const { return b == e; }
+    };
+
+    // add the def-site with the flags, return true if anything changed
+    bool insert(const DefSite& ds, uint8_t flags = ELEMENT)
+    {
+        const Entry *pos = lowerBound(ds);
+        size_t idx = static_cast<size_t>(pos - data());
+        if (pos != data() + _size && pos->ds == ds) {
+            Entry& e = data()[idx];
+            uint8_t old = e.flags;
+            e.flags |= flags;
+            if (e.flags == old)
+                return false;
+
+            if ((e.flags & ELEMENT) && !(old & ELEMENT))
+                ++_elements;
+            if ((e.flags & STRONG) && !(old & STRONG))
+                ++_strong;
+            return true;
+        }
+
+        if (_size < INLINE_SIZE) {
+            for (size_t i = _size; i > idx; --i)
+                _inline[i] = _inline[i - 1];
+            _inline[idx] = Entry(ds, flags);
+        } else {
+            if (_heap.empty())
+                _heap.assign(_inline, _inline + _size);
+            _heap.insert(_heap.begin() + idx, Entry(ds, flags));
+        }
+
+        ++_size;
+        if (flags & ELEMENT)
+            ++_elements;
+        if (flags & STRONG)
+            ++_strong;
+        return true;
+    }
+
+    // number of elements
+    size_t size() const { return _elements; }
+    bool empty() const { return _elements == 0; }
+
+    bool count(const DefSite& ds) const { return hasFlag(ds, ELEMENT); }
+    bool isStrong(const DefSite& ds) const { return hasFlag(ds, STRONG); }
+    bool hasStrong() const { return _strong > 0; }
+
+    const_iterator begin() const { return const_iterator(data(), data() + _size, ELEMENT); }
+    const_iterator end() const { return const_iterator(data() + _size, data() + _size, ELEMENT); }
+
+    // the def-sites that are overwritten
+    Range strong() const
+    {
+        return Range{const_iterator(data(), data() + _size, STRONG),
+                     const_iterator(data() + _size, data() + _size, STRONG)};
+    }
+
+    // all the def-sites (with their flags) of the memory 'target'
+    std::pair<const Entry *, const Entry *> getObjectRange(RDNode *target) const
+    {
+        // compare only the targets, any offset and length
+        // (including the zero length) may be the smallest one
+        const Entry *b = data();
+        size_t len = _size;
+        while (len > 0) {
+            size_t half = len / 2;
+            if (b[half].ds.target < target) {
+                b += half + 1;
+                len -= half + 1;
+            } else {
+                len = half;
+            }
+        }
+
+        const Entry *e = b;
+        const Entry *end = data() + _size;
+        while (e != end && e->ds.target == target)
+            ++e;
+        return {b, e};
+    }
+
+private:
+    static const size_t INLINE_SIZE = 2;
+
+    Entry _inline[INLINE_SIZE];
+    // used when the set does not fit into the inline storage
+    std::vector<Entry> _heap;
+    uint32_t _size{0};
+    uint32_t _elements{0};
+    uint32_t _strong{0};
+
+    Entry *data() { return _heap.empty() ? _inline : _heap.data(); }
+    const Entry *data() const { return _heap.empty() ? _inline : _heap.data(); }
+
+    const Entry *lowerBound(const DefSite& ds) const
+    {
+        const Entry *b = data();
+        size_t len = _size;
+        // binary search
+        while (len > 0) {
+            size_t half = len / 2;
+            if (b[half].ds < ds) {
+                b += half + 1;
+                len -= half + 1;
+            } else {
+                len = half;
+            }
+        }
+        return b;
+    }
+
+    bool hasFlag(const DefSite& ds, uint8_t flag) const
+    {
+        const Entry *pos = lowerBound(ds);
+        return pos != data() + _size && pos->ds == ds && (pos->flags & flag);
+    }
+};
+
+///
+// Restricts what memory objects may have their definitions
+// propagated into a node. Without any set of objects,
+// everything passes.
+struct DefSiteFilter
+{
+    const std::set<RDNode *> *objects{nullptr};
+    // pass everything except the objects from the set
+    bool exclude{false};
+
+    DefSiteFilter() = default;
+    DefSiteFilter(const std::set<RDNode *> *objs, bool excl = false)
+        : objects(objs), exclude(excl) {}
+
+    bool passes(RDNode *target) const
+    {
+        if (!objects)
+            return true;
+
+        return (objects->count(target) > 0) != exclude;
+    }
+};
+
 class BasicRDMap
 {
 public:
@@ -172,10 +362,11 @@ public:
     }
 
     bool merge(const BasicRDMap *o,
-               DefSiteSetT *without = nullptr,
+               const DefSiteSet *without = nullptr,
                bool strong_update_unknown = true,
                Offset::type max_set_size  = Offset::UNKNOWN,
-               bool merge_unknown     = false);
+               bool merge_unknown     = false,
+               const DefSiteFilter *filter = nullptr);
 
     bool add(const DefSite&, RDNode *n);
     bool update(const DefSite&, RDNode *n);
@@ -184,8 +375,8 @@ public:
     // gather reaching definitions of memory [n + off, n + off + len]
     // and store them to the @ret
     size_t get(RDNode *n, const Offset& off,
-               const Offset& len, std::set<RDNode *>& ret);
-    size_t get(DefSite& ds, std::set<RDNode *>& ret);
+               const Offset& len, std::set<RDNode *>& ret) const;
+    size_t get(const DefSite& ds, std::set<RDNode *>& ret) const;
 
     template <typename IteratorT>
     class _map_iterator {
@@ -226,9 +417,155 @@ private:
     getObjectRange(const DefSite&) const;
 
     MapT _defs;
+
+    friend class SharedRDMap;
+    friend class RDMapMemoryCounter;
+};
+
+///
+// RDMap with structural sharing. The definitions are split into chunks
+// by the target memory, every chunk is a BasicRDMap that contains only
+// definitions of one memory object. The chunks and the map of chunks
+// are shared between the copies of the map and are copied only when
+// they are written to (copy-on-write). So copying a map, e.g. to a node
+// that does not define anything, does not take any memory.
+class SharedRDMap
+{
+    using ChunkT = BasicRDMap;
+    using ChunksT = std::map<RDNode *, std::shared_ptr<ChunkT>>;
+
+    std::shared_ptr<ChunksT> _chunks;
+
+    static const ChunksT& emptyChunks();
+
+    const ChunksT& chunks() const { return _chunks ? *_chunks : emptyChunks(); }
+    const ChunkT *getChunk(RDNode *target) const;
+
+    // get the map of chunks / the chunk for writing
+    // (copy it if it is shared)
+    ChunksT& chunksForWrite();
+    ChunkT& chunkForWrite(RDNode *target);
+
+public:
+    SharedRDMap() = default;
+    // copies share the memory
+    SharedRDMap(const SharedRDMap&) = default;
+    SharedRDMap& operator=(const SharedRDMap&) = default;
+
+    // the same as BasicRDMap::merge
+    bool merge(const SharedRDMap *o,
+               const DefSiteSet *without = nullptr,
+               bool strong_update_unknown = true,
+               Offset::type max_set_size  = Offset::UNKNOWN,
+               bool merge_unknown     = false,
+               const DefSiteFilter *filter = nullptr);
+
+    // make this map equal to the map 'o' (the maps share all the memory).
+    // Return true if this map changed.
+    bool assign(const SharedRDMap& o)
+    {
+        if (_chunks == o._chunks)
+            return false;
+
+        _chunks = o._chunks;
+        return true;
+    }
+
+    bool add(const DefSite&, RDNode *n);
+    bool update(const DefSite&, RDNode *n);
+    bool empty() const { return chunks().empty(); }
+
+    // gather reaching definitions of memory [n + off, n + off + len]
+    // and store them to the @ret
+    size_t get(RDNode *n, const Offset& off,
+               const Offset& len, std::set<RDNode *>& ret) const;
+    size_t get(const DefSite& ds, std::set<RDNode *>& ret) const;
+
+    class const_iterator {
+        ChunksT::const_iterator chunk;
+        ChunksT::const_iterator chunks_end;
+        BasicRDMap::MapT::const_iterator it;
+
+        const_iterator(const ChunksT::const_iterator& C,
+                       const ChunksT::const_iterator& E)
+            : chunk(C), chunks_end(E)
+        {
+            if (chunk != chunks_end) {
+                it = chunk->second->_defs.begin();
+                skipEmptyChunks();
+            }
+        }
+
+        void skipEmptyChunks()
+        {
+            while (it == chunk->second->_defs.end()) {
+                if (++chunk == chunks_end)
+                    break;
+                it = chunk->second->_defs.begin();
+            }
+        }
+
+        friend class SharedRDMap;
+
+    public:
+        const std::pair<const DefSite, RDNodesSet>& operator*() const { return *it; }
+        const std::pair<const DefSite, RDNodesSet> *operator->() const { return &*it; }
+
+        const_iterator& operator++()
+        {
+            ++it;
+            skipEmptyChunks();
+            return *this;
+        }
+
+        const_iterator operator++(int) { auto tmp = *this; operator++(); return tmp; }
+
+        bool operator==(const const_iterator& oth) const {
+            return chunk == oth.chunk && (chunk == chunks_end || it == oth.it);
+        }
+        bool operator!=(const const_iterator& oth) const { return !operator==(oth); }
+    };
+
+    // the map can be changed only via add/update/merge,
+    // so that the shared memory is not modified
+    const_iterator begin() const { return const_iterator(chunks().begin(), chunks().end()); }
+    const_iterator end() const { return const_iterator(chunks().end(), chunks().end()); }
+
+    friend class RDMapMemoryCounter;
+};
+
+///
+// Count the memory taken by a set of maps. The memory that is shared
+// between the maps is counted only once.
+class RDMapMemoryCounter
+{
+    std::set<const void *> seen_maps;
+    std::set<const void *> seen_chunks;
+
+    void addChunk(const BasicRDMap& chunk);
+
+public:
+    // number of maps
+    uint64_t maps{0};
+    // maps that share all the memory with another map
+    uint64_t sharedMaps{0};
+    // number of distinct chunks (memory objects)
+    uint64_t chunks{0};
+    // stored def-sites and (def-site, definition) pairs
+    uint64_t entries{0};
+    uint64_t definitions{0};
+    // the same if the memory was not shared
+    uint64_t unsharedEntries{0};
+    uint64_t unsharedDefinitions{0};
+
+    void add(const SharedRDMap& map);
+
+    // estimate of the memory in bytes
+    uint64_t bytes() const;
+    uint64_t unsharedBytes() const;
 };
 
-using RDMap = BasicRDMap;
+using RDMap = SharedRDMap;
 
 } // rd
 } // analysis
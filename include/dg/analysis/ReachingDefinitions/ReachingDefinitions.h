@@ -4,6 +4,7 @@
 #include <vector>
 #include <set>
 #include <cassert>
+#include <cstdint>
 #include <cstring>
 
 #include "dg/analysis/Offset.h"
@@ -78,38 +79,46 @@ public:
     virtual ~RDNode() = default;
 #endif
 
-    // this is the gro of this node, so make it public
-    DefSiteSetT defs;
-    // this is a subset of defs that are strong update
-    // on this node
-    DefSiteSetT overwrites;
+    // this is the gro of this node, so make it public.
+    // The def-sites that are strong update on this node are flagged
+    // as STRONG in the set (the set may contain also def-sites
+    // that are overwritten, but not defined, see addOverwrites())
+    DefSiteSet defs;
 
     // this is set of variables used in this node
-    DefSiteSetT uses;
+    DefSiteSet uses;
 
     RDMap def_map;
 
+    // what definitions may flow into this node from the predecessors
+    // (used to let definitions bypass the procedures that do not touch
+    // the memory)
+    DefSiteFilter filter;
+
+    // can the definitions of 'target' flow into this node
+    // from the predecessors?
+    bool passesDefinitionsOf(RDNode *target) const
+    {
+        return filter.passes(target);
+    }
+
     RDNodeType getType() const { return type; }
-    DefSiteSetT& getDefines() { return defs; }
-    DefSiteSetT& getOverwrites() { return overwrites; }
-    DefSiteSetT& getUses() { return uses; }
-    const DefSiteSetT& getDefines() const { return defs; }
-    const DefSiteSetT& getUses() const { return uses; }
+    DefSiteSet& getDefines() { return defs; }
+    DefSiteSet::Range getOverwrites() const { return defs.strong(); }
+    DefSiteSet& getUses() { return uses; }
+    const DefSiteSet& getDefines() const { return defs; }
+    const DefSiteSet& getUses() const { return uses; }
 
     bool defines(RDNode *target, const Offset& off = Offset::UNKNOWN) const
     {
-        // FIXME: this is not efficient implementation,
-        // use the ordering on the nodes
-        // (see old DefMap.h in llvm/)
-        if (off.isUnknown()) {
-            for (const DefSite& ds : defs)
-                if (ds.target == target)
-                    return true;
-        } else {
-            for (const DefSite& ds : defs)
-                if (ds.target == target
-                    && off.inRange(*ds.offset, *ds.offset + *ds.len))
-                    return true;
+        auto range = defs.getObjectRange(target);
+        for (auto I = range.first; I != range.second; ++I) {
+            if (!(I->flags & DefSiteSet::ELEMENT))
+                continue;
+
+            const DefSite& ds = I->ds;
+            if (off.isUnknown() || off.inRange(*ds.offset, *ds.offset + *ds.len))
+                return true;
         }
 
         return false;
@@ -157,14 +166,10 @@ public:
 
     void addDef(const DefSite& ds, bool strong_update = false)
     {
-        defs.insert(ds);
+        defs.insert(ds, strong_update ?
+                        DefSiteSet::ELEMENT | DefSiteSet::STRONG :
+                        DefSiteSet::ELEMENT);
         def_map.update(ds, this);
-
-        // XXX maybe we could do it by some flag in DefSite?
-        // instead of strong new copy... but it should not
-        // be big overhead this way... we'll see in the future
-        if (strong_update)
-            overwrites.insert(ds);
     }
 
     ///
@@ -188,12 +193,12 @@ public:
 
     void addOverwrites(const DefSite& ds)
     {
-        overwrites.insert(ds);
+        defs.insert(ds, DefSiteSet::STRONG);
     }
 
-    bool isOverwritten(const DefSite& ds)
+    bool isOverwritten(const DefSite& ds) const
     {
-        return overwrites.find(ds) != overwrites.end();
+        return defs.isStrong(ds);
     }
 
     const RDMap& getReachingDefinitions() const { return def_map; }
@@ -267,6 +272,10 @@ protected:
     ReachingDefinitionsGraph graph;
     unsigned int dfsnum;
 
+    // statistics of the fixpoint computation
+    uint64_t iterations_num{0};
+    uint64_t processed_nodes_num{0};
+
     const ReachingDefinitionsAnalysisOptions options;
 
 public:
@@ -317,8 +326,27 @@ public:
 
     RDNode *getRoot() const { return graph.getRoot(); }
 
+    uint64_t getIterationsNum() const { return iterations_num; }
+    uint64_t getProcessedNodesNum() const { return processed_nodes_num; }
+
     bool processNode(RDNode *n);
     virtual void run();
+
+    // gather definitions of memory [what + off, what + off + len]
+    // that reach the point right after the node 'where'
+    // and store them to the @ret
+    virtual size_t getReachingDefinitions(RDNode *where, RDNode *what,
+                                          const Offset& off, const Offset& len,
+                                          std::set<RDNode *>& ret)
+    {
+        return where->getReachingDefinitions(what, off, len, ret);
+    }
+
+protected:
+    // does the node define some part of the memory from 'ds'?
+    bool definesMemory(RDNode *node, const DefSite& ds) const;
+    // does the node overwrite (strong update) all the memory from 'ds'?
+    bool killsMemory(RDNode *node, const DefSite& ds) const;
 };
 
 } // namespace rd
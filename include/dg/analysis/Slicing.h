@@ -1,13 +1,20 @@
 #ifndef _DG_SLICING_H_
 #define _DG_SLICING_H_
 
+#include <cstdint>
+#include <functional>
 #include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
 
+#include "dg/analysis/SummaryEdges.h"
 #include "dg/analysis/legacy/Analysis.h"
 #include "dg/analysis/legacy/NodesWalk.h"
 #include "dg/analysis/legacy/BFS.h"
 #include "dg/ADT/Queue.h"
 #include "dg/DependenceGraph.h"
+#include "dg/util/Trace.h"
 
 #ifdef ENABLE_CFG
 #include "dg/BBlock.h"
@@ -49,12 +56,26 @@ public:
     }
 
     bool isForward() const { return forward_slice; }
+
+    // call 'cb' with every graph that the walk enters, before the edges
+    // of its first node are followed (e.g., to compute
+    // the dependencies of the graph lazily)
+    void setGraphCallback(std::function<void(DependenceGraph<NodeT> *)> cb)
+    {
+        graphCallback = std::move(cb);
+    }
+
+    // the number of nodes visited (and marked) by this walk
+    size_t getMarkedNodesNum() const { return markedNodesNum; }
     // returns marked blocks, but only for forward slicing atm
     const std::set<BBlock<NodeT> *>& getMarkedBlocks() { return markedBlocks; }
 
 private:
     bool forward_slice{false};
+    size_t markedNodesNum{0};
     std::set<BBlock<NodeT> *> markedBlocks;
+    std::function<void(DependenceGraph<NodeT> *)> graphCallback;
+    std::set<DependenceGraph<NodeT> *> enteredGraphs;
 
 
     struct WalkData
@@ -78,6 +99,7 @@ private:
     {
         uint32_t slice_id = data->slice_id;
         n->setSlice(slice_id);
+        ++data->analysis->markedNodesNum;
 
 #ifdef ENABLE_CFG
         // when we marked a node, we need to mark even
@@ -92,6 +114,10 @@ private:
         // the same with dependence graph, if we keep a node from
         // a dependence graph, we need to keep the dependence graph
         if (DependenceGraph<NodeT> *dg = n->getDG()) {
+            WalkAndMark *wm = data->analysis;
+            if (wm->graphCallback && wm->enteredGraphs.insert(dg).second)
+                wm->graphCallback(dg);
+
             dg->setSlice(slice_id);
             if (!data->analysis->isForward()) {
                 // and keep also all call-sites of this func (they are
@@ -106,6 +132,421 @@ private:
     }
 };
 
+///
+// A slice kept aside of the graph. The nodes of the slice are kept
+// in a bitmap indexed by the IDs of the nodes (Node::getID()), so marking
+// a slice into a SliceSet does not write anything into the graph
+// and more slices can be computed from one graph at once (in more threads).
+// A block is in the slice if any of its nodes is.
+template <typename NodeT>
+class SliceSet
+{
+    std::vector<bool> nodes;
+    size_t nodesNum{0};
+
+public:
+    SliceSet() : nodes(NodeT::getNodesNum() + 1, false) {}
+
+    // return true if the node was not in the slice yet
+    bool insert(const NodeT *n)
+    {
+        unsigned id = n->getID();
+        if (id >= nodes.size())
+            nodes.resize(NodeT::getNodesNum() + 1, false);
+        if (nodes[id])
+            return false;
+
+        nodes[id] = true;
+        ++nodesNum;
+        return true;
+    }
+
+    bool erase(const NodeT *n)
+    {
+        unsigned id = n->getID();
+        if (id >= nodes.size() || !nodes[id])
+            return false;
+
+        nodes[id] = false;
+        --nodesNum;
+        return true;
+    }
+
+    bool contains(const NodeT *n) const
+    {
+        unsigned id = n->getID();
+        return id < nodes.size() && nodes[id];
+    }
+
+#ifdef ENABLE_CFG
+    bool contains(const BBlock<NodeT> *B) const
+    {
+        for (const NodeT *n : B->getNodes()) {
+            if (contains(n))
+                return true;
+        }
+
+        return false;
+    }
+#endif
+
+    void merge(const SliceSet& oth)
+    {
+        if (oth.nodes.size() > nodes.size())
+            nodes.resize(oth.nodes.size(), false);
+
+        nodesNum = 0;
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            if (i < oth.nodes.size() && oth.nodes[i])
+                nodes[i] = true;
+            if (nodes[i])
+                ++nodesNum;
+        }
+    }
+
+    size_t size() const { return nodesNum; }
+    bool empty() const { return nodesNum == 0; }
+};
+
+///
+// Mark a slice into an empty SliceSet. It marks the same nodes
+// as Slicer::mark() (see also WalkAndMark), but it only reads the graph.
+template <typename NodeT>
+class ReadOnlyWalkAndMark
+{
+    // call 'func' on every node that depends on 'n'
+    template <typename FuncT>
+    static void forEachSuccessor(NodeT *n, FuncT func)
+    {
+        for (auto I = n->control_begin(), E = n->control_end(); I != E; ++I)
+            func(*I);
+        for (auto I = n->data_begin(), E = n->data_end(); I != E; ++I)
+            func(*I);
+        for (auto I = n->use_begin(), E = n->use_end(); I != E; ++I)
+            func(*I);
+        for (auto I = n->interference_begin(), E = n->interference_end(); I != E; ++I)
+            func(*I);
+
+#ifdef ENABLE_CFG
+        if (BBlock<NodeT> *BB = n->getBBlock()) {
+            for (BBlock<NodeT> *CD : BB->controlDependence())
+                func(CD->getFirstNode());
+        }
+#endif
+    }
+
+    // mark the nodes reachable from 'start' (backward or forward)
+    // and return the newly marked nodes
+    static std::vector<NodeT *> walk(const std::set<NodeT *>& start,
+                                     SliceSet<NodeT>& slice, bool forward)
+    {
+        std::vector<NodeT *> marked;
+        for (NodeT *n : start) {
+            if (slice.insert(n))
+                marked.push_back(n);
+        }
+
+        std::vector<NodeT *> queue(marked);
+        auto push = [&slice, &queue, &marked](NodeT *m) {
+            if (slice.insert(m)) {
+                queue.push_back(m);
+                marked.push_back(m);
+            }
+        };
+
+        while (!queue.empty()) {
+            NodeT *n = queue.back();
+            queue.pop_back();
+
+            if (forward)
+                forEachSuccessor(n, push);
+            else
+                SummaryEdges<NodeT>::forEachPredecessor(n, push);
+        }
+
+        return marked;
+    }
+
+public:
+    static void mark(const std::set<NodeT *>& start, SliceSet<NodeT>& slice,
+                     bool forward_slice = false)
+    {
+        if (!forward_slice) {
+            walk(start, slice, false);
+            return;
+        }
+
+        // the backward part of the slice must not stop
+        // at the nodes marked by the forward walk
+        SliceSet<NodeT> forward;
+        auto marked = walk(start, forward, true);
+
+#ifdef ENABLE_CFG
+        // the forward slice misses the control dependencies, so slice
+        // backward w.r.t. the branchings that the marked blocks
+        // depend on (see Slicer::mark())
+        std::set<BBlock<NodeT> *> blocks;
+        std::set<NodeT *> branchings;
+        for (NodeT *n : marked) {
+            BBlock<NodeT> *BB = n->getBBlock();
+            if (!BB || !blocks.insert(BB).second)
+                continue;
+
+            for (BBlock<NodeT> *cBB : BB->revControlDependence()) {
+                assert(cBB->successorsNum() > 1);
+                branchings.insert(cBB->getLastNode());
+            }
+        }
+
+        if (!branchings.empty())
+            walk(branchings, slice, false);
+#else
+        (void) marked;
+#endif
+        slice.merge(forward);
+    }
+};
+
+///
+// Backward context-sensitive marking of the nodes
+// using the two-phase algorithm of Horwitz, Reps and Binkley.
+//
+// The first phase goes from the slicing criteria up to the callers,
+// but does not descend into the called procedures. Instead, it takes
+// the summary edges at the call-sites and it only remembers the formal
+// outputs of the callees for the second phase. The second phase then
+// descends into the callees, but it never goes up to the callers.
+// This way, the walk goes only through the realizable paths (up to
+// the dependencies between procedures that are not summarized,
+// these are followed in the first phase and thus context-insensitively).
+template <typename NodeT>
+class TwoPhaseWalkAndMark
+{
+    const SummaryEdges<NodeT>& summaries;
+
+    // 0 - not visited, 1 or 2 - the phase in which the node was visited
+    std::unordered_map<NodeT *, unsigned> phase;
+    std::vector<NodeT *> queue1, queue2;
+    size_t markedNodesNum{0};
+    uint32_t slice_id{0};
+    // if set, the nodes are marked here instead of into the graph
+    SliceSet<NodeT> *sliceSet{nullptr};
+
+    void markSlice(NodeT *n)
+    {
+        ++markedNodesNum;
+        if (sliceSet) {
+            sliceSet->insert(n);
+            return;
+        }
+
+        n->setSlice(slice_id);
+
+#ifdef ENABLE_CFG
+        if (BBlock<NodeT> *B = n->getBBlock())
+            B->setSlice(slice_id);
+#endif
+        // keep the procedure, the entry node of the procedure
+        // is a predecessor of the node, so it gets marked too
+        if (DependenceGraph<NodeT> *dg = n->getDG())
+            dg->setSlice(slice_id);
+    }
+
+    void enqueue1(NodeT *n)
+    {
+        unsigned& p = phase[n];
+        if (p == 1)
+            return;
+
+        // the first phase may visit also nodes visited
+        // in the second phase, it goes to more nodes from them
+        if (p == 0)
+            markSlice(n);
+        p = 1;
+        queue1.push_back(n);
+    }
+
+    void enqueue2(NodeT *n)
+    {
+        unsigned& p = phase[n];
+        if (p != 0)
+            return;
+
+        markSlice(n);
+        p = 2;
+        queue2.push_back(n);
+    }
+
+    void processPhase1(NodeT *n)
+    {
+        SummaryEdges<NodeT>::forEachPredecessor(n, [this, n](NodeT *m) {
+            if (NodeT *cs = summaries.getDescendingCallSite(m, n)) {
+                enqueue2(m);
+                summaries.forEachSummaryActual(cs, m,
+                                               [this](NodeT *a) { enqueue1(a); });
+            } else
+                enqueue1(m);
+        });
+    }
+
+    void processPhase2(NodeT *n)
+    {
+        SummaryEdges<NodeT>::forEachPredecessor(n, [this, n](NodeT *m) {
+            if (summaries.getGraph(m) == summaries.getGraph(n) ||
+                summaries.getDescendingCallSite(m, n))
+                enqueue2(m);
+            else if (!summaries.isAscending(m, n))
+                // dependencies between procedures without summaries
+                enqueue1(m);
+        });
+    }
+
+public:
+    TwoPhaseWalkAndMark(const SummaryEdges<NodeT>& summaries)
+        : summaries(summaries) {}
+
+    // mark the slice into the SliceSet, the graph is only read
+    void mark(const std::set<NodeT *>& start, SliceSet<NodeT>& slice)
+    {
+        sliceSet = &slice;
+        mark(start, 0);
+        sliceSet = nullptr;
+    }
+
+    void mark(const std::set<NodeT *>& start, uint32_t sl_id)
+    {
+        slice_id = sl_id;
+        for (NodeT *n : start)
+            enqueue1(n);
+
+        while (!queue1.empty() || !queue2.empty()) {
+            while (!queue1.empty()) {
+                NodeT *n = queue1.back();
+                queue1.pop_back();
+                processPhase1(n);
+            }
+
+            if (!queue2.empty()) {
+                NodeT *n = queue2.back();
+                queue2.pop_back();
+                // the node may have been visited in the first phase
+                // in the meantime
+                if (phase[n] == 2)
+                    processPhase2(n);
+            }
+        }
+    }
+
+    // the number of marked nodes
+    size_t getMarkedNodesNum() const { return markedNodesNum; }
+};
+
+///
+// Backward marking of more slices at once. Every node gets a mask
+// of the slices that it belongs to (the i-th bit is set if the node is
+// in the slice w.r.t. the i-th set of slicing criteria). The masks
+// are propagated by one walk until they do not change, so the nodes
+// shared by more slices are processed (at most) once per slice instead
+// of walking the whole slice for every set of criteria.
+// The masks are kept aside of the nodes, materialize() then marks
+// the nodes of one slice with a slice id, so that the usual slicing
+// can be done.
+template <typename NodeT>
+class BatchWalkAndMark
+{
+public:
+    using MaskT = uint64_t;
+    enum : unsigned { MAX_SLICES = 64 };
+
+private:
+    struct NodeInfo {
+        MaskT mask{0};
+        bool queued{false};
+    };
+
+    std::unordered_map<NodeT *, NodeInfo> nodes;
+    dg::ADT::QueueFIFO<NodeT *> queue;
+
+    void add(NodeT *n, MaskT mask)
+    {
+        NodeInfo& info = nodes[n];
+        if ((info.mask | mask) == info.mask)
+            return;
+
+        info.mask |= mask;
+        if (!info.queued) {
+            info.queued = true;
+            queue.push(n);
+        }
+    }
+
+public:
+    // the i-th set of criteria gives the i-th slice
+    void mark(const std::vector<std::set<NodeT *>>& criteria)
+    {
+        assert(criteria.size() <= MAX_SLICES && "Too many slices");
+
+        for (unsigned i = 0; i < criteria.size(); ++i) {
+            for (NodeT *n : criteria[i])
+                add(n, MaskT(1) << i);
+        }
+
+        while (!queue.empty()) {
+            NodeT *n = queue.pop();
+            NodeInfo& info = nodes[n];
+            info.queued = false;
+
+            // 'info' may be invalidated by adding new nodes
+            MaskT mask = info.mask;
+            SummaryEdges<NodeT>::forEachPredecessor(n, [this, mask](NodeT *m) {
+                add(m, mask);
+            });
+        }
+    }
+
+    MaskT getMask(NodeT *n) const
+    {
+        auto it = nodes.find(n);
+        return it == nodes.end() ? 0 : it->second.mask;
+    }
+
+    // Mark the nodes (their blocks and graphs) of the i-th slice
+    // with 'slice_id'. Return the number of the nodes in the slice.
+    size_t materialize(unsigned idx, uint32_t slice_id) const
+    {
+        assert(idx < MAX_SLICES && "Invalid slice");
+
+        size_t num = 0;
+        for (const auto& it : nodes) {
+            if (!(it.second.mask & (MaskT(1) << idx)))
+                continue;
+
+            NodeT *n = it.first;
+            n->setSlice(slice_id);
+            ++num;
+#ifdef ENABLE_CFG
+            if (BBlock<NodeT> *B = n->getBBlock())
+                B->setSlice(slice_id);
+#endif
+            if (DependenceGraph<NodeT> *dg = n->getDG())
+                dg->setSlice(slice_id);
+        }
+
+        return num;
+    }
+
+    // put the nodes of the i-th slice into the SliceSet
+    void materialize(unsigned idx, SliceSet<NodeT>& slice) const
+    {
+        assert(idx < MAX_SLICES && "Invalid slice");
+
+        for (const auto& it : nodes) {
+            if (it.second.mask & (MaskT(1) << idx))
+                slice.insert(it.first);
+        }
+    }
+};
+
 struct SlicerStatistics
 {
     SlicerStatistics()
@@ -127,6 +568,8 @@ class Slicer : legacy::Analysis<NodeT>
     uint32_t slice_id;
 
     std::set<DependenceGraph<NodeT> *> sliced_graphs;
+    // see WalkAndMark::setGraphCallback()
+    std::function<void(DependenceGraph<NodeT> *)> graphCallback;
 
     // slice nodes from the graph; do it recursively for call-nodes
     void sliceNodes(DependenceGraph<NodeT> *dg, uint32_t slice_id)
@@ -178,15 +621,23 @@ public:
     SlicerStatistics& getStatistics() { return statistics; }
     const SlicerStatistics& getStatistics() const { return statistics; }
 
+    // the callback for the walks of mark(), see WalkAndMark::setGraphCallback()
+    void setGraphCallback(std::function<void(DependenceGraph<NodeT> *)> cb)
+    {
+        graphCallback = std::move(cb);
+    }
+
     ///
     // Mark nodes dependent on 'start' with 'sl_id'.
     // If 'forward_slice' is true, mark the nodes depending on 'start' instead.
     uint32_t mark(NodeT *start, uint32_t sl_id = 0, bool forward_slice = false)
     {
+        DG_TRACE_SCOPE("Slicer::mark");
         if (sl_id == 0)
             sl_id = ++slice_id;
 
         WalkAndMark<NodeT> wm(forward_slice);
+        wm.setGraphCallback(graphCallback);
         wm.mark(start, sl_id);
 
         ///
@@ -208,6 +659,7 @@ public:
 
             if (!branchings.empty()) {
                 WalkAndMark<NodeT> wm2;
+                wm2.setGraphCallback(graphCallback);
                 wm2.mark(branchings, sl_id);
             }
         }
@@ -0,0 +1,336 @@
+#ifndef _DG_SUMMARY_EDGES_H_
+#define _DG_SUMMARY_EDGES_H_
+
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "dg/DependenceGraph.h"
+#include "dg/DGParameters.h"
+
+#ifdef ENABLE_CFG
+#include "dg/BBlock.h"
+#endif
+
+namespace dg {
+namespace analysis {
+
+///
+// Summary edges of procedures as described in:
+//
+// S. Horwitz, T. Reps, D. Binkley. 1990.
+// Interprocedural slicing using dependence graphs.
+// ACM Trans. Program. Lang. Syst. 12, 1 (January 1990), 26-60.
+//
+// For every formal output of a procedure (formal output parameters,
+// the exit node and the no-return node) we compute the set of formal
+// inputs (formal input parameters and the entry node) that it depends on
+// through realizable paths inside the procedure (and the procedures
+// it calls). At a call-site, the summary edges then lead from actual
+// inputs to actual outputs without entering the callee.
+//
+// The graphs have also other edges between procedures
+// (e.g., data dependencies between memory accesses found by reaching
+// definitions); these edges are not summarized, the slicer must
+// follow them in the context-insensitive way.
+template <typename NodeT>
+class SummaryEdges
+{
+    using DGT = typename NodeT::DependenceGraphType;
+
+    // formal output -> formal inputs of the same procedure
+    std::unordered_map<NodeT *, std::set<NodeT *>> summaries;
+    // actual parameters and call nodes -> call node
+    std::unordered_map<NodeT *, NodeT *> callSites;
+    // formal parameters -> their procedure (some of them,
+    // e.g., the exit node, do not have the graph set)
+    std::unordered_map<NodeT *, DGT *> formalIns;
+    std::unordered_map<NodeT *, DGT *> formalOuts;
+    // the graphs and the graphs that call them
+    std::vector<DGT *> graphs;
+    std::unordered_map<DGT *, std::set<DGT *>> callers;
+
+    size_t edgesNum{0};
+
+    template <typename FuncT>
+    static void forEachParameter(DGParameters<NodeT> *params, FuncT func)
+    {
+        if (!params)
+            return;
+
+        for (auto& it : *params)
+            func(it.second.in, it.second.out);
+        for (auto I = params->global_begin(), E = params->global_end();
+             I != E; ++I)
+            func(I->second.in, I->second.out);
+        if (auto *va = params->getVarArg())
+            func(va->in, va->out);
+        if (NodeT *noret = params->getNoReturn())
+            func(nullptr, noret);
+    }
+
+    static void add(std::set<NodeT *>& to, NodeT *n)
+    {
+        if (n)
+            to.insert(n);
+    }
+
+    void gatherGraphs(DGT *entry)
+    {
+        std::unordered_set<DGT *> visited{entry};
+        // (graph, is it the post-order visit?)
+        std::vector<std::pair<DGT *, bool>> stack{{entry, false}};
+
+        while (!stack.empty()) {
+            auto cur = stack.back();
+            stack.pop_back();
+
+            if (cur.second) {
+                // callees go before callers
+                graphs.push_back(cur.first);
+                continue;
+            }
+
+            stack.emplace_back(cur.first, true);
+            for (auto& it : *cur.first) {
+                NodeT *n = it.second;
+                if (n->getSubgraphs().empty())
+                    continue;
+
+                callSites[n] = n;
+                forEachParameter(n->getParameters(),
+                                 [this, n](NodeT *in, NodeT *out) {
+                    if (in)
+                        callSites[in] = n;
+                    if (out)
+                        callSites[out] = n;
+                });
+
+                for (DGT *sub : n->getSubgraphs()) {
+                    callers[sub].insert(cur.first);
+                    if (visited.insert(sub).second)
+                        stack.emplace_back(sub, false);
+                }
+            }
+        }
+
+        for (DGT *graph : graphs) {
+            formalIns.emplace(graph->getEntry(), graph);
+            if (graph->getExit())
+                formalOuts.emplace(graph->getExit(), graph);
+
+            forEachParameter(graph->getParameters(),
+                             [this, graph](NodeT *in, NodeT *out) {
+                if (in)
+                    formalIns.emplace(in, graph);
+                if (out)
+                    formalOuts.emplace(out, graph);
+            });
+        }
+    }
+
+    // the formal inputs of 'graph' that 'out' depends on
+    // (using the summaries of called procedures computed so far)
+    std::set<NodeT *> summarize(DGT *graph, NodeT *out) const
+    {
+        std::set<NodeT *> result;
+        std::unordered_set<NodeT *> visited{out};
+        std::vector<NodeT *> stack{out};
+
+        auto push = [&visited, &stack](NodeT *m) {
+            if (visited.insert(m).second)
+                stack.push_back(m);
+        };
+
+        while (!stack.empty()) {
+            NodeT *n = stack.back();
+            stack.pop_back();
+
+            if (isFormalIn(n))
+                result.insert(n);
+
+            forEachPredecessor(n, [&](NodeT *m) {
+                if (getGraph(m) == graph) {
+                    push(m);
+                    return;
+                }
+
+                // from the callee at a call-site in this graph
+                // go through the summary edges. Other edges between
+                // procedures are not summarized
+                if (NodeT *cs = getDescendingCallSite(m, n)) {
+                    forEachSummaryActual(cs, m, push);
+                }
+            });
+        }
+
+        return result;
+    }
+
+public:
+    ///
+    // Call 'func' on every node that 'n' depends on, that is, on every
+    // node that the backward slicing reaches from 'n' in one step.
+    template <typename FuncT>
+    static void forEachPredecessor(NodeT *n, FuncT func)
+    {
+        for (auto I = n->rev_control_begin(), E = n->rev_control_end(); I != E; ++I)
+            func(*I);
+        for (auto I = n->rev_data_begin(), E = n->rev_data_end(); I != E; ++I)
+            func(*I);
+        for (auto I = n->user_begin(), E = n->user_end(); I != E; ++I)
+            func(*I);
+        for (auto I = n->interference_begin(), E = n->interference_end(); I != E; ++I)
+            func(*I);
+        for (auto I = n->rev_interference_begin(), E = n->rev_interference_end(); I != E; ++I)
+            func(*I);
+
+#ifdef ENABLE_CFG
+        // control dependencies of blocks
+        if (BBlock<NodeT> *BB = n->getBBlock()) {
+            for (BBlock<NodeT> *CD : BB->revControlDependence())
+                func(CD->getLastNode());
+        }
+#endif
+
+        // if we keep a node of a procedure, we keep the procedure
+        if (DGT *dg = n->getDG()) {
+            if (NodeT *entry = dg->getEntry())
+                func(entry);
+        }
+    }
+
+    void compute(DGT *entry)
+    {
+        assert(entry && "Need the entry graph");
+        gatherGraphs(entry);
+
+        // compute the summaries until a fixpoint
+        // (we need more iterations only with recursive procedures)
+        std::vector<DGT *> queue(graphs.rbegin(), graphs.rend());
+        std::unordered_set<DGT *> queued(graphs.begin(), graphs.end());
+        while (!queue.empty()) {
+            DGT *graph = queue.back();
+            queue.pop_back();
+            queued.erase(graph);
+
+            bool changed = false;
+            std::set<NodeT *> outs;
+            add(outs, graph->getExit());
+            forEachParameter(graph->getParameters(),
+                             [&outs](NodeT *, NodeT *out) { add(outs, out); });
+
+            for (NodeT *out : outs) {
+                auto ins = summarize(graph, out);
+                auto& cur = summaries[out];
+                if (ins.size() != cur.size()) {
+                    edgesNum += ins.size() - cur.size();
+                    cur.swap(ins);
+                    changed = true;
+                }
+            }
+
+            if (!changed)
+                continue;
+
+            for (DGT *caller : callers[graph]) {
+                if (queued.insert(caller).second)
+                    queue.push_back(caller);
+            }
+        }
+    }
+
+    bool isFormalIn(NodeT *n) const { return formalIns.count(n) > 0; }
+    bool isFormalOut(NodeT *n) const { return formalOuts.count(n) > 0; }
+
+    // the procedure of the node
+    DGT *getGraph(NodeT *n) const
+    {
+        if (DGT *dg = n->getDG())
+            return dg;
+
+        auto it = formalOuts.find(n);
+        if (it != formalOuts.end())
+            return it->second;
+        it = formalIns.find(n);
+        if (it != formalIns.end())
+            return it->second;
+
+        NodeT *cs = getCallSite(n);
+        return cs ? cs->getDG() : nullptr;
+    }
+
+    // the call-site to which the actual parameter belongs
+    // (or the node itself if it is a call node)
+    NodeT *getCallSite(NodeT *n) const
+    {
+        auto it = callSites.find(n);
+        return it == callSites.end() ? nullptr : it->second;
+    }
+
+    // If the edge from 'from' to 'to' leads from a formal output
+    // of a procedure to the call-site of the procedure,
+    // return the call-site. The use of the called function
+    // (its entry node) by the call is also such an edge
+    // (there are no summary edges for it though).
+    NodeT *getDescendingCallSite(NodeT *from, NodeT *to) const
+    {
+        DGT *callee = getGraph(from);
+        if (!callee || callee == getGraph(to))
+            return nullptr;
+        if (!isFormalOut(from) && from != callee->getEntry())
+            return nullptr;
+
+        NodeT *cs = getCallSite(to);
+        if (cs && cs->getSubgraphs().count(callee) > 0)
+            return cs;
+        return nullptr;
+    }
+
+    // Is the edge from 'from' to 'to' leading from a call-site
+    // to a formal input of a called procedure?
+    bool isAscending(NodeT *from, NodeT *to) const
+    {
+        if (!isFormalIn(to))
+            return false;
+
+        DGT *callee = getGraph(to);
+        if (callee == getGraph(from))
+            return false;
+
+        NodeT *cs = getCallSite(from);
+        return cs && cs->getSubgraphs().count(callee) > 0;
+    }
+
+    // the formal inputs that the formal output 'out' depends on
+    const std::set<NodeT *> *getSummary(NodeT *out) const
+    {
+        auto it = summaries.find(out);
+        return it == summaries.end() ? nullptr : &it->second;
+    }
+
+    // Call 'func' on the actual inputs of the call-site 'cs' that
+    // correspond to the formal inputs that 'out' depends on
+    template <typename FuncT>
+    void forEachSummaryActual(NodeT *cs, NodeT *out, FuncT func) const
+    {
+        const auto *ins = getSummary(out);
+        if (!ins)
+            return;
+
+        for (NodeT *in : *ins) {
+            forEachPredecessor(in, [this, cs, &func](NodeT *m) {
+                if (getCallSite(m) == cs)
+                    func(m);
+            });
+        }
+    }
+
+    size_t size() const { return edgesNum; }
+};
+
+} // namespace analysis
+} // namespace dg
+
+#endif // _DG_SUMMARY_EDGES_H_
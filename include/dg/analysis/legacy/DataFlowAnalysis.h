@@ -3,9 +3,11 @@
 
 #include <utility>
 #include <set>
+#include <string>
 
 #include "dg/analysis/legacy/Analysis.h"
 #include "dg/analysis/legacy/DFS.h"
+#include "dg/util/Trace.h"
 
 #ifndef ENABLE_CFG
 #error "Need CFG enabled for data flow analysis"
@@ -67,7 +69,10 @@ public:
         DFSDataT data(blocks, changed, this);
 
         // we will get all the nodes using DFS
-        DFS.run(entryBB, dfs_proc_bb, data);
+        {
+            DG_TRACE_SCOPE("DataFlowAnalysis::iteration");
+            DFS.run(entryBB, dfs_proc_bb, data);
+        }
 
         // update statistics
         statistics.bblocksNum = blocks.size();
@@ -81,6 +86,8 @@ public:
         // Since we used while loop, if nothing changed after the
         // first iteration (the DFS), the loop will never run
         while (changed) {
+            DG_TRACE_SCOPE_DETAIL("DataFlowAnalysis::iteration",
+                                  std::to_string(blocks.size()) + " blocks");
             changed = false;
             for (auto I = blocks.rbegin(), E = blocks.rend();
                  I != E; ++I) {
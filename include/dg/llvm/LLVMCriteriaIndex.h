@@ -0,0 +1,104 @@
+#ifndef _DG_LLVM_CRITERIA_INDEX_H_
+#define _DG_LLVM_CRITERIA_INDEX_H_
+
+#ifndef HAVE_LLVM
+#error "Need LLVM"
+#endif
+
+#include <functional>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace llvm {
+    class Value;
+    class Function;
+    class CallInst;
+    class Instruction;
+} // namespace llvm
+
+namespace dg {
+
+///
+// Index of the things that the slicing criteria refer to:
+// the call-sites of functions (by the name of the called function),
+// the instructions on lines of the source code and the values
+// that hold the C variables (from the debugging information).
+// It is built once from all the functions of the graph,
+// so that resolving the criteria does not need to go through
+// the whole graph for every criterion.
+//
+// The index refers to the instructions, the graph maps them to the nodes
+// (and builds the graphs of the functions if it is built lazily).
+// It must be built again (or dropped) when the instructions are removed,
+// e.g., by slicing.
+class LLVMCriteriaIndex
+{
+public:
+    using ValuesT = std::vector<llvm::Value *>;
+    using InstructionsT = std::vector<llvm::Instruction *>;
+    // the defined functions that the call may call
+    using CalleesT = std::vector<const llvm::Function *>;
+    using GetCalleesT = std::function<void(llvm::CallInst *, CalleesT&)>;
+
+    void build(const std::vector<llvm::Function *>& functions,
+               const GetCalleesT& getCallees);
+
+    // call-sites of the function. These are the direct calls
+    // and the calls via function pointers that were resolved
+    // to the function (the calls that have its subgraph)
+    const ValuesT& getCallSites(const std::string& name) const
+    {
+        return find(callSites, name);
+    }
+
+    // the instructions with the debugging location on the line.
+    // If 'file' is not empty, only the lines in the files
+    // whose path ends with 'file' are taken.
+    InstructionsT getInstructionsOnLine(unsigned line,
+                                        const std::string& file = "") const;
+
+    // name of the C variable that the value holds (or nullptr)
+    const std::string *getVariableName(const llvm::Value *val) const
+    {
+        auto it = variableNames.find(val);
+        return it == variableNames.end() ? nullptr : &it->second.first;
+    }
+
+    // the values that hold the C variable
+    const ValuesT& getVariableValues(const std::string& name) const
+    {
+        return find(variables, name);
+    }
+
+    bool hasDebugInfo() const { return !variableNames.empty(); }
+
+private:
+    struct LineEntry {
+        const std::string *file;
+        llvm::Instruction *inst;
+    };
+
+    std::unordered_map<std::string, ValuesT> callSites;
+    std::unordered_map<unsigned, std::vector<LineEntry>> lines;
+    // the name of the variable and the value (if it has a node)
+    std::unordered_map<const llvm::Value *,
+                       std::pair<std::string, llvm::Value *>> variableNames;
+    std::unordered_map<std::string, ValuesT> variables;
+    // the names of the files of the lines
+    std::set<std::string> files;
+
+    static const ValuesT& find(const std::unordered_map<std::string, ValuesT>& map,
+                               const std::string& name)
+    {
+        static const ValuesT empty;
+        auto it = map.find(name);
+        return it == map.end() ? empty : it->second;
+    }
+};
+
+} // namespace dg
+
+#endif // _DG_LLVM_CRITERIA_INDEX_H_
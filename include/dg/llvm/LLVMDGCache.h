@@ -0,0 +1,79 @@
+#ifndef _DG_LLVM_DG_CACHE_H_
+#define _DG_LLVM_DG_CACHE_H_
+
+#ifndef HAVE_LLVM
+#error "Need LLVM"
+#endif
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "dg/llvm/LLVMDependenceGraph.h"
+
+namespace llvm {
+    class Module;
+} // namespace llvm
+
+namespace dg {
+
+///
+// Store a built dependence graph (with the subgraphs of all functions
+// and all the dependence edges) into a file and load it back
+// without running the analyses again.
+//
+// The file is a fixed header followed by a flat array of 32-bit words
+// (in the byte order of the machine), so it can be read directly
+// from a memory-mapped file. The nodes refer to the values of the module
+// by their position in the module (globals, functions and then the
+// arguments, blocks and instructions of every function), so the file
+// can be used only with the same module. This is guarded by a hash
+// of the module and of the configuration the graph was built with.
+//
+// The loaded graph is ready for slicing (the dependencies are
+// computed), but it has no pointer analysis and reaching definitions
+// (getPTA() and getRDA() return nullptr).
+class LLVMDGCache
+{
+public:
+    // version of the format of the file
+    static const uint32_t VERSION = 1;
+
+    // hash of the module and of the string that describes
+    // the configuration of the analyses
+    static uint64_t hash(const llvm::Module& M, const std::string& config);
+
+    // store the graph into the file. The graph must be built
+    // and its dependencies computed, but it must not be sliced yet.
+    static bool save(LLVMDependenceGraph *dg, uint64_t hash,
+                     const std::string& file);
+
+    // load the graph of the module from the file.
+    // Return nullptr if the file does not exist, is corrupted
+    // or it was created for a different module or configuration.
+    static std::unique_ptr<LLVMDependenceGraph>
+    load(llvm::Module *M, uint64_t hash, const std::string& file);
+
+private:
+    class Writer;
+    class Reader;
+
+    // access to the private members of the graph for Writer and Reader
+    static std::unique_ptr<LLVMBBlock>& unifiedExitBB(LLVMDependenceGraph *dg)
+    {
+        return dg->unifiedExitBB;
+    }
+
+    static void setModule(LLVMDependenceGraph *dg, llvm::Module *M,
+                          llvm::Function *entry)
+    {
+        dg->module = M;
+        dg->entryFunction = entry;
+        dg->PTA = nullptr;
+        dg->RDA = nullptr;
+    }
+};
+
+} // namespace dg
+
+#endif // _DG_LLVM_DG_CACHE_H_
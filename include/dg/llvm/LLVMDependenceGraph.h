@@ -10,7 +10,10 @@
 #endif
 
 #include <map>
+#include <memory>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #include "dg/llvm/analysis/ThreadRegions/ControlFlowGraph.h"
 
@@ -20,9 +23,11 @@ namespace llvm {
     class Module;
     class Value;
     class Function;
+    class CallInst;
 } // namespace llvm
 
 #include "dg/llvm/LLVMNode.h"
+#include "dg/llvm/LLVMCriteriaIndex.h"
 #include "dg/DependenceGraph.h"
 #include "dg/analysis/ControlExpression/ControlExpression.h"
 
@@ -80,6 +85,45 @@ public:
     // build subgraphs of called functions
     bool build(llvm::Function *func);
 
+    // Number of threads that create the nodes and blocks of functions
+    // when building the graph from a module (0 means the number of cores).
+    // The nodes of all reachable functions are created in parallel
+    // first and the graphs are connected (call-sites, parameters)
+    // serially afterwards. The resulting graph is the same.
+    // The same number of threads computes the post-dominators
+    // and control dependencies of the functions.
+    void setBuildThreads(unsigned num) { buildThreads = num; }
+
+    // Build the graph lazily: build(llvm::Module *) builds only the graph
+    // of the entry function and the graphs of the other functions
+    // are built by getOrBuildFunction() when they are needed.
+    // The call-sites of a graph are connected to the graphs
+    // of the called functions by connectCallSites().
+    void setLazy(bool lazy) { this->lazy = lazy; }
+    bool isLazy() const { return lazy; }
+
+    // the graph of the function (nullptr if the function is not
+    // reachable from the entry). If the graph is lazy and the graph
+    // of the function is not built yet, build it
+    LLVMDependenceGraph *getOrBuildFunction(llvm::Function *func);
+    // the node of the value, the graph of the function
+    // of an instruction is built if needed (see getOrBuildFunction())
+    LLVMNode *getOrBuildNode(llvm::Value *val);
+    // the graphs of the functions that may call the function
+    // of this graph (lazy graph only)
+    std::vector<LLVMDependenceGraph *> getCallerGraphs();
+    // connect the call-sites of this graph to the graphs of the called
+    // functions (lazy graph only). Return false if they are connected already
+    bool connectCallSites();
+    // the functions reachable from the entry whose graphs
+    // were not built (lazy graph only), in the order of the module
+    std::vector<llvm::Function *> getUnbuiltFunctions() const;
+
+    // time (in microseconds) spent by computing post-dominators
+    // and control dependencies of every function
+    const std::vector<std::pair<const llvm::Function *, uint64_t>>&
+    getControlDependenceTimes() const { return cdTimes; }
+
     LLVMDGParameters *getOrCreateParameters();
     LLVMNode *getOrCreateNoReturn();
     LLVMNode *getOrCreateNoReturn(LLVMNode *call);
@@ -113,6 +157,14 @@ public:
     bool getCallSites(const char *names[], std::set<LLVMNode *> *callsites);
     bool getCallSites(const std::vector<std::string>& names, std::set<LLVMNode *> *callsites);
 
+    // the index of the call-sites, lines and variables of all
+    // the constructed functions. It is built by build(llvm::Module *)
+    // and it is dropped when the graph is sliced (then it returns nullptr
+    // and getCallSites() goes through the graph).
+    const LLVMCriteriaIndex *getCriteriaIndex() const { return criteriaIndex.get(); }
+    void buildCriteriaIndex();
+    void dropCriteriaIndex() { criteriaIndex.reset(); }
+
     // FIXME we need remove the callsite from here if we slice away
     // the callsite
     const std::set<LLVMNode *>& getCallNodes() const { return callNodes; }
@@ -122,11 +174,12 @@ public:
     // build subgraph for a call node
     LLVMDependenceGraph *buildSubgraph(LLVMNode *node);
     LLVMDependenceGraph *buildSubgraph(LLVMNode *node, llvm::Function *, bool fork = false);
-    void addSubgraphGlobalParameters(LLVMDependenceGraph *subgraph);
 
     void makeSelfLoopsControlDependent();
     void addNoreturnDependencies(LLVMNode *noret, LLVMBBlock *from);
     void addNoreturnDependencies();
+    // the same as above, but only for the nodes of this graph
+    void addFunctionNoreturnDependencies();
 
     void computeControlDependencies(CD_ALG alg_type, bool terminSensitive = true)
     {
@@ -141,6 +194,15 @@ public:
             abort();
     }
 
+    // compute the control dependencies (by the classic algorithm)
+    // of this graph only, used when the graph is built lazily
+    void computeFunctionControlDependencies(bool terminSensitive = true)
+    {
+        computeFunctionPostDominators(true);
+        if (terminSensitive)
+            addFunctionNoreturnDependencies();
+    }
+
     bool verify() const;
 
     void setThreads(bool threads);
@@ -166,6 +228,8 @@ public:
     void computeCriticalSections(ControlFlowGraph * controlFlowGraph);
 private:
     void computePostDominators(bool addPostDomFrontiers = false);
+    // post-dominators of this graph only
+    void computeFunctionPostDominators(bool addPostDomFrontiers = false);
     void computeControlExpression(bool addCDs = false);
 
     void computeInterferenceDependentEdges(const std::set<const llvm::Instruction *> &loads,
@@ -177,10 +241,32 @@ private:
     std::set<const llvm::Instruction *> getInstructionsOfType(const unsigned opCode,
                                                               const std::set<const llvm::Instruction *> &llvmInstructions) const;
 
+    // create the graph of the function that shares the global nodes
+    // and the analyses with this graph and build it
+    LLVMDependenceGraph *createSubgraph(llvm::Function *func);
+    // add the call-site edges and parameters between the call node
+    // and the graph of the called function
+    void connectSubgraph(LLVMNode *node, LLVMDependenceGraph *subgraph,
+                         llvm::Function *callFunc, bool fork);
+
     // add formal parameters of the function to the graph
     // (graph is a graph of one procedure)
     void addFormalParameters();
 
+    // the functions that the call may call (with the flag whether
+    // the call is a fork of a thread) -- the functions whose subgraphs
+    // are built for the call-site
+    void getCallees(llvm::CallInst *CInst,
+                    std::vector<std::pair<llvm::Function *, bool>>& callees) const;
+
+    // find out which globals and heap objects the functions reachable
+    // from 'entry' need as formal parameters (a mod/ref analysis
+    // over the call graph), so that each graph gets all its formal
+    // parameters once, before the call-sites are connected to it
+    void computeFormalGlobals(llvm::Function *entry);
+    // add the formal parameters computed by computeFormalGlobals()
+    void addFormalGlobals(llvm::Function *func);
+
     // take action specific to given instruction (while building
     // the graph). This is like if the value is a call-site,
     // then build subgraph or similar
@@ -190,7 +276,18 @@ private:
     // That includes creating all the nodes and adding them
     // to this graph and creating the basic block and
     // setting first and last instructions
-    LLVMBBlock *build(llvm::BasicBlock& BB);
+    LLVMBBlock *createBBlock(llvm::BasicBlock& BB);
+
+    // create all the nodes and blocks of the function and the CFG edges
+    // between the blocks. This touches only this graph, so it can
+    // run in parallel for more graphs.
+    void buildBlocks(llvm::Function *func);
+    void buildBlocksInParallel();
+
+    // take instruction specific actions for the nodes of the block
+    // (build subgraphs, add parameters, ...) and connect the block
+    // to the exit block if it returns from the function
+    void build(llvm::BasicBlock& llvmBB, LLVMBBlock *BB);
 
     // gather call-sites of functions with given name
     // when building the graph
@@ -198,6 +295,11 @@ private:
     const char *gather_callsites;
 
     bool threads{false};
+    unsigned buildThreads{1};
+    bool lazy{false};
+    // the call-sites were connected by connectCallSites()
+    bool callSitesConnected{false};
+    std::vector<std::pair<const llvm::Function *, uint64_t>> cdTimes;
 
     // all callnodes in this graph - forming call graph
     std::set<LLVMNode *> callNodes;
@@ -215,8 +317,18 @@ private:
     // control expression for this graph
     ControlExpression CE;
 
+    std::unique_ptr<LLVMCriteriaIndex> criteriaIndex;
+
+    // the state of building the graph from a module. It is created
+    // by the graph of the entry function and shared with the graphs
+    // of the other functions (like the global nodes)
+    struct BuildState;
+    std::shared_ptr<BuildState> buildState;
+
     // verifier needs access to private elements
     friend class LLVMDGVerifier;
+    // and so does the (de)serialization of the graph
+    friend class LLVMDGCache;
 };
 
 const std::map<llvm::Value *,
@@ -37,6 +37,7 @@
 #include "dg/analysis/Offset.h"
 
 #include "dg/llvm/analysis/ThreadRegions/ControlFlowGraph.h"
+#include "dg/util/TimeReport.h"
 
 namespace llvm {
     class Module;
@@ -62,6 +63,16 @@ struct LLVMDependenceGraphOptions {
 
     bool threads{false};
 
+    // number of threads used to create the nodes of functions
+    // (0 means the number of cores)
+    unsigned buildThreads{1};
+
+    // Build the graphs of functions and compute their dependencies
+    // only when the slicing reaches them (constructCFGOnly() and
+    // computeDependencies() only, see computeFunctionDependencies()).
+    // Used only with the classic control dependencies and without threads.
+    bool lazy{false};
+
     std::string entryFunction{"main"};
 
     void addAllocationFunction(const std::string& name,
@@ -80,10 +91,14 @@ class LLVMDependenceGraphBuilder {
     std::unique_ptr<LLVMDependenceGraph> _dg{};
     std::unique_ptr<ControlFlowGraph> _controlFlowGraph{};
     llvm::Function *_entryFunction{nullptr};
+    // the phases are measured only if the report is set
+    util::TimeReport *_timeReport{nullptr};
 
     void _runPointerAnalysis() {
         assert(_PTA && "BUG: No PTA");
 
+        util::TimeReport::Scope phase(_timeReport, "pointer analysis");
+
         if (_options.PTAOptions.isFS())
             _PTA->run<analysis::pta::PointerAnalysisFS>();
         else if (_options.PTAOptions.isFI())
@@ -94,22 +109,60 @@ class LLVMDependenceGraphBuilder {
             assert(0 && "Wrong pointer analysis");
             abort();
         }
+
+        if (_timeReport) {
+            _timeReport->setCounter("nodes", _PTA->getPS()->size());
+            _timeReport->setCounter("iterations", _PTA->getIterationsNum());
+            _timeReport->setCounter("processed nodes",
+                                    _PTA->getProcessedNodesNum());
+        }
     }
 
     void _runReachingDefinitionsAnalysis() {
         assert(_RD && "BUG: No RD");
 
+        util::TimeReport::Scope phase(_timeReport, "reaching definitions");
+
         if (_options.RDAOptions.isDense()) {
             _RD->run<dg::analysis::rd::ReachingDefinitionsAnalysis>();
         } else if (_options.RDAOptions.isSparse()) {
             _RD->run<dg::analysis::rd::SemisparseRda>();
+        } else if (_options.RDAOptions.isDemandDriven()) {
+            _RD->run<dg::analysis::rd::DemandDrivenRda>();
+        } else if (_options.RDAOptions.isMemorySSA()) {
+            _RD->run<dg::analysis::rd::MemorySsaRda>();
         } else {
             assert( false && "unknown RDA type" );
             abort();
         }
+
+        if (_timeReport) {
+            _timeReport->setCounter("nodes", _RD->getNodesMap().size());
+            _timeReport->setCounter("iterations", _RD->getIterationsNum());
+            _timeReport->setCounter("processed nodes",
+                                    _RD->getProcessedNodesNum());
+        }
+    }
+
+    void _buildGraph() {
+        util::TimeReport::Scope phase(_timeReport, "graph construction");
+
+        _dg->build(_M, _PTA.get(), _RD.get(), _entryFunction);
+
+        if (_timeReport) {
+            const auto& functions = getConstructedFunctions();
+            uint64_t nodes = 0;
+            for (const auto& it : functions)
+                nodes += it.second->size();
+
+            _timeReport->setCounter("functions", functions.size());
+            _timeReport->setCounter("nodes", nodes);
+        }
     }
 
     void _runDefUseAnalysis() {
+        util::TimeReport::Scope phase(_timeReport, "def-use analysis");
+
         LLVMDefUseAnalysis DUA(_dg.get(),
                                _RD.get(),
                                _PTA.get(),
@@ -117,20 +170,47 @@ class LLVMDependenceGraphBuilder {
         DUA.run(); // add def-use edges according that
     }
 
+    // the dependencies of one function of the lazy graph
+    // (nothing if they were computed already)
+    void _computeFunctionDependencies(LLVMDependenceGraph *graph) {
+        if (!graph->connectCallSites())
+            return;
+
+        if (_timeReport)
+            _timeReport->addCounter("functions");
+
+        LLVMDefUseAnalysis DUA(graph,
+                               _RD.get(),
+                               _PTA.get(),
+                               _options.DUOptions,
+                               false /* interprocedural */);
+        DUA.run();
+
+        graph->computeFunctionControlDependencies(_options.terminationSensitive);
+    }
+
     void _runControlDependenceAnalysis() {
+        util::TimeReport::Scope phase(_timeReport, "control dependencies");
+
         _dg->computeControlDependencies(_options.cdAlgorithm,
                                         _options.terminationSensitive);
     }
 
     void _runInterferenceDependenceAnalysis() {
+        util::TimeReport::Scope phase(_timeReport, "interference dependencies");
+
         _dg->computeInterferenceDependentEdges(_controlFlowGraph.get());
     }
 
     void _runForkJoinAnalysis() {
+        util::TimeReport::Scope phase(_timeReport, "fork-join dependencies");
+
         _dg->computeForkJoinDependencies(_controlFlowGraph.get());
     }
 
     void _runCriticalSectionAnalysis() {
+        util::TimeReport::Scope phase(_timeReport, "critical sections");
+
         _dg->computeCriticalSections(_controlFlowGraph.get());
     }
 
@@ -138,6 +218,11 @@ class LLVMDependenceGraphBuilder {
         return _dg->verify();
     }
 
+    bool _verifyGraph() {
+        util::TimeReport::Scope phase(_timeReport, "verification");
+        return _dg->verify();
+    }
+
 public:
     LLVMDependenceGraphBuilder(llvm::Module *M)
     : LLVMDependenceGraphBuilder(M, {}) {}
@@ -152,11 +237,19 @@ public:
       _controlFlowGraph(new ControlFlowGraph(_PTA.get())),
       _entryFunction(M->getFunction(_options.entryFunction)) {
         assert(_entryFunction && "The entry function not found");
+        _dg->setBuildThreads(_options.buildThreads);
     }
 
     LLVMPointerAnalysis *getPTA() { return _PTA.get(); }
     LLVMReachingDefinitions *getRDA() { return _RD.get(); }
 
+    // Measure the phases of building the graph into the report
+    // (the wall and CPU time, memory and the statistics of the analyses
+    // like the number of iterations). The report is not owned
+    // by the builder, nullptr turns the measuring off.
+    void setTimeReport(util::TimeReport *report) { _timeReport = report; }
+    util::TimeReport *getTimeReport() const { return _timeReport; }
+
     // construct the whole graph with all edges
     std::unique_ptr<LLVMDependenceGraph>&& build() {
         // compute data dependencies
@@ -168,7 +261,7 @@ public:
         }
 
         // build the graph itself
-        _dg->build(_M, _PTA.get(), _RD.get(), _entryFunction);
+        _buildGraph();
 
         // insert the data dependencies edges
         _runDefUseAnalysis();
@@ -184,7 +277,7 @@ public:
         }
 
         // verify if the graph is built correctly
-        if (_options.verifyGraph && !_dg->verify()) {
+        if (_options.verifyGraph && !_verifyGraph()) {
             _dg.reset();
             return std::move(_dg);
         }
@@ -206,15 +299,18 @@ public:
             _dg->setThreads(false);
         }
 
+        _dg->setLazy(_options.lazy && !_options.threads &&
+                     _options.cdAlgorithm == CD_ALG::CLASSIC);
+
         // build the graph itself
-        _dg->build(_M, _PTA.get(), _RD.get(), _entryFunction);
+        _buildGraph();
 
         if (_options.threads) {
             _controlFlowGraph->buildFunction(_entryFunction);
         }
 
         // verify if the graph is built correctly
-        if (_options.verifyGraph && !_dg->verify()) {
+        if (_options.verifyGraph && !_verifyGraph()) {
             _dg.reset();
             return std::move(_dg);
         }
@@ -234,6 +330,11 @@ public:
 
         // data-dependence edges
         _runReachingDefinitionsAnalysis();
+
+        // the rest is computed for every function separately
+        if (_dg->isLazy())
+            return std::move(_dg);
+
         _runDefUseAnalysis();
 
         // fill-in control dependencies
@@ -248,6 +349,22 @@ public:
         return std::move(_dg);
     }
 
+    // Compute the dependencies of the graph of a function built lazily
+    // (see LLVMDependenceGraphOptions::lazy): connect its call-sites
+    // to the called functions and add its def-use edges and control
+    // dependencies. Do the same for the functions that call it,
+    // then all the edges that lead to the nodes of the graph are there.
+    // This must be called before the edges of the nodes of the graph
+    // are followed the first time.
+    void computeFunctionDependencies(LLVMDependenceGraph *graph) {
+        assert(graph->isLazy() && "The graph is not lazy");
+
+        util::TimeReport::Scope phase(_timeReport, "function dependencies");
+        _computeFunctionDependencies(graph);
+        for (LLVMDependenceGraph *caller : graph->getCallerGraphs())
+            _computeFunctionDependencies(caller);
+    }
+
 };
 
 } // namespace llvmdg
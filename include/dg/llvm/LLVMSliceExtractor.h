@@ -0,0 +1,83 @@
+#ifndef _DG_LLVM_SLICE_EXTRACTOR_H_
+#define _DG_LLVM_SLICE_EXTRACTOR_H_
+
+#ifndef HAVE_LLVM
+#error "Need LLVM"
+#endif
+
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// ignore unused parameters in LLVM libraries
+#if (__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-parameter"
+#else
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+
+#include <llvm/ADT/SmallVector.h>
+
+#if (__clang__)
+#pragma clang diagnostic pop // ignore -Wunused-parameter
+#else
+#pragma GCC diagnostic pop
+#endif
+
+#include "dg/analysis/Slicing.h"
+#include "dg/llvm/LLVMDependenceGraph.h"
+
+namespace llvm {
+    class LLVMContext;
+    class Module;
+} // namespace llvm
+
+namespace dg {
+
+///
+// Create the sliced module as a pruned copy of the original module.
+// The slice is given by a SliceSet (see ReadOnlyWalkAndMark), neither
+// the dependence graph nor the original module are changed, so more slices
+// can be extracted from one graph at once, each in its own thread
+// and LLVMContext (the copy of the module is created from the bitcode
+// of the original module stored in the constructor).
+// The copy is sliced the same way as LLVMSlicer slices the original module.
+class LLVMSliceExtractor
+{
+public:
+    // the graph must be built and its dependencies computed
+    LLVMSliceExtractor(LLVMDependenceGraph *dg);
+
+    // do not slice the bodies of this function
+    void keepFunctionUntouched(const std::string& name)
+    {
+        dontTouch.insert(name);
+    }
+
+    // return the sliced copy of the module created in the context 'ctx',
+    // or nullptr on error. This method can run in more threads at once
+    // (with different contexts).
+    std::unique_ptr<llvm::Module>
+    extract(const analysis::SliceSet<LLVMNode>& slice, llvm::LLVMContext& ctx,
+            analysis::SlicerStatistics *statistics = nullptr) const;
+
+    // return an unsliced copy of the module created in the context 'ctx'
+    std::unique_ptr<llvm::Module> copy(llvm::LLVMContext& ctx) const;
+
+private:
+    class Pruner;
+
+    std::string moduleId;
+    llvm::SmallVector<char, 0> bitcode;
+    // the position of the functions, blocks and instructions in the module
+    std::unordered_map<const llvm::Value *, unsigned> positions;
+    std::set<std::string> dontTouch;
+};
+
+} // namespace dg
+
+#endif // _DG_LLVM_SLICE_EXTRACTOR_H_
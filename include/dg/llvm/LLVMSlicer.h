@@ -10,6 +10,10 @@
 #pragma GCC diagnostic ignored "-Wunused-parameter"
 #endif
 
+#include <set>
+#include <unordered_set>
+#include <vector>
+
 #include <llvm/Config/llvm-config.h>
 #if ((LLVM_VERSION_MAJOR == 3) && (LLVM_VERSION_MINOR < 5))
  #include <llvm/Support/CFG.h>
@@ -33,6 +37,7 @@
 #include "dg/analysis/Slicing.h"
 #include "dg/llvm/LLVMDependenceGraph.h"
 #include "dg/llvm/LLVMNode.h"
+#include "dg/util/Trace.h"
 
 namespace dg {
 
@@ -133,14 +138,20 @@ public:
         return 0;
     }
 
-    uint32_t slice(LLVMDependenceGraph *,
+    uint32_t slice(LLVMDependenceGraph *dg,
                    LLVMNode *start, uint32_t sl_id = 0)
     {
+        DG_TRACE_SCOPE("LLVMSlicer::slice");
+
         // mark nodes for slicing
         assert(start || sl_id != 0);
         if (start)
             sl_id = mark(start, sl_id);
 
+        // the index refers to the nodes that we are going to remove
+        if (dg)
+            dg->dropCriteriaIndex();
+
         // take every subgraph and slice it intraprocedurally
         // this includes the main graph
         extern std::map<const llvm::Value *,
@@ -149,10 +160,21 @@ public:
             if (dontTouch(it.first->getName()))
                 continue;
 
+            DG_TRACE_SCOPE_DETAIL("LLVMSlicer::sliceGraph",
+                                  it.first->getName().str());
             LLVMDependenceGraph *subdg = it.second;
             sliceGraph(subdg, sl_id);
         }
 
+        // the lazy graph did not need the graphs of these functions,
+        // so nothing from them is in the slice
+        if (dg) {
+            for (llvm::Function *F : dg->getUnbuiltFunctions()) {
+                if (!dontTouch(F->getName()))
+                    sliceUnbuiltFunction(F);
+            }
+        }
+
         return sl_id;
     }
 
@@ -182,6 +204,9 @@ private:
     }
         */
 
+public:
+    // these are used also when slicing a copy of the module
+    // (see LLVMSliceExtractor)
     static void
     adjustPhiNodes(llvm::BasicBlock *pred, llvm::BasicBlock *blk)
     {
@@ -229,6 +254,43 @@ private:
         }
     }
 
+    // Erase the instructions at once. All their references are dropped
+    // first, so the uses among them need not be replaced. The uses by the
+    // instructions that stay are replaced by undef (as in removeNode()).
+    static void eraseInstructions(const std::vector<llvm::Instruction *>& insts)
+    {
+        for (llvm::Instruction *I : insts)
+            I->dropAllReferences();
+
+        for (llvm::Instruction *I : insts)
+            I->replaceAllUsesWith(llvm::UndefValue::get(I->getType()));
+
+        for (auto it = insts.rbegin(), et = insts.rend(); it != et; ++it)
+            (*it)->eraseFromParent();
+    }
+
+    // Erase the blocks at once, like removeBlock() does for one block.
+    // The phi nodes of the successors must be already adjusted.
+    static void eraseBlocks(const std::vector<llvm::BasicBlock *>& blks)
+    {
+        for (llvm::BasicBlock *blk : blks) {
+            for (llvm::Instruction& Inst : *blk)
+                Inst.dropAllReferences();
+        }
+
+        // drop the references from the instructions that stay,
+        // see removeBlock()
+        for (llvm::BasicBlock *blk : blks) {
+            dropAllUses(blk);
+            for (llvm::Instruction& Inst : *blk)
+                dropAllUses(&Inst);
+        }
+
+        for (auto it = blks.rbegin(), et = blks.rend(); it != et; ++it)
+            (*it)->eraseFromParent();
+    }
+
+private:
     static LLVMBBlock *
     createNewExitBB(LLVMDependenceGraph *graph)
     {
@@ -431,20 +493,86 @@ private:
         }
     }
 
+    // Remove the blocks that are not in the slice (like sliceBBlocks()),
+    // but erase them at once and only gather their nodes into 'removed'
+    void removeBlocks(LLVMDependenceGraph *graph, uint32_t slice_id,
+                      std::vector<LLVMNode *>& removed)
+    {
+        std::set<LLVMBBlock *> blocks;
+        for (auto& it : graph->getBlocks()) {
+            if (it.second->getSlice() != slice_id)
+                blocks.insert(it.second);
+        }
+
+        std::vector<llvm::BasicBlock *> blks;
+        for (LLVMBBlock *block : blocks) {
+            statistics.nodesRemoved += block->size();
+            statistics.nodesTotal += block->size();
+            ++statistics.blocksRemoved;
+
+            llvm::Value *val = block->getKey();
+            if (val == nullptr)
+                continue;
+
+            llvm::BasicBlock *blk = llvm::cast<llvm::BasicBlock>(val);
+            for (auto& succ : block->successors()) {
+                if (succ.label == 255 || succ.target == block)
+                    continue;
+
+                if (llvm::Value *sval = succ.target->getKey())
+                    adjustPhiNodes(llvm::cast<llvm::BasicBlock>(sval), blk);
+            }
+
+            blks.push_back(blk);
+        }
+
+        eraseBlocks(blks);
+
+        for (LLVMBBlock *block : blocks) {
+            for (LLVMNode *n : block->getNodes()) {
+                n->setBasicBlock(nullptr);
+                removed.push_back(n);
+            }
+
+            // the nodes are deleted later with the others
+            block->remove(false /* with nodes */);
+        }
+    }
+
+    // remove the body of the function (as sliceGraph() does
+    // with a graph that has no node in the slice)
+    void sliceUnbuiltFunction(llvm::Function *F)
+    {
+        std::vector<llvm::BasicBlock *> blks;
+        blks.reserve(F->size());
+        for (llvm::BasicBlock& B : *F) {
+            statistics.nodesRemoved += B.size();
+            statistics.nodesTotal += B.size();
+            ++statistics.blocksRemoved;
+            blks.push_back(&B);
+        }
+
+        eraseBlocks(blks);
+    }
+
     void sliceGraph(LLVMDependenceGraph *graph, uint32_t slice_id)
     {
+        // the nodes that are going away, we delete them all at once
+        // at the end, so that we do not update the edges among them
+        std::vector<LLVMNode *> removed;
+
         // first slice away bblocks that should go away
-        sliceBBlocks(graph, slice_id);
+        removeBlocks(graph, slice_id, removed);
+        std::unordered_set<const LLVMNode *> isRemoved(removed.begin(),
+                                                       removed.end());
 
         // make graph complete
         adjustBBlocksSucessors(graph, slice_id);
 
         // now slice away instructions from BBlocks that left
-        for (auto I = graph->begin(), E = graph->end(); I != E;) {
-            LLVMNode *n = I->second;
-            // shift here, so that we won't corrupt the iterator
-            // by deleteing the node
-            ++I;
+        std::vector<llvm::Instruction *> insts;
+        for (auto& it : *graph) {
+            LLVMNode *n = it.second;
 
             // we added this node artificially and
             // we don't want to slice it away or
@@ -452,6 +580,10 @@ private:
             if (n == graph->getExit())
                 continue;
 
+            // the node from a removed block
+            if (isRemoved.count(n) > 0)
+                continue;
+
             ++statistics.nodesTotal;
 
             // keep instructions like ret or unreachable
@@ -461,18 +593,23 @@ private:
             if (!shouldSliceInst(n->getKey()))
                 continue;
 
-            /*
-            if (llvm::isa<llvm::CallInst>(n->getKey()))
-                sliceCallNode(n, slice_id);
-                */
-
             if (n->getSlice() != slice_id) {
-                removeNode(n);
-                graph->deleteNode(n);
+                if (auto *Inst = llvm::dyn_cast<llvm::Instruction>(n->getKey()))
+                    insts.push_back(Inst);
+                else
+                    removeNode(n);
+
+                removed.push_back(n);
+                isRemoved.insert(n);
                 ++statistics.nodesRemoved;
             }
         }
 
+        eraseInstructions(insts);
+        graph->deleteNodes(removed, [&isRemoved](const LLVMNode *n) {
+            return isRemoved.count(n) > 0;
+        });
+
         // create new CFG edges between blocks after slicing
         reconnectLLLVMBasicBlocks(graph);
 
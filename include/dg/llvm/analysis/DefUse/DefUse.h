@@ -47,13 +47,18 @@ class LLVMDefUseAnalysis : public analysis::legacy::DataFlowAnalysis<LLVMNode>
     const analysis::LLVMDefUseAnalysisOptions _options;
 
 public:
+    // if 'interprocedural' is false, only the nodes of the graph 'dg'
+    // are processed (not the nodes of the called functions)
     LLVMDefUseAnalysis(LLVMDependenceGraph *dg,
                        LLVMReachingDefinitions *rd,
                        LLVMPointerAnalysis *pta,
-                       const analysis::LLVMDefUseAnalysisOptions& opts);
+                       const analysis::LLVMDefUseAnalysisOptions& opts,
+                       bool interprocedural = true);
 
     ~LLVMDefUseAnalysis() { delete DL; }
 
+    void run();
+
     /* virtual */
     bool runOnNode(LLVMNode *node, LLVMNode *prev);
 private:
@@ -72,9 +77,13 @@ private:
                            PSNode *pts, /* what memory */
                            uint64_t size);
 
-    void addDataDependence(LLVMNode *node, analysis::rd::RDNode *rd);
     void addDataDependence(LLVMNode *node, llvm::Value *val);
 
+    // get the node that corresponds to the definition
+    // (it may be in another graph)
+    LLVMNode *getDefinitionNode(analysis::rd::RDNode *rd);
+    LLVMNode *getDefinitionNode(llvm::Value *val);
+
     void addUnknownDataDependence(LLVMNode *node, PSNode *pts);
 
     void handleLoadInst(llvm::LoadInst *, LLVMNode *);
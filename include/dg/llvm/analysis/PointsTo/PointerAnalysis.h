@@ -29,6 +29,7 @@
 #include "dg/llvm/analysis/PointsTo/LLVMPointerAnalysisOptions.h"
 #include "dg/llvm/analysis/PointsTo/PointerSubgraph.h"
 #include "dg/llvm/analysis/PointsTo/LLVMPointsToSet.h"
+#include "dg/util/Trace.h"
 
 
 namespace dg {
@@ -123,6 +124,10 @@ class LLVMPointerAnalysis
     PointerSubgraph *PS = nullptr;
     std::unique_ptr<LLVMPointerSubgraphBuilder> _builder;
 
+    // statistics of the last run()
+    uint64_t iterationsNum{0};
+    uint64_t processedNodesNum{0};
+
     LLVMPointerAnalysisOptions createOptions(const char *entry_func,
                                              uint64_t field_sensitivity,
                                              bool threads = false)
@@ -223,10 +228,16 @@ public:
     PointerSubgraph *getPS() { return PS; }
     const PointerSubgraph *getPS() const { return PS; }
 
+    // the number of iterations of the fixpoint and the number
+    // of nodes that it processed (summed over the iterations)
+    uint64_t getIterationsNum() const { return iterationsNum; }
+    uint64_t getProcessedNodesNum() const { return processedNodesNum; }
+
     void buildSubgraph()
     {
         // run the analysis itself
         assert(_builder && "Incorrectly constructed PTA, missing builder");
+        DG_TRACE_SCOPE("LLVMPointerAnalysis::buildSubgraph");
 
         PS = _builder->buildLLVMPointerSubgraph();
         if (!PS) {
@@ -264,6 +275,9 @@ public:
 
         LLVMPointerAnalysisImpl<PTType> PTA(PS, _builder.get());
         PTA.run();
+
+        iterationsNum = PTA.getIterationsNum();
+        processedNodesNum = PTA.getProcessedNodesNum();
     }
 
     // this method creates PointerAnalysis object and returns it.
@@ -288,6 +302,9 @@ inline void LLVMPointerAnalysis::run<analysis::pta::PointerAnalysisFSInv>()
 
     LLVMPointerAnalysisImpl<analysis::pta::PointerAnalysisFSInv> PTA(PS, _builder.get());
     PTA.run();
+
+    iterationsNum = PTA.getIterationsNum();
+    processedNodesNum = PTA.getProcessedNodesNum();
 }
 
 template <>
@@ -11,11 +11,19 @@ struct LLVMReachingDefinitionsAnalysisOptions :
     public LLVMAnalysisOptions, ReachingDefinitionsAnalysisOptions
 {
     // FIXME: rename ss to sparse
-    enum class AnalysisType { dense, ss } analysisType{AnalysisType::dense};
+    enum class AnalysisType { dense, ss, demand, mssa } analysisType{AnalysisType::dense};
 
     bool threads;
+    // Compute mod/ref summaries of procedures and let the definitions
+    // of memory that a procedure does not touch bypass the procedure.
+    // The definitions are then missing inside such procedures,
+    // so use it only when querying the memory that is used there
+    // (as def-use analysis does). Not available with threads.
+    bool modRefSummaries{false};
     bool isDense() const { return analysisType == AnalysisType::dense; }
     bool isSparse() const { return analysisType == AnalysisType::ss; }
+    bool isDemandDriven() const { return analysisType == AnalysisType::demand; }
+    bool isMemorySSA() const { return analysisType == AnalysisType::mssa; }
 };
 
 } // namespace analysis
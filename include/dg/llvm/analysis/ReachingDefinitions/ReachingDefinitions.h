@@ -26,6 +26,8 @@
 
 #include "dg/analysis/ReachingDefinitions/ReachingDefinitions.h"
 #include "dg/analysis/ReachingDefinitions/SemisparseRda.h"
+#include "dg/analysis/ReachingDefinitions/DemandDrivenRda.h"
+#include "dg/analysis/ReachingDefinitions/MemorySsaRda.h"
 #include "dg/llvm/analysis/PointsTo/PointerAnalysis.h"
 #include "dg/llvm/analysis/ReachingDefinitions/LLVMReachingDefinitionsAnalysisOptions.h"
 
@@ -43,9 +45,13 @@ class LLVMReachingDefinitions
     const llvm::Module *m;
     dg::LLVMPointerAnalysis *pta;
     const LLVMReachingDefinitionsAnalysisOptions _options;
+    // set if the definitions are computed on demand
+    DemandDrivenRda *demandRDA{nullptr};
 
     void initializeSparseRDA();
     void initializeDenseRDA();
+    void initializeDemandDrivenRDA();
+    void initializeMemorySsaRDA();
 
 public:
 
@@ -69,6 +75,10 @@ public:
 
         if (std::is_same<RdaType, SemisparseRda>::value) {
             initializeSparseRDA();
+        } else if (std::is_same<RdaType, DemandDrivenRda>::value) {
+            initializeDemandDrivenRDA();
+        } else if (std::is_same<RdaType, MemorySsaRda>::value) {
+            initializeMemorySsaRDA();
         } else {
             initializeDenseRDA();
         }
@@ -81,6 +91,13 @@ public:
     }
 
     RDNode *getRoot() { return RDA->getRoot(); }
+
+    // the number of iterations of the fixpoint and the number
+    // of nodes that it processed (summed over the iterations)
+    uint64_t getIterationsNum() const { return RDA ? RDA->getIterationsNum() : 0; }
+    uint64_t getProcessedNodesNum() const {
+        return RDA ? RDA->getProcessedNodesNum() : 0;
+    }
     RDNode *getNode(const llvm::Value *val);
 
     // let the user get the nodes map, so that we can
@@ -107,6 +124,21 @@ public:
         return n->getReachingDefinitions(n, off, len, ret);
     }
 
+    // get definitions of memory [what + off, what + off + len]
+    // that reach the node 'where'. Use this method instead
+    // of querying the nodes directly, since with the demand-driven
+    // analysis the nodes do not carry the reaching definitions.
+    size_t getReachingDefinitions(RDNode *where, RDNode *what,
+                                  const Offset& off, const Offset& len,
+                                  std::set<RDNode *>& ret);
+
+    const LLVMReachingDefinitionsAnalysisOptions& getOptions() const {
+        return _options;
+    }
+
+    // nullptr if the analysis is not demand-driven
+    const DemandDrivenRda *getDemandDrivenRDA() const { return demandRDA; }
+
     std::set<llvm::Value *>
     getLLVMReachingDefinitions(llvm::Value *where, llvm::Value *what,
                                const Offset offset, const Offset len);
@@ -0,0 +1,263 @@
+#ifndef _DG_UTIL_TIME_REPORT_H_
+#define _DG_UTIL_TIME_REPORT_H_
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <sys/resource.h>
+#define _DG_HAVE_GETRUSAGE
+#endif
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+namespace dg {
+namespace util {
+
+///
+// Report of the resources spent in the phases of the analyses:
+// the wall and CPU time, the growth of the peak resident set size
+// and of the memory allocated on the heap, and the counters
+// that the phases set (e.g., the number of iterations of a fixpoint).
+//
+// A phase started while another phase is running is its sub-phase,
+// the runs of a phase with the same name and parent are summed up.
+// The report is written as JSON (e.g., for tracking the performance
+// in continuous integration). It is not thread-safe, the phases
+// must be started and stopped by one thread.
+class TimeReport
+{
+public:
+    struct Phase {
+        std::string name;
+        // how many times the phase was run
+        unsigned runs{0};
+        // in seconds
+        double wallTime{0.0};
+        double cpuTime{0.0};
+        // the growth of the peak resident set size (in kB)
+        long peakRSSDelta{0};
+        // the growth of the memory allocated on the heap (in bytes,
+        // negative if the phase freed more memory than it allocated)
+        long long heapDelta{0};
+
+        std::vector<std::pair<std::string, uint64_t>> counters;
+        std::vector<std::unique_ptr<Phase>> subphases;
+
+        Phase(const std::string& n) : name(n) {}
+
+        Phase *getSubphase(const std::string& n)
+        {
+            for (auto& sub : subphases) {
+                if (sub->name == n)
+                    return sub.get();
+            }
+
+            subphases.emplace_back(new Phase(n));
+            return subphases.back().get();
+        }
+
+        uint64_t& getCounter(const std::string& n)
+        {
+            for (auto& it : counters) {
+                if (it.first == n)
+                    return it.second;
+            }
+
+            counters.emplace_back(n, 0);
+            return counters.back().second;
+        }
+    };
+
+    // Run the phase in the scope. Does nothing if the report is nullptr,
+    // so that the code can be measured only when the user asks for it.
+    class Scope
+    {
+        TimeReport *report;
+
+    public:
+        Scope(TimeReport *r, const std::string& name) : report(r)
+        {
+            if (report)
+                report->start(name);
+        }
+
+        ~Scope()
+        {
+            if (report)
+                report->stop();
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    TimeReport(const std::string& name = "total") : root(name)
+    {
+        running.push_back({&root, sample()});
+    }
+
+    void start(const std::string& name)
+    {
+        Phase *phase = running.back().phase->getSubphase(name);
+        running.push_back({phase, sample()});
+    }
+
+    void stop()
+    {
+        assert(running.size() > 1 && "No phase is running");
+        account(running.back().phase, running.back().start, sample());
+        running.pop_back();
+    }
+
+    // set or increase the counter of the innermost running phase
+    void setCounter(const std::string& name, uint64_t value)
+    {
+        running.back().phase->getCounter(name) = value;
+    }
+
+    void addCounter(const std::string& name, uint64_t value = 1)
+    {
+        running.back().phase->getCounter(name) += value;
+    }
+
+    // the whole report, the resources of the root phase
+    // are those spent since the creation of the report
+    const Phase& getRoot()
+    {
+        root.runs = 0;
+        root.wallTime = root.cpuTime = 0.0;
+        root.peakRSSDelta = 0;
+        root.heapDelta = 0;
+        account(&root, running.front().start, sample());
+        return root;
+    }
+
+    void writeJSON(std::ostream& out)
+    {
+        const auto flags = out.flags();
+        out << std::fixed << std::setprecision(6);
+        writePhase(out, getRoot(), 0);
+        out << "\n";
+        out.flags(flags);
+    }
+
+    bool writeJSON(const std::string& file)
+    {
+        std::ofstream out(file);
+        if (!out.is_open())
+            return false;
+
+        writeJSON(out);
+        return out.good();
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Sample {
+        Clock::time_point wall;
+        std::clock_t cpu;
+        long maxRSS;
+        long long heap;
+    };
+
+    struct Running {
+        Phase *phase;
+        Sample start;
+    };
+
+    Phase root;
+    std::vector<Running> running;
+
+    static Sample sample()
+    {
+        Sample s;
+        s.wall = Clock::now();
+        s.cpu = std::clock();
+        s.maxRSS = 0;
+#ifdef _DG_HAVE_GETRUSAGE
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0)
+            s.maxRSS = usage.ru_maxrss;
+#endif
+        s.heap = 0;
+#if defined(__GLIBC__)
+#if __GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33)
+        s.heap = static_cast<long long>(mallinfo2().uordblks);
+#else
+        s.heap = static_cast<long long>(mallinfo().uordblks);
+#endif
+#endif // __GLIBC__
+        return s;
+    }
+
+    static void account(Phase *phase, const Sample& s, const Sample& e)
+    {
+        ++phase->runs;
+        phase->wallTime += std::chrono::duration<double>(e.wall - s.wall).count();
+        phase->cpuTime += static_cast<double>(e.cpu - s.cpu) / CLOCKS_PER_SEC;
+        phase->peakRSSDelta += e.maxRSS - s.maxRSS;
+        phase->heapDelta += e.heap - s.heap;
+    }
+
+    static void writeString(std::ostream& out, const std::string& str)
+    {
+        out << '"';
+        for (char c : str) {
+            if (c == '"' || c == '\\')
+                out << '\\';
+            out << c;
+        }
+        out << '"';
+    }
+
+    static void writePhase(std::ostream& out, const Phase& phase,
+                           unsigned indent)
+    {
+        const std::string pad(indent, ' ');
+        out << pad << "{\n";
+        out << pad << "  \"name\": ";
+        writeString(out, phase.name);
+        out << ",\n";
+        out << pad << "  \"runs\": " << phase.runs << ",\n";
+        out << pad << "  \"wall_time\": " << phase.wallTime << ",\n";
+        out << pad << "  \"cpu_time\": " << phase.cpuTime << ",\n";
+        out << pad << "  \"peak_rss_delta_kb\": " << phase.peakRSSDelta << ",\n";
+        out << pad << "  \"heap_delta_bytes\": " << phase.heapDelta << ",\n";
+
+        out << pad << "  \"counters\": {";
+        for (size_t i = 0; i < phase.counters.size(); ++i) {
+            out << (i == 0 ? "" : ", ");
+            writeString(out, phase.counters[i].first);
+            out << ": " << phase.counters[i].second;
+        }
+        out << "},\n";
+
+        out << pad << "  \"phases\": [";
+        for (size_t i = 0; i < phase.subphases.size(); ++i) {
+            out << (i == 0 ? "\n" : ",\n");
+            writePhase(out, *phase.subphases[i], indent + 4);
+        }
+        if (!phase.subphases.empty())
+            out << "\n" << pad << "  ";
+        out << "]\n";
+        out << pad << "}";
+    }
+};
+
+} // namespace util
+} // namespace dg
+
+#endif // _DG_UTIL_TIME_REPORT_H_
@@ -0,0 +1,216 @@
+#ifndef _DG_UTIL_TRACE_H_
+#define _DG_UTIL_TRACE_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace dg {
+namespace util {
+
+///
+// Tracing of the analyses in the Chrome trace-event format
+// (the file can be opened in about:tracing or in Perfetto).
+//
+// The tracing is turned on by setting the DG_TRACE environment variable
+// to the name of the output file or by calling Tracer::get().start()
+// (the tools do that for the -trace option). The events are kept
+// in memory and written when the tracing is stopped or the program exits.
+//
+// The code is instrumented by the DG_TRACE_SCOPE macros below
+// that expand to nothing if dg is compiled without ENABLE_TRACING.
+// When the tracing is compiled in, but not turned on, a scope
+// costs one check of a flag.
+class Tracer
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Event {
+        const char *name;
+        std::string detail;
+        unsigned tid;
+        uint64_t start;
+        uint64_t duration;
+    };
+
+    std::atomic<bool> on{false};
+    std::mutex lock;
+    std::string file;
+    Clock::time_point epoch;
+    std::vector<Event> events;
+
+    Tracer()
+    {
+        const char *env = std::getenv("DG_TRACE");
+        if (env && *env)
+            start(env);
+    }
+
+    ~Tracer() { stop(); }
+
+    static unsigned threadID()
+    {
+        static std::atomic<unsigned> lastID{0};
+        static thread_local unsigned id = lastID++;
+        return id;
+    }
+
+    static void writeString(std::ostream& out, const std::string& str)
+    {
+        out << '"';
+        for (char c : str) {
+            if (c == '"' || c == '\\')
+                out << '\\';
+            if (static_cast<unsigned char>(c) < 0x20)
+                c = ' ';
+            out << c;
+        }
+        out << '"';
+    }
+
+public:
+    static Tracer& get()
+    {
+        static Tracer tracer;
+        return tracer;
+    }
+
+    // was the instrumentation compiled in?
+    static constexpr bool isAvailable()
+    {
+#ifdef ENABLE_TRACING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    static bool isOn() { return get().on.load(std::memory_order_relaxed); }
+
+    // start tracing into the file (the events recorded
+    // into another file so far are dropped)
+    void start(const std::string& f)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        file = f;
+        events.clear();
+        epoch = Clock::now();
+        on = true;
+    }
+
+    // stop tracing and write the events into the file,
+    // return false if the writing failed
+    bool stop()
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if (!on)
+            return true;
+        on = false;
+
+        std::ofstream out(file);
+        if (!out.is_open())
+            return false;
+
+        out << "{\"traceEvents\": [";
+        for (size_t i = 0; i < events.size(); ++i) {
+            const Event& e = events[i];
+            out << (i == 0 ? "\n" : ",\n");
+            out << "{\"name\": ";
+            writeString(out, e.name);
+            out << ", \"cat\": \"dg\", \"ph\": \"X\", \"pid\": 0"
+                << ", \"tid\": " << e.tid
+                << ", \"ts\": " << e.start
+                << ", \"dur\": " << e.duration;
+            if (!e.detail.empty()) {
+                out << ", \"args\": {\"detail\": ";
+                writeString(out, e.detail);
+                out << "}";
+            }
+            out << "}";
+        }
+        out << "\n], \"displayTimeUnit\": \"ms\"}\n";
+
+        events.clear();
+        return out.good();
+    }
+
+    // microseconds since the start of tracing
+    uint64_t now() const
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                    Clock::now() - epoch).count();
+    }
+
+    void record(const char *name, std::string&& detail,
+                uint64_t start, uint64_t end)
+    {
+        unsigned tid = threadID();
+        std::lock_guard<std::mutex> guard(lock);
+        if (!on)
+            return;
+
+        events.push_back({name, std::move(detail), tid, start, end - start});
+    }
+};
+
+// An event that lasts from the creation to the destruction of the object.
+// The name must live until the tracing stops (use string literals).
+class TraceScope
+{
+    const char *name;
+    std::string detail;
+    uint64_t start{0};
+    const bool active;
+
+public:
+    TraceScope(const char *n) : name(n), active(Tracer::isOn())
+    {
+        if (active)
+            start = Tracer::get().now();
+    }
+
+    TraceScope(const char *n, std::string&& d)
+    : name(n), detail(std::move(d)), active(Tracer::isOn())
+    {
+        if (active)
+            start = Tracer::get().now();
+    }
+
+    ~TraceScope()
+    {
+        if (active)
+            Tracer::get().record(name, std::move(detail),
+                                 start, Tracer::get().now());
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
+
+} // namespace util
+} // namespace dg
+
+#define _DG_TRACE_CONCAT2(a, b) a##b
+#define _DG_TRACE_CONCAT(a, b) _DG_TRACE_CONCAT2(a, b)
+
+#ifdef ENABLE_TRACING
+// trace the rest of the enclosing scope
+#define DG_TRACE_SCOPE(name) \
+    ::dg::util::TraceScope _DG_TRACE_CONCAT(_dg_trace_, __LINE__)(name)
+// the same, with the details of the event (an expression convertible
+// to std::string that is evaluated only if the tracing is on)
+#define DG_TRACE_SCOPE_DETAIL(name, detail) \
+    ::dg::util::TraceScope _DG_TRACE_CONCAT(_dg_trace_, __LINE__)( \
+        name, ::dg::util::Tracer::isOn() ? std::string(detail) : std::string())
+#else
+#define DG_TRACE_SCOPE(name) do {} while (0)
+#define DG_TRACE_SCOPE_DETAIL(name, detail) do {} while (0)
+#endif // ENABLE_TRACING
+
+#endif // _DG_UTIL_TRACE_H_
@@ -0,0 +1,48 @@
+#ifndef _DG_UTIL_PARALLEL_FOR_H_
+#define _DG_UTIL_PARALLEL_FOR_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace dg {
+namespace util {
+
+///
+// Call 'func(i)' for every i in [0, n) using 'threads' threads
+// (0 means as many threads as the hardware supports).
+// The calling thread takes part in the work too, so with one thread
+// everything runs in the calling thread in the order of the indices.
+// The tasks are handed out one by one, which balances the work well
+// when the tasks differ in size (e.g., functions of a module).
+template <typename FuncT>
+void parallel_for(size_t n, unsigned threads, FuncT func)
+{
+    if (threads == 0)
+        threads = std::max(std::thread::hardware_concurrency(), 1u);
+    if (threads > n)
+        threads = static_cast<unsigned>(std::max<size_t>(n, 1));
+
+    std::atomic<size_t> next{0};
+    auto worker = [n, &next, &func]() {
+        size_t i;
+        while ((i = next++) < n)
+            func(i);
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned i = 1; i < threads; ++i)
+        workers.emplace_back(worker);
+
+    worker();
+
+    for (auto& thr : workers)
+        thr.join();
+}
+
+} // namespace util
+} // namespace dg
+
+#endif // _DG_UTIL_PARALLEL_FOR_H_
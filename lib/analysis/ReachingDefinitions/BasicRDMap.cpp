@@ -11,14 +11,9 @@ namespace rd {
 
 class RDNode;
 
-static bool comp_ds(const DefSite& a, const DefSite& b)
-{
-    return a.target < b.target;
-}
-
 ///
 // merge @oth map to this map. If given @no_update set,
-// take those definitions as 'overwrites'. That is -
+// take the definitions flagged as STRONG as 'overwrites'. That is -
 // if some definition in @no_update set overwrites definition
 // in @oth set, don't merge it to our map. The exception are
 // definitions with Offset::UNKNOWN, since we don't know what
@@ -50,11 +45,15 @@ static bool comp_ds(const DefSite& a, const DefSite& b)
 //
 // This is useful when we have a lot of concrete and unknown definitions
 // in the map
+//
+// If @filter is given, only the definitions of memory that pass the filter
+// are merged.
 bool BasicRDMap::merge(const BasicRDMap *oth,
-                       DefSiteSetT *no_update,
+                       const DefSiteSet *no_update,
                        bool strong_update_unknown,
                        Offset::type max_set_size,
-                       bool merge_unknown)
+                       bool merge_unknown,
+                       const DefSiteFilter *filter)
 {
     if (this == oth)
         return false;
@@ -62,6 +61,9 @@ bool BasicRDMap::merge(const BasicRDMap *oth,
     bool changed = false;
     for (const auto& it : oth->_defs) {
         const DefSite& ds = it.first;
+        if (filter && !filter->passes(ds.target))
+            continue;
+
         bool is_unknown = ds.offset.isUnknown();
 
         // STRONG UPDATE
@@ -79,16 +81,17 @@ bool BasicRDMap::merge(const BasicRDMap *oth,
             if (strong_update_unknown &&
                 is_unknown && ds.target->getSize() > 0) {
                 // get the writes that should overwrite this definition
-                auto range = std::equal_range(no_update->begin(),
-                                              no_update->end(),
-                                              ds, comp_ds);
+                auto range = no_update->getObjectRange(ds.target);
                 // XXX: we could check wether all the strong updates
                 // together overwrite the memory, but that could be
                 // to much work. Just check wether there's is just a one
                 // update that overwrites the whole memory
                 bool overwrites_whole_memory = false;
                 for (auto I = range.first; I!= range.second; ++I) {
-                    const DefSite& ds2 = *I;
+                    if (!(I->flags & DefSiteSet::STRONG))
+                        continue;
+
+                    const DefSite& ds2 = I->ds;
                     assert(ds.target == ds2.target);
                     if (*ds2.offset == 0 && *ds2.len >= ds.target->getSize()) {
                         overwrites_whole_memory = true;
@@ -102,11 +105,12 @@ bool BasicRDMap::merge(const BasicRDMap *oth,
                     continue;
             } else if (ds.target->getType() != RDNodeType::DYN_ALLOC) {
                 bool skip = false;
-                auto range = std::equal_range(no_update->begin(),
-                                              no_update->end(),
-                                              ds, comp_ds);
+                auto range = no_update->getObjectRange(ds.target);
                 for (auto I = range.first; I!= range.second; ++I) {
-                    const DefSite& ds2 = *I;
+                    if (!(I->flags & DefSiteSet::STRONG))
+                        continue;
+
+                    const DefSite& ds2 = I->ds;
                     assert(ds.target == ds2.target);
                     // if the 'no_update' set contains target with unknown
                     // pointer, we should always keep that value
@@ -204,13 +208,13 @@ bool BasicRDMap::update(const DefSite& p, RDNode *n)
 }
 
 size_t BasicRDMap::get(RDNode *n, const Offset& off,
-                       const Offset& len, std::set<RDNode *>& ret)
+                       const Offset& len, std::set<RDNode *>& ret) const
 {
     DefSite ds(n, off, len);
     return get(ds, ret);
 }
 
-size_t BasicRDMap::get(DefSite& ds, std::set<RDNode *>& ret)
+size_t BasicRDMap::get(const DefSite& ds, std::set<RDNode *>& ret) const
 {
     if (ds.offset.isUnknown()) {
         auto range = getObjectRange(ds);
@@ -0,0 +1,108 @@
+#include <set>
+
+#include "dg/analysis/ReachingDefinitions/DemandDrivenRda.h"
+#include "dg/ADT/Queue.h"
+
+namespace dg {
+namespace analysis {
+namespace rd {
+
+bool DemandDrivenRda::isChainHead(RDNode *node)
+{
+    if (node->predecessorsNum() != 1)
+        return true;
+
+    return node->getSinglePredecessor()->successorsNum() != 1;
+}
+
+void DemandDrivenRda::searchDefinitions(RDNode *head, const DefSite& ds,
+                                        std::set<RDNode *>& ret)
+{
+    ADT::QueueFIFO<RDNode *> queue;
+    std::set<RDNode *> visited;
+
+    queue.push(head);
+    visited.insert(head);
+
+    while (!queue.empty()) {
+        RDNode *cur = queue.pop();
+        ++statistics.visitedNodes;
+
+        // answers for heads of other chains may be already known
+        if (cur != head && isChainHead(cur)) {
+            auto it = cache.find(CacheKeyT(cur, ds));
+            if (it != cache.end()) {
+                ++statistics.cacheHits;
+                ret.insert(it->second.begin(), it->second.end());
+                continue;
+            }
+        }
+
+        if (definesMemory(cur, ds))
+            ret.insert(cur);
+
+        // the definitions from predecessors do not reach this node
+        if (killsMemory(cur, ds) || !cur->passesDefinitionsOf(ds.target))
+            continue;
+
+        for (RDNode *pred : cur->getPredecessors()) {
+            if (visited.insert(pred).second)
+                queue.push(pred);
+        }
+    }
+}
+
+size_t DemandDrivenRda::getDefinitions(RDNode *where, const DefSite& ds,
+                                       std::set<RDNode *>& ret)
+{
+    assert(where && "No node given");
+    ++statistics.queries;
+
+    std::set<RDNode *> defs;
+
+    // walk the linear part of the graph, there is nothing to cache
+    RDNode *cur = where;
+    bool killed = false;
+    while (!isChainHead(cur)) {
+        ++statistics.visitedNodes;
+
+        if (definesMemory(cur, ds))
+            defs.insert(cur);
+
+        if (killsMemory(cur, ds) || !cur->passesDefinitionsOf(ds.target)) {
+            killed = true;
+            break;
+        }
+
+        cur = cur->getSinglePredecessor();
+        // a cycle without any branching
+        if (cur == where)
+            break;
+    }
+
+    if (!killed) {
+        auto it = cache.find(CacheKeyT(cur, ds));
+        if (it != cache.end()) {
+            ++statistics.cacheHits;
+            defs.insert(it->second.begin(), it->second.end());
+        } else {
+            std::set<RDNode *>& cached = cache[CacheKeyT(cur, ds)];
+            searchDefinitions(cur, ds, cached);
+            defs.insert(cached.begin(), cached.end());
+        }
+    }
+
+    // crop the set to UNKNOWN_MEMORY if it is too big
+    // (the same what the dense analysis does)
+    if (!ds.target->isUnknown() && defs.size() > *options.maxSetSize) {
+        ret.insert(UNKNOWN_MEMORY);
+    } else {
+        ret.insert(defs.begin(), defs.end());
+    }
+
+    return ret.size();
+}
+
+} // namespace rd
+} // namespace analysis
+} // namespace dg
@@ -0,0 +1,136 @@
+#include <algorithm>
+#include <set>
+#include <vector>
+
+#include "dg/analysis/ReachingDefinitions/MemorySsaRda.h"
+
+namespace dg {
+namespace analysis {
+namespace rd {
+
+bool MemorySsaRda::definesObject(RDNode *node, RDNode *target)
+{
+    return node->defines(target);
+}
+
+RDNode *MemorySsaRda::getPhi(RDNode *node, RDNode *target)
+{
+    auto it = phis.find(KeyT(node, target));
+    if (it != phis.end())
+        return it->second;
+
+    RDNode *phi = new RDNode(RDNodeType::PHI);
+    phi_nodes.emplace_back(phi);
+    phi_operands[phi];
+    phis.emplace(KeyT(node, target), phi);
+
+    // the operands are searched later, so that we do not need
+    // to recurse (the phi may be even its own operand)
+    pending.push_back(PendingPhi{phi, node, target});
+
+    return phi;
+}
+
+RDNode *MemorySsaRda::findDefinition(RDNode *node, RDNode *target)
+{
+    auto it = defining.find(KeyT(node, target));
+    if (it != defining.end())
+        return it->second;
+
+    RDNode *result = nullptr;
+    RDNode *cur = node;
+    while (cur->predecessorsNum() == 1 && cur->passesDefinitionsOf(target)) {
+        RDNode *pred = cur->getSinglePredecessor();
+        if (definesObject(pred, target)) {
+            result = pred;
+            break;
+        }
+
+        cur = pred;
+        // a cycle without any branching
+        if (cur == node)
+            break;
+    }
+
+    // no definition in the linear part, we must join
+    // the definitions from predecessors
+    // (no predecessors means that we reached the entry)
+    if (!result && cur->predecessorsNum() > 1 &&
+        cur->passesDefinitionsOf(target))
+        result = getPhi(cur, target);
+
+    defining.emplace(KeyT(node, target), result);
+    return result;
+}
+
+void MemorySsaRda::completePhis()
+{
+    while (!pending.empty()) {
+        PendingPhi p = pending.back();
+        pending.pop_back();
+
+        auto& operands = phi_operands[p.phi];
+        for (RDNode *pred : p.node->getPredecessors()) {
+            RDNode *op = definesObject(pred, p.target) ?
+                            pred : findDefinition(pred, p.target);
+            if (op && std::find(operands.begin(), operands.end(), op)
+                        == operands.end())
+                operands.push_back(op);
+        }
+    }
+}
+
+size_t MemorySsaRda::getDefinitions(RDNode *where, const DefSite& ds,
+                                    std::set<RDNode *>& ret)
+{
+    assert(where && "No node given");
+
+    std::set<RDNode *> defs;
+    std::set<RDNode *> visited;
+    std::vector<RDNode *> to_process;
+
+    RDNode *target = ds.target;
+    to_process.push_back(definesObject(where, target) ?
+                            where : findDefinition(where, target));
+    completePhis();
+
+    // walk the chain of definitions of the object
+    while (!to_process.empty()) {
+        RDNode *cur = to_process.back();
+        to_process.pop_back();
+
+        if (!cur || !visited.insert(cur).second)
+            continue;
+
+        auto it = phi_operands.find(cur);
+        if (it != phi_operands.end()) {
+            to_process.insert(to_process.end(),
+                              it->second.begin(), it->second.end());
+            continue;
+        }
+
+        if (definesMemory(cur, ds))
+            defs.insert(cur);
+
+        // the previous definitions are overwritten
+        if (killsMemory(cur, ds))
+            continue;
+
+        to_process.push_back(findDefinition(cur, target));
+        completePhis();
+    }
+
+    // crop the set to UNKNOWN_MEMORY if it is too big
+    // (the same what the dense analysis does)
+    if (!target->isUnknown() && defs.size() > *options.maxSetSize) {
+        ret.insert(UNKNOWN_MEMORY);
+    } else {
+        ret.insert(defs.begin(), defs.end());
+    }
+
+    return ret.size();
+}
+
+} // namespace rd
+} // namespace analysis
+} // namespace dg
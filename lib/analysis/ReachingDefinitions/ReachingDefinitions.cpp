@@ -1,7 +1,9 @@
 #include <set>
+#include <string>
 
 #include "dg/analysis/ReachingDefinitions/RDMap.h"
 #include "dg/analysis/ReachingDefinitions/ReachingDefinitions.h"
+#include "dg/util/Trace.h"
 
 namespace dg {
 namespace analysis {
@@ -14,14 +16,22 @@ bool ReachingDefinitionsAnalysis::processNode(RDNode *node)
 {
     bool changed = false;
 
+    // the node that does not define anything and has only
+    // one predecessor has the same definitions as the predecessor,
+    // so just share the map
+    if (node->predecessors.size() == 1 && node->defs.empty() &&
+        !node->defs.hasStrong() && !node->filter.objects)
+        return node->def_map.assign(node->predecessors.front()->def_map);
+
     // merge maps from predecessors
     for (RDNode *n : node->predecessors)
         changed |= node->def_map.merge(&n->def_map,
-                                       &node->overwrites /* strong update */,
+                                       &node->defs /* strong update */,
                                        options.strongUpdateUnknown,
                                        *options.maxSetSize, /* max size of set of reaching definition
                                                               of one definition site */
-                                       false /* merge unknown */);
+                                       false /* merge unknown */,
+                                       &node->filter);
 
     return changed;
 }
@@ -29,15 +39,21 @@ bool ReachingDefinitionsAnalysis::processNode(RDNode *node)
 void ReachingDefinitionsAnalysis::run()
 {
     assert(getRoot() && "Do not have root");
+    DG_TRACE_SCOPE("ReachingDefinitionsAnalysis::run");
 
     std::vector<RDNode *> to_process = getNodes(getRoot());
     std::vector<RDNode *> changed;
 
     // do fixpoint
     do {
+        DG_TRACE_SCOPE_DETAIL("ReachingDefinitionsAnalysis::iteration",
+                              std::to_string(to_process.size()) + " nodes");
         unsigned last_processed_num = to_process.size();
         changed.clear();
 
+        ++iterations_num;
+        processed_nodes_num += to_process.size();
+
         for (RDNode *cur : to_process) {
             if (processNode(cur))
                 changed.push_back(cur);
@@ -55,6 +71,68 @@ void ReachingDefinitionsAnalysis::run()
     } while (!changed.empty());
 }
 
+bool ReachingDefinitionsAnalysis::definesMemory(RDNode *node, const DefSite& ds) const
+{
+    auto range = node->defs.getObjectRange(ds.target);
+    for (auto I = range.first; I != range.second; ++I) {
+        if (!(I->flags & DefSiteSet::ELEMENT))
+            continue;
+
+        const DefSite& def = I->ds;
+        // definitions with unknown offset may define anything
+        if (def.offset.isUnknown() || ds.offset.isUnknown())
+            return true;
+
+        if (intervalsOverlap(*def.offset, *def.len, *ds.offset, *ds.len))
+            return true;
+    }
+
+    return false;
+}
+
+// this mirrors the strong update in BasicRDMap::merge
+bool ReachingDefinitionsAnalysis::killsMemory(RDNode *node, const DefSite& ds) const
+{
+    if (!node->defs.hasStrong())
+        return false;
+
+    auto range = node->defs.getObjectRange(ds.target);
+
+    if (ds.offset.isUnknown()) {
+        // we can do a strong update of memory at unknown offset
+        // only if the whole memory is overwritten
+        if (!options.strongUpdateUnknown || ds.target->getSize() == 0)
+            return false;
+
+        for (auto I = range.first; I != range.second; ++I) {
+            const DefSite& ow = I->ds;
+            if ((I->flags & DefSiteSet::STRONG) && !ow.offset.isUnknown() &&
+                *ow.offset == 0 && *ow.len >= ds.target->getSize())
+                return true;
+        }
+
+        return false;
+    }
+
+    // heap objects are represented by the call site,
+    // so we cannot do strong updates on them
+    if (ds.target->getType() == RDNodeType::DYN_ALLOC || ds.len.isUnknown())
+        return false;
+
+    for (auto I = range.first; I != range.second; ++I) {
+        const DefSite& ow = I->ds;
+        if (!(I->flags & DefSiteSet::STRONG) ||
+            ow.offset.isUnknown() || ow.len.isUnknown())
+            continue;
+
+        if (*ds.offset >= *ow.offset &&
+            *ds.offset + *ds.len <= *ow.offset + *ow.len)
+            return true;
+    }
+
+    return false;
+}
+
 } // namespace rd
 } // namespace analysis
 } // namespace dg
@@ -0,0 +1,235 @@
+#include <cassert>
+
+#include "dg/analysis/ReachingDefinitions/RDMap.h"
+#include "dg/analysis/ReachingDefinitions/ReachingDefinitions.h"
+
+namespace dg {
+namespace analysis {
+namespace rd {
+
+const SharedRDMap::ChunksT& SharedRDMap::emptyChunks()
+{
+    static const ChunksT empty;
+    return empty;
+}
+
+const SharedRDMap::ChunkT *SharedRDMap::getChunk(RDNode *target) const
+{
+    if (!_chunks)
+        return nullptr;
+
+    auto it = _chunks->find(target);
+    if (it == _chunks->end())
+        return nullptr;
+
+    return it->second.get();
+}
+
+SharedRDMap::ChunksT& SharedRDMap::chunksForWrite()
+{
+    if (!_chunks)
+        _chunks = std::make_shared<ChunksT>();
+    else if (_chunks.use_count() > 1)
+        _chunks = std::make_shared<ChunksT>(*_chunks);
+
+    return *_chunks;
+}
+
+SharedRDMap::ChunkT& SharedRDMap::chunkForWrite(RDNode *target)
+{
+    std::shared_ptr<ChunkT>& chunk = chunksForWrite()[target];
+    if (!chunk)
+        chunk = std::make_shared<ChunkT>();
+    else if (chunk.use_count() > 1)
+        chunk = std::make_shared<ChunkT>(*chunk);
+
+    return *chunk;
+}
+
+// can we just take the chunk 'chunk' into the map where we do not have
+// any definitions of 'target'? (the merge would not change the chunk)
+static bool canShareChunk(const BasicRDMap& chunk, RDNode *target,
+                          const DefSiteSet *no_update,
+                          Offset::type max_set_size,
+                          bool merge_unknown)
+{
+    if (merge_unknown)
+        return false;
+
+    if (no_update) {
+        auto range = no_update->getObjectRange(target);
+        for (auto I = range.first; I != range.second; ++I) {
+            if (I->flags & DefSiteSet::STRONG)
+                return false;
+        }
+    }
+
+    if (target->isUnknown())
+        return true;
+
+    for (const auto& it : chunk) {
+        if (it.second.size() > max_set_size)
+            return false;
+    }
+
+    return true;
+}
+
+bool SharedRDMap::merge(const SharedRDMap *oth,
+                        const DefSiteSet *no_update,
+                        bool strong_update_unknown,
+                        Offset::type max_set_size,
+                        bool merge_unknown,
+                        const DefSiteFilter *filter)
+{
+    if (this == oth || _chunks == oth->_chunks || !oth->_chunks)
+        return false;
+
+    bool changed = false;
+    for (const auto& it : *oth->_chunks) {
+        RDNode *target = it.first;
+        if (filter && !filter->passes(target))
+            continue;
+
+        const std::shared_ptr<ChunkT>& theirs = it.second;
+        std::shared_ptr<ChunkT> *ours = nullptr;
+        if (_chunks) {
+            auto ourIt = _chunks->find(target);
+            if (ourIt != _chunks->end())
+                ours = &ourIt->second;
+        }
+
+        if (ours && *ours == theirs)
+            continue;
+
+        if (!ours) {
+            if (canShareChunk(*theirs, target, no_update,
+                              max_set_size, merge_unknown)) {
+                chunksForWrite()[target] = theirs;
+                changed = true;
+                continue;
+            }
+        } else if (_chunks.use_count() == 1 && ours->use_count() == 1) {
+            // nobody else sees our chunk, merge in place
+            changed |= (*ours)->merge(theirs.get(), no_update,
+                                      strong_update_unknown,
+                                      max_set_size, merge_unknown);
+            continue;
+        }
+
+        // merge into a copy and keep the copy only if something changed,
+        // so that we do not break the sharing needlessly
+        auto tmp = ours ? std::make_shared<ChunkT>(**ours)
+                        : std::make_shared<ChunkT>();
+        if (tmp->merge(theirs.get(), no_update, strong_update_unknown,
+                       max_set_size, merge_unknown)) {
+            chunksForWrite()[target] = std::move(tmp);
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+bool SharedRDMap::add(const DefSite& p, RDNode *n)
+{
+    if (const ChunkT *chunk = getChunk(p.target)) {
+        auto it = chunk->_defs.find(p);
+        if (it != chunk->_defs.end() && it->second.count(n) > 0)
+            return false;
+    }
+
+    return chunkForWrite(p.target).add(p, n);
+}
+
+bool SharedRDMap::update(const DefSite& p, RDNode *n)
+{
+    if (const ChunkT *chunk = getChunk(p.target)) {
+        auto it = chunk->_defs.find(p);
+        if (it != chunk->_defs.end() && it->second.size() == 1
+            && it->second.count(n) > 0)
+            return false;
+    }
+
+    return chunkForWrite(p.target).update(p, n);
+}
+
+size_t SharedRDMap::get(RDNode *n, const Offset& off,
+                        const Offset& len, std::set<RDNode *>& ret) const
+{
+    return get(DefSite(n, off, len), ret);
+}
+
+size_t SharedRDMap::get(const DefSite& ds, std::set<RDNode *>& ret) const
+{
+    if (const ChunkT *chunk = getChunk(ds.target))
+        chunk->get(ds, ret);
+
+    return ret.size();
+}
+
+// rough sizes of the nodes of the std::map/std::set
+static const uint64_t TREE_NODE_SIZE = 32;
+static const uint64_t ENTRY_SIZE
+    = TREE_NODE_SIZE + sizeof(DefSite) + sizeof(RDNodesSet);
+static const uint64_t DEFINITION_SIZE = TREE_NODE_SIZE + sizeof(RDNode *);
+// the chunk, its reference counter and the entry in the map of chunks
+static const uint64_t CHUNK_SIZE
+    = sizeof(BasicRDMap) + 16 + TREE_NODE_SIZE + sizeof(RDNode *)
+      + sizeof(std::shared_ptr<BasicRDMap>);
+
+void RDMapMemoryCounter::addChunk(const BasicRDMap& map)
+{
+    uint64_t defs = 0;
+    for (const auto& it : map._defs)
+        defs += it.second.size();
+
+    unsharedEntries += map._defs.size();
+    unsharedDefinitions += defs;
+
+    if (seen_chunks.insert(&map).second) {
+        ++chunks;
+        entries += map._defs.size();
+        definitions += defs;
+    }
+}
+
+void RDMapMemoryCounter::add(const SharedRDMap& map)
+{
+    ++maps;
+    if (!map._chunks)
+        return;
+
+    if (!seen_maps.insert(map._chunks.get()).second) {
+        ++sharedMaps;
+        // count just what the memory would be without sharing
+        for (const auto& it : *map._chunks) {
+            for (const auto& entry : it.second->_defs)
+                unsharedDefinitions += entry.second.size();
+            unsharedEntries += it.second->_defs.size();
+        }
+        return;
+    }
+
+    for (const auto& it : *map._chunks)
+        addChunk(*it.second);
+}
+
+uint64_t RDMapMemoryCounter::bytes() const
+{
+    return maps * sizeof(SharedRDMap)
+           + chunks * CHUNK_SIZE
+           + entries * ENTRY_SIZE
+           + definitions * DEFINITION_SIZE;
+}
+
+uint64_t RDMapMemoryCounter::unsharedBytes() const
+{
+    return maps * sizeof(BasicRDMap)
+           + unsharedEntries * ENTRY_SIZE
+           + unsharedDefinitions * DEFINITION_SIZE;
+}
+
+} // rd
+} // analysis
+} // dg
@@ -2,6 +2,7 @@
 
 #include "analysis/ReachingDefinitions/Srg/MarkerSRGBuilderFS.h"
 #include "analysis/ReachingDefinitions/Srg/SparseRDGraphBuilder.h"
+#include "dg/util/Trace.h"
 
 #include <unordered_set>
 
@@ -39,15 +40,20 @@ static void bfs(RDNode *from, SparseRDGraph& srg, T&& visitor) {
 
 void SemisparseRda::run()
 {
+    DG_TRACE_SCOPE("SemisparseRda::run");
     SrgBuilder srg_builder;
     SparseRDGraph srg;
 
     std::unordered_set<RDNode *> to_process;
     std::tie(srg, phi_nodes) = srg_builder.build(getRoot());
 
+    // the sparse graph is processed in one pass
+    iterations_num = 1;
+
     for (auto& pair : srg) {
         RDNode *dest = pair.first;
         if (dest->getUses().size() > 0 && dest->getType() != RDNodeType::PHI) {
+            ++processed_nodes_num;
             bfs(dest, srg, [&](DefSite& ds, RDNode *n){
                 if (n->getType() != RDNodeType::PHI) {
                     merge_maps(n, dest, ds);
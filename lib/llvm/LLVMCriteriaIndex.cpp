@@ -0,0 +1,130 @@
+#ifndef HAVE_LLVM
+# error "Need LLVM for LLVMCriteriaIndex"
+#endif
+
+#include <string>
+#include <vector>
+
+// ignore unused parameters in LLVM libraries
+#if (__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-parameter"
+#else
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+
+#include <llvm/Config/llvm-config.h>
+#include <llvm/IR/DebugInfoMetadata.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/GlobalVariable.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/IntrinsicInst.h>
+
+#if (__clang__)
+#pragma clang diagnostic pop // ignore -Wunused-parameter
+#else
+#pragma GCC diagnostic pop
+#endif
+
+#include "dg/llvm/LLVMCriteriaIndex.h"
+
+namespace dg {
+
+// the value that the criteria may refer to by the variable
+// (a value that has a node in the graph)
+static llvm::Value *variableValue(llvm::Value *val)
+{
+    if (llvm::isa<llvm::Instruction>(val) || llvm::isa<llvm::GlobalVariable>(val))
+        return val;
+    return nullptr;
+}
+
+void LLVMCriteriaIndex::build(const std::vector<llvm::Function *>& functions,
+                              const GetCalleesT& getCallees)
+{
+    using namespace llvm;
+
+    CalleesT callees;
+    for (Function *F : functions) {
+        for (auto& B : *F) {
+            for (auto& I : B) {
+                CallInst *CI = dyn_cast<CallInst>(&I);
+                if (!CI)
+                    continue;
+
+                callees.clear();
+                getCallees(CI, callees);
+
+                // if the function is undefined, it has no subgraphs,
+                // but it is not called via function pointer
+                if (callees.empty()) {
+                    const Function *func
+                        = dyn_cast<Function>(CI->getCalledValue()->stripPointerCasts());
+                    // a call via a pointer that we could not resolve
+                    if (func)
+                        callSites[func->getName().str()].push_back(CI);
+                } else {
+                    for (const Function *callee : callees) {
+                        auto& calls = callSites[callee->getName().str()];
+                        // more subgraphs of one call may be the same function
+                        if (calls.empty() || calls.back() != CI)
+                            calls.push_back(CI);
+                    }
+                }
+            }
+        }
+
+#if (LLVM_VERSION_MAJOR > 3 || LLVM_VERSION_MINOR >= 7)
+        for (auto& B : *F) {
+            for (auto& I : B) {
+                if (const DbgDeclareInst *DD = dyn_cast<DbgDeclareInst>(&I)) {
+                    if (Value *val = DD->getAddress())
+                        variableNames[val] = {DD->getVariable()->getName().str(),
+                                              variableValue(val)};
+                } else if (const DbgValueInst *DV = dyn_cast<DbgValueInst>(&I)) {
+                    if (Value *val = DV->getValue())
+                        variableNames[val] = {DV->getVariable()->getName().str(),
+                                              variableValue(val)};
+                }
+
+                const DebugLoc& Loc = I.getDebugLoc();
+                if (!Loc || Loc.getLine() == 0)
+                    continue;
+
+                auto file = files.insert(Loc->getFilename().str()).first;
+                lines[Loc.getLine()].push_back({&*file, &I});
+            }
+        }
+#endif // LLVM > 3.6
+    }
+
+    for (const auto& it : variableNames) {
+        if (it.second.second)
+            variables[it.second.first].push_back(it.second.second);
+    }
+}
+
+LLVMCriteriaIndex::InstructionsT
+LLVMCriteriaIndex::getInstructionsOnLine(unsigned line, const std::string& file) const
+{
+    InstructionsT insts;
+    auto it = lines.find(line);
+    if (it == lines.end())
+        return insts;
+
+    for (const LineEntry& e : it->second) {
+        if (!file.empty()) {
+            const std::string& path = *e.file;
+            if (path.size() < file.size() ||
+                path.compare(path.size() - file.size(), file.size(), file) != 0)
+                continue;
+        }
+
+        insts.push_back(e.inst);
+    }
+
+    return insts;
+}
+
+} // namespace dg
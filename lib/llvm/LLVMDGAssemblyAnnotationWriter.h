@@ -1,6 +1,7 @@
 #ifndef _LLVM_DG_ASSEMBLY_ANNOTATION_WRITER_H_
 #define _LLVM_DG_ASSEMBLY_ANNOTATION_WRITER_H_
 
+#include <memory>
 
 // ignore unused parameters in LLVM libraries
 #if (__clang__)
@@ -12,6 +13,8 @@
 #endif
 
 #include <llvm/Support/FormattedStream.h>
+#include <llvm/IR/DataLayout.h>
+#include <llvm/IR/Instructions.h>
 
 #if ((LLVM_VERSION_MAJOR == 3) && (LLVM_VERSION_MINOR < 5))
  #include <llvm/Assembly/AssemblyAnnotationWriter.h>
@@ -62,6 +65,8 @@ private:
     LLVMReachingDefinitions *RD;
     const std::set<LLVMNode *> *criteria;
     std::string module_comment{};
+    // created for the first load annotated by emitQueriedDefinitions()
+    std::unique_ptr<llvm::DataLayout> DL;
 
     void printValue(const llvm::Value *val,
                     llvm::formatted_raw_ostream& os,
@@ -139,6 +144,50 @@ private:
 
     }
 
+    // the demand-driven and memory SSA analyses do not fill the maps
+    // of reaching definitions in the nodes, so query the analysis
+    // for the memory read by a load (as def-use analysis does)
+    void emitQueriedDefinitions(LLVMNode *node, analysis::rd::RDNode *rd,
+                                llvm::formatted_raw_ostream& os)
+    {
+        auto LI = llvm::dyn_cast<llvm::LoadInst>(node->getKey());
+        if (!LI || !PTA)
+            return;
+
+        analysis::pta::PSNode *ps = PTA->getPointsTo(LI->getPointerOperand());
+        if (!ps)
+            return;
+
+        if (!DL)
+            DL.reset(new llvm::DataLayout(LI->getParent()->getParent()->getParent()));
+
+        uint64_t size = 0;
+        if (LI->getType()->isSized())
+            size = DL->getTypeAllocSize(LI->getType());
+        analysis::Offset len = size > 0 ? size : analysis::Offset::UNKNOWN;
+
+        for (const auto& ptr : ps->pointsTo) {
+            if (!ptr.isValid() || ptr.isInvalidated())
+                continue;
+
+            auto target = RD->getNode(ptr.target->getUserData<llvm::Value>());
+            if (!target)
+                continue;
+
+            std::set<analysis::rd::RDNode *> defs;
+            RD->getReachingDefinitions(rd, target, ptr.offset, len, defs);
+            for (auto nd : defs) {
+                printDefSite(analysis::rd::DefSite(target, ptr.offset, len),
+                             os, "RD: ");
+                os << " @ ";
+                if (nd->isUnknown())
+                    os << " UNKNOWN\n";
+                else
+                    printValue(nd->getUserData<llvm::Value>(), os, true);
+            }
+        }
+    }
+
     void emitNodeAnnotations(LLVMNode *node, llvm::formatted_raw_ostream& os)
     {
         if (opts & ANNOTATE_RD) {
@@ -146,6 +195,9 @@ private:
             analysis::rd::RDNode *rd = RD->getMapping(node->getKey());
             if (!rd) {
                 os << "  ; RD: no mapping\n";
+            } else if (RD->getOptions().isDemandDriven() ||
+                       RD->getOptions().isMemorySSA()) {
+                emitQueriedDefinitions(node, rd, os);
             } else {
                 auto& defs = rd->getReachingDefinitions();
                 for (auto& it : defs) {
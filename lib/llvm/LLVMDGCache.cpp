@@ -0,0 +1,868 @@
+#ifndef HAVE_LLVM
+# error "Need LLVM for LLVMDGCache"
+#endif
+
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// ignore unused parameters in LLVM libraries
+#if (__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-parameter"
+#else
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+
+#include <llvm/ADT/SmallVector.h>
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+
+#if LLVM_VERSION_MAJOR >= 4
+#include <llvm/Bitcode/BitcodeWriter.h>
+#else
+#include <llvm/Bitcode/ReaderWriter.h>
+#endif
+
+#if (__clang__)
+#pragma clang diagnostic pop // ignore -Wunused-parameter
+#else
+#pragma GCC diagnostic pop
+#endif
+
+#include "dg/llvm/LLVMDGCache.h"
+
+namespace dg {
+
+// the map of all constructed functions (LLVMDependenceGraph.cpp)
+extern std::map<llvm::Value *, LLVMDependenceGraph *> constructedFunctions;
+
+namespace {
+
+// "DGCC" -- a file with different byte order does not match
+const uint32_t MAGIC = 0x44474343;
+// magic, version, two words of the hash and the number of words after header
+const unsigned HEADER_WORDS = 5;
+
+// how is the key of a node stored
+enum ValueKind : uint32_t {
+    // a value of the module (the id is its position in the module)
+    VAL_MODULE = 1,
+    // an operand of an instruction (e.g., a constant passed to a call)
+    VAL_OPERAND = 2,
+    // artificial values that the nodes own
+    VAL_PHONY_RETURN = 3,
+    VAL_PHONY_UNREACHABLE = 4,
+};
+
+// Call 'func' on the values that the nodes can refer to,
+// the position in this order is the id of the value
+template <typename FuncT>
+void forEachModuleValue(const llvm::Module& M, FuncT func)
+{
+    for (const llvm::GlobalVariable& G : M.globals())
+        func(&G);
+    for (const llvm::Function& F : M)
+        func(&F);
+
+    for (const llvm::Function& F : M) {
+        for (const llvm::Argument& A : F.args())
+            func(&A);
+        for (const llvm::BasicBlock& B : F) {
+            func(&B);
+            for (const llvm::Instruction& I : B)
+                func(&I);
+        }
+    }
+}
+
+// Graphs of all functions, the graph of the entry function is the first
+std::vector<LLVMDependenceGraph *> getGraphs(LLVMDependenceGraph *entry)
+{
+    std::vector<LLVMDependenceGraph *> graphs{entry};
+    for (auto& it : constructedFunctions) {
+        if (it.second != entry)
+            graphs.push_back(it.second);
+    }
+
+    return graphs;
+}
+
+} // anonymous namespace
+
+///
+// The file consists of these sections:
+//  - global nodes: their keys
+//  - graphs: the function, the entry node, the nodes (keys),
+//            the exit node, the unified exit block and the blocks
+//            (the key and the nodes)
+//  - formal parameters of the graphs and actual parameters of call nodes
+//  - dependence edges of the nodes (control, data, use, interference)
+//  - successors and control dependencies of the blocks
+//  - subgraphs of the call nodes
+// The nodes and blocks are numbered in the order in which they appear
+// in the file, starting from 1 (0 is no node).
+class LLVMDGCache::Writer
+{
+    std::vector<uint32_t> _words;
+    bool _ok{true};
+
+    std::unordered_map<const llvm::Value *, uint32_t> _values;
+    std::unordered_map<const LLVMNode *, uint32_t> _nodeIds;
+    std::unordered_map<const LLVMBBlock *, uint32_t> _blockIds;
+    std::unordered_map<const LLVMDependenceGraph *, uint32_t> _graphIds;
+    std::vector<LLVMNode *> _nodes;
+    std::vector<LLVMBBlock *> _blocks;
+
+    void put(uint32_t w) { _words.push_back(w); }
+
+    void fail(const char *msg)
+    {
+        if (_ok)
+            llvm::errs() << "ERROR: Cannot store the graph: " << msg << "\n";
+        _ok = false;
+    }
+
+    void putNew(LLVMNode *n)
+    {
+        if (!n || !_nodeIds.emplace(n, _nodes.size() + 1).second) {
+            fail("a node is missing or is stored twice");
+            return;
+        }
+        _nodes.push_back(n);
+    }
+
+    void putNew(LLVMBBlock *B)
+    {
+        if (!_blockIds.emplace(B, _blocks.size() + 1).second) {
+            fail("a block is stored twice");
+            return;
+        }
+        _blocks.push_back(B);
+    }
+
+    template <typename MapT, typename T>
+    void putId(const MapT& ids, const T *v, const char *what)
+    {
+        if (!v) {
+            put(0);
+            return;
+        }
+
+        auto it = ids.find(v);
+        if (it == ids.end()) {
+            fail(what);
+            put(0);
+            return;
+        }
+        put(it->second);
+    }
+
+    void putNode(const LLVMNode *n) { putId(_nodeIds, n, "unknown node"); }
+    void putBlock(const LLVMBBlock *B) { putId(_blockIds, B, "unknown block"); }
+    void putValueId(const llvm::Value *v) { putId(_values, v, "unknown value"); }
+
+    // store the key of a node, 'user' is the instruction that
+    // may use the key as an operand (for actual parameters)
+    void putValue(const llvm::Value *v, const llvm::Instruction *user)
+    {
+        using namespace llvm;
+
+        auto it = _values.find(v);
+        if (it != _values.end()) {
+            put(VAL_MODULE);
+            put(it->second);
+            put(0);
+            return;
+        }
+
+        // artificial values are not inserted into any block
+        const Instruction *I = dyn_cast<Instruction>(v);
+        if (I && !I->getParent()) {
+            if (isa<ReturnInst>(I)) {
+                put(VAL_PHONY_RETURN);
+                put(0);
+                put(0);
+                return;
+            } else if (isa<UnreachableInst>(I)) {
+                put(VAL_PHONY_UNREACHABLE);
+                put(0);
+                put(0);
+                return;
+            }
+        }
+
+        if (user) {
+            for (unsigned i = 0, e = user->getNumOperands(); i < e; ++i) {
+                if (user->getOperand(i) == v) {
+                    put(VAL_OPERAND);
+                    putValueId(user);
+                    put(i);
+                    return;
+                }
+            }
+        }
+
+        fail("a key of a node is not a value of the module");
+        put(0);
+        put(0);
+        put(0);
+    }
+
+    void putPair(const llvm::Value *key, const LLVMDGParameter& p,
+                 const llvm::Instruction *user)
+    {
+        if (!p.in || !p.out)
+            fail("a parameter without input or output node");
+        putValue(key, user);
+        putNew(p.in);
+        putNew(p.out);
+    }
+
+    void putParameters(LLVMDGParameters *params, const llvm::Instruction *user)
+    {
+        if (!params) {
+            put(0);
+            return;
+        }
+        put(1);
+
+        put(params->paramsNum());
+        for (auto& it : *params)
+            putPair(it.first, it.second, user);
+
+        put(params->globalsNum());
+        for (auto I = params->global_begin(), E = params->global_end();
+             I != E; ++I)
+            putPair(I->first, I->second, user);
+
+        auto *va = params->getVarArg();
+        put(va ? 1 : 0);
+        if (va) {
+            putNew(va->in);
+            putNew(va->out);
+        }
+
+        LLVMNode *noret = params->getNoReturn();
+        put(noret ? 1 : 0);
+        if (noret)
+            putNew(noret);
+    }
+
+    template <typename IterT>
+    void putNodes(IterT I, IterT E)
+    {
+        put(std::distance(I, E));
+        for (; I != E; ++I)
+            putNode(*I);
+    }
+
+public:
+    Writer(const llvm::Module& M)
+    {
+        forEachModuleValue(M, [this](const llvm::Value *v) {
+            _values.emplace(v, _values.size() + 1);
+        });
+    }
+
+    bool write(LLVMDependenceGraph *dg)
+    {
+        auto graphs = getGraphs(dg);
+        for (LLVMDependenceGraph *g : graphs)
+            _graphIds.emplace(g, _graphIds.size() + 1);
+
+        // global nodes (the entry nodes of graphs are among them)
+        const auto& globals = dg->getGlobalNodes();
+        put(globals ? globals->size() : 0);
+        if (globals) {
+            for (auto& it : *globals) {
+                putNew(it.second);
+                putValue(it.first, nullptr);
+            }
+        }
+
+        put(graphs.size());
+        for (LLVMDependenceGraph *g : graphs) {
+            LLVMNode *entry = g->getEntry();
+            putValueId(entry->getKey());
+            putNode(entry);
+
+            put(g->size());
+            for (auto& it : *g) {
+                putNew(it.second);
+                putValue(it.first, nullptr);
+            }
+
+            // the exit node is in the graph only if the function
+            // does not return
+            LLVMNode *exit = g->getExit();
+            bool exitInGraph = _nodeIds.count(exit) > 0;
+            put(exitInGraph);
+            if (exitInGraph) {
+                putNode(exit);
+            } else {
+                putNew(exit);
+                putValue(exit->getKey(), nullptr);
+            }
+
+            LLVMBBlock *unified = unifiedExitBB(g).get();
+            put(unified ? 1 : 0);
+            if (unified) {
+                putNew(unified);
+                putNodes(unified->getNodes().begin(),
+                         unified->getNodes().end());
+            }
+
+            put(g->getBlocks().size());
+            for (auto& it : g->getBlocks()) {
+                putNew(it.second);
+                putValueId(it.first);
+                putNodes(it.second->getNodes().begin(),
+                         it.second->getNodes().end());
+            }
+
+            putBlock(g->getEntryBB());
+            putBlock(g->getExitBB());
+        }
+
+        // parameters
+        std::vector<LLVMNode *> calls;
+        for (LLVMDependenceGraph *g : graphs) {
+            putParameters(g->getParameters(), nullptr);
+            for (auto& it : *g) {
+                if (it.second->getParameters())
+                    calls.push_back(it.second);
+            }
+        }
+
+        put(calls.size());
+        for (LLVMNode *call : calls) {
+            putNode(call);
+            putParameters(call->getParameters(),
+                          llvm::dyn_cast<llvm::Instruction>(call->getKey()));
+        }
+
+        // dependence edges (the reverse edges are added with them)
+        put(_nodes.size());
+        for (LLVMNode *n : _nodes) {
+            putNodes(n->control_begin(), n->control_end());
+            putNodes(n->data_begin(), n->data_end());
+            putNodes(n->use_begin(), n->use_end());
+            putNodes(n->interference_begin(), n->interference_end());
+        }
+
+        put(_blocks.size());
+        for (LLVMBBlock *B : _blocks) {
+            put(B->successors().size());
+            for (const auto& edge : B->successors()) {
+                putBlock(edge.target);
+                put(edge.label);
+            }
+            put(B->controlDependence().size());
+            for (const LLVMBBlock *cd : B->controlDependence())
+                putBlock(cd);
+        }
+
+        // subgraphs of call nodes
+        std::vector<std::pair<LLVMNode *, LLVMDependenceGraph *>> links;
+        for (LLVMDependenceGraph *g : graphs) {
+            for (auto& it : *g) {
+                for (LLVMDependenceGraph *sub : it.second->getSubgraphs())
+                    links.emplace_back(it.second, sub);
+            }
+        }
+
+        put(links.size());
+        for (auto& link : links) {
+            putNode(link.first);
+            putId(_graphIds, link.second, "unknown subgraph");
+        }
+
+        return _ok;
+    }
+
+    const std::vector<uint32_t>& getWords() const { return _words; }
+};
+
+class LLVMDGCache::Reader
+{
+    llvm::Module *_M;
+    const char *_pos;
+    const char *_end;
+    bool _ok{true};
+
+    std::vector<llvm::Value *> _values{nullptr};
+    std::vector<LLVMNode *> _nodes{nullptr};
+    std::vector<LLVMBBlock *> _blocks{nullptr};
+    std::vector<LLVMDependenceGraph *> _graphs{nullptr};
+    std::vector<llvm::Function *> _functions{nullptr};
+
+    uint32_t get()
+    {
+        if (_end - _pos < 4) {
+            _ok = false;
+            return 0;
+        }
+
+        uint32_t w;
+        memcpy(&w, _pos, sizeof w);
+        _pos += sizeof w;
+        return w;
+    }
+
+    template <typename T>
+    T *getFrom(const std::vector<T *>& vec)
+    {
+        uint32_t id = get();
+        if (id == 0 || id >= vec.size()) {
+            _ok = false;
+            return nullptr;
+        }
+        return vec[id];
+    }
+
+    LLVMNode *getNode() { return getFrom(_nodes); }
+    LLVMBBlock *getBlock() { return getFrom(_blocks); }
+    llvm::Value *getValueId() { return getFrom(_values); }
+
+    // the number of items that have at least 'words' words
+    uint32_t getCount(unsigned words = 1)
+    {
+        uint32_t n = get();
+        if (static_cast<uint64_t>(n) * words * 4
+                > static_cast<uint64_t>(_end - _pos)) {
+            _ok = false;
+            return 0;
+        }
+        return n;
+    }
+
+    llvm::Value *getValue(bool& owned)
+    {
+        using namespace llvm;
+
+        owned = false;
+        uint32_t kind = get();
+        uint32_t id = get();
+        uint32_t extra = get();
+        switch (kind) {
+        case VAL_MODULE:
+            if (id > 0 && id < _values.size())
+                return _values[id];
+            break;
+        case VAL_OPERAND:
+            if (id > 0 && id < _values.size()) {
+                auto *I = dyn_cast<Instruction>(_values[id]);
+                if (I && extra < I->getNumOperands())
+                    return I->getOperand(extra);
+            }
+            break;
+        case VAL_PHONY_RETURN:
+            owned = true;
+            return ReturnInst::Create(_M->getContext());
+        case VAL_PHONY_UNREACHABLE:
+            owned = true;
+            return new UnreachableInst(_M->getContext());
+        }
+
+        _ok = false;
+        return nullptr;
+    }
+
+    LLVMNode *newNode(bool inGraph = false)
+    {
+        bool owned;
+        llvm::Value *val = getValue(owned);
+        if (!val)
+            return nullptr;
+
+        // artificial values that we created must not be leaked
+        auto *node = new LLVMNode(val, owned);
+        if (inGraph && owned && !llvm::isa<llvm::UnreachableInst>(val)) {
+            delete node;
+            _ok = false;
+            return nullptr;
+        }
+
+        _nodes.push_back(node);
+        return node;
+    }
+
+    // the nodes are created by the parameters, so that they are owned
+    // by them right away (and deleted if we fail later)
+    bool readParameters(LLVMDGParameters *params, LLVMDependenceGraph *dg)
+    {
+        for (unsigned global = 0; global < 2; ++global) {
+            uint32_t num = getCount(3);
+            for (uint32_t i = 0; i < num && _ok; ++i) {
+                bool owned;
+                llvm::Value *key = getValue(owned);
+                if (!key || owned)
+                    return false;
+
+                auto nodes = global ? params->constructGlobal(key, key, dg)
+                                    : params->construct(key, key, dg);
+                _nodes.push_back(nodes.first);
+                _nodes.push_back(nodes.second);
+            }
+        }
+
+        if (get()) {
+            auto *F = llvm::dyn_cast_or_null<llvm::Function>(
+                        dg->getEntry()->getKey());
+            if (!F || !dg->getParameters() || params != dg->getParameters())
+                return false;
+
+            // see LLVMDependenceGraph::addFormalParameters()
+            llvm::Value *val = llvm::ConstantPointerNull::get(F->getType());
+            auto *in = new LLVMNode(val, true);
+            auto *out = new LLVMNode(val, true);
+            in->setDG(dg);
+            out->setDG(dg);
+            params->setVarArg(in, out);
+            _nodes.push_back(in);
+            _nodes.push_back(out);
+        }
+
+        if (get()) {
+            auto *noret = new LLVMNode(new llvm::UnreachableInst(_M->getContext()),
+                                       true);
+            params->addNoReturn(noret);
+            _nodes.push_back(noret);
+        }
+
+        return _ok;
+    }
+
+    bool readGraph(LLVMDependenceGraph *g)
+    {
+        using namespace llvm;
+
+        auto *F = dyn_cast_or_null<Function>(getValueId());
+        LLVMNode *entry = getNode();
+        if (!F || !entry || entry->getKey() != F)
+            return false;
+        entry->setDG(g);
+        g->setEntry(entry);
+        _functions.push_back(F);
+
+        uint32_t num = getCount(3);
+        for (uint32_t i = 0; i < num && _ok; ++i) {
+            LLVMNode *n = newNode(true);
+            if (!n)
+                return false;
+            if (!g->addNode(n)) {
+                delete n;
+                _nodes.back() = nullptr;
+                return false;
+            }
+            if (isa<CallInst>(n->getKey()))
+                g->addCallNode(n);
+        }
+
+        bool exitInGraph = get();
+        LLVMNode *exit = exitInGraph ? getNode() : newNode();
+        if (!exit)
+            return false;
+        g->setExit(exit);
+
+        if (get()) {
+            // the unified exit block, see createSingleExitBB()
+            // and LLVMDependenceGraph::build(llvm::BasicBlock&, LLVMBBlock *)
+            auto *BB = new LLVMBBlock();
+            if (!exitInGraph)
+                BB->deleteNodesOnDestruction();
+            unifiedExitBB(g).reset(BB);
+            _blocks.push_back(BB);
+
+            uint32_t nodesNum = getCount();
+            for (uint32_t j = 0; j < nodesNum && _ok; ++j) {
+                LLVMNode *n = getNode();
+                if (n != exit)
+                    return false;
+                BB->append(n);
+            }
+        } else if (!exitInGraph) {
+            // nobody would own the exit node
+            delete exit;
+            return false;
+        }
+
+        num = getCount(3);
+        auto& blocks = g->getBlocks();
+        blocks.reserve(num);
+        for (uint32_t i = 0; i < num && _ok; ++i) {
+            auto *llvmBB = dyn_cast_or_null<BasicBlock>(getValueId());
+            if (!llvmBB || blocks.count(llvmBB) > 0)
+                return false;
+
+            auto *BB = new LLVMBBlock();
+            BB->setKey(llvmBB);
+            BB->setDG(g);
+            blocks[llvmBB] = BB;
+            _blocks.push_back(BB);
+
+            uint32_t nodesNum = getCount();
+            for (uint32_t j = 0; j < nodesNum && _ok; ++j) {
+                LLVMNode *n = getNode();
+                if (!n || n->getDG() != g)
+                    return false;
+                BB->append(n);
+            }
+        }
+
+        g->setEntryBB(getBlock());
+        g->setExitBB(getBlock());
+        return _ok;
+    }
+
+    template <typename FuncT>
+    bool readNodes(FuncT func)
+    {
+        uint32_t num = getCount();
+        for (uint32_t i = 0; i < num && _ok; ++i) {
+            if (LLVMNode *n = getNode())
+                func(n);
+        }
+        return _ok;
+    }
+
+    bool read(LLVMDependenceGraph *dg)
+    {
+        forEachModuleValue(*_M, [this](const llvm::Value *v) {
+            _values.push_back(const_cast<llvm::Value *>(v));
+        });
+
+        dg->allocateGlobalNodes();
+        uint32_t num = getCount(3);
+        for (uint32_t i = 0; i < num && _ok; ++i) {
+            LLVMNode *n = newNode();
+            if (!n)
+                return false;
+            if (!dg->addGlobalNode(n)) {
+                delete n;
+                _nodes.back() = nullptr;
+                return false;
+            }
+        }
+
+        num = getCount(5);
+        for (uint32_t i = 0; i < num && _ok; ++i) {
+            LLVMDependenceGraph *g = i == 0 ? dg : new LLVMDependenceGraph();
+            _graphs.push_back(g);
+            if (g != dg) {
+                g->setGlobalNodes(dg->getGlobalNodes());
+                setModule(g, _M, nullptr);
+            }
+
+            if (!readGraph(g))
+                return false;
+        }
+
+        if (_graphs.size() < 2)
+            return false;
+
+        // parameters
+        for (size_t i = 1; i < _graphs.size() && _ok; ++i) {
+            if (get() && !readParameters(_graphs[i]->getOrCreateParameters(),
+                                         _graphs[i]))
+                return false;
+        }
+
+        num = getCount(2);
+        for (uint32_t i = 0; i < num && _ok; ++i) {
+            LLVMNode *call = getNode();
+            if (!call || !call->getDG() || call->getParameters() || !get())
+                return false;
+
+            auto *params = new LLVMDGParameters(call);
+            call->setParameters(params);
+            if (!readParameters(params, call->getDG()))
+                return false;
+        }
+
+        // dependence edges
+        if (getCount(4) + 1 != _nodes.size())
+            return false;
+        for (size_t i = 1; i < _nodes.size() && _ok; ++i) {
+            LLVMNode *n = _nodes[i];
+            readNodes([n](LLVMNode *m) { n->addControlDependence(m); });
+            readNodes([n](LLVMNode *m) { n->addDataDependence(m); });
+            readNodes([n](LLVMNode *m) { n->addUseDependence(m); });
+            readNodes([n](LLVMNode *m) { n->addInterferenceDependence(m); });
+        }
+
+        if (getCount(2) + 1 != _blocks.size())
+            return false;
+        for (size_t i = 1; i < _blocks.size() && _ok; ++i) {
+            LLVMBBlock *B = _blocks[i];
+            uint32_t succsNum = getCount(2);
+            for (uint32_t j = 0; j < succsNum && _ok; ++j) {
+                LLVMBBlock *succ = getBlock();
+                uint32_t label = get();
+                if (!succ || label > 255)
+                    return false;
+                B->addSuccessor(succ, static_cast<uint8_t>(label));
+            }
+
+            uint32_t cdsNum = getCount();
+            for (uint32_t j = 0; j < cdsNum && _ok; ++j) {
+                if (LLVMBBlock *cd = getBlock())
+                    B->addControlDependence(cd);
+            }
+        }
+
+        // subgraphs -- check them first, once a graph is a subgraph,
+        // it is deleted by its callers
+        num = getCount(2);
+        std::vector<std::pair<LLVMNode *, LLVMDependenceGraph *>> links;
+        links.reserve(num);
+        for (uint32_t i = 0; i < num && _ok; ++i) {
+            LLVMNode *call = getNode();
+            LLVMDependenceGraph *sub = getFrom(_graphs);
+            if (!call || !call->getDG() || !call->getBBlock()
+                || !llvm::isa<llvm::CallInst>(call->getKey()))
+                return false;
+            links.emplace_back(call, sub);
+        }
+
+        if (!_ok || _pos != _end)
+            return false;
+
+        // the graphs are referenced only by the call nodes now
+        for (size_t i = 2; i < _graphs.size(); ++i)
+            _graphs[i]->unref(false /* deleteOnZero */);
+
+        for (auto& link : links) {
+            link.first->addSubgraph(link.second);
+            link.first->getBBlock()->addCallsite(link.first);
+        }
+
+        for (size_t i = 1; i < _graphs.size(); ++i)
+            constructedFunctions.emplace(_functions[i], _graphs[i]);
+
+        return true;
+    }
+
+public:
+    Reader(llvm::Module *M, const char *data, size_t size)
+    : _M(M), _pos(data), _end(data + size) {}
+
+    bool load(LLVMDependenceGraph *dg)
+    {
+        if (read(dg))
+            return true;
+
+        // delete the graphs other than 'dg', there are no subgraphs
+        // linked yet, so every graph owns just its nodes and blocks
+        for (size_t i = 2; i < _graphs.size(); ++i)
+            delete _graphs[i];
+        return false;
+    }
+};
+
+uint64_t LLVMDGCache::hash(const llvm::Module& M, const std::string& config)
+{
+    llvm::SmallVector<char, 0> buffer;
+    llvm::raw_svector_ostream ostream(buffer);
+#if (LLVM_VERSION_MAJOR > 6)
+    llvm::WriteBitcodeToFile(M, ostream);
+#else
+    llvm::WriteBitcodeToFile(&M, ostream);
+#endif
+    // str() also flushes the stream in old LLVM versions
+    llvm::StringRef data = ostream.str();
+
+    // FNV-1a
+    uint64_t h = 14695981039346656037ULL;
+    auto add = [&h](const char *data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            h ^= static_cast<unsigned char>(data[i]);
+            h *= 1099511628211ULL;
+        }
+    };
+
+    add(data.data(), data.size());
+    add(config.data(), config.size());
+    return h;
+}
+
+bool LLVMDGCache::save(LLVMDependenceGraph *dg, uint64_t hash,
+                       const std::string& file)
+{
+    assert(dg && dg->getModule() && "Need a built graph");
+
+    Writer writer(*dg->getModule());
+    if (!writer.write(dg))
+        return false;
+
+    const auto& words = writer.getWords();
+    uint32_t header[HEADER_WORDS] = {
+        MAGIC, VERSION,
+        static_cast<uint32_t>(hash), static_cast<uint32_t>(hash >> 32),
+        static_cast<uint32_t>(words.size())
+    };
+
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char *>(header), sizeof header);
+    out.write(reinterpret_cast<const char *>(words.data()),
+              words.size() * sizeof(uint32_t));
+    out.close();
+
+    if (!out) {
+        llvm::errs() << "ERROR: Failed writing the graph to " << file << "\n";
+        return false;
+    }
+
+    return true;
+}
+
+std::unique_ptr<LLVMDependenceGraph>
+LLVMDGCache::load(llvm::Module *M, uint64_t hash, const std::string& file)
+{
+    auto buffer = llvm::MemoryBuffer::getFile(file);
+    if (!buffer)
+        return nullptr;
+
+    const char *data = (*buffer)->getBufferStart();
+    size_t size = (*buffer)->getBufferSize();
+
+    uint32_t header[HEADER_WORDS];
+    if (size < sizeof header)
+        return nullptr;
+    memcpy(header, data, sizeof header);
+
+    if (header[0] != MAGIC || header[1] != VERSION
+        || header[2] != static_cast<uint32_t>(hash)
+        || header[3] != static_cast<uint32_t>(hash >> 32)
+        || static_cast<uint64_t>(header[4]) * 4 != size - sizeof header)
+        return nullptr;
+
+    // the graph of other module may be already loaded or built
+    if (!constructedFunctions.empty())
+        return nullptr;
+
+    std::unique_ptr<LLVMDependenceGraph> dg(new LLVMDependenceGraph());
+    // the entry function is set after reading the graph
+    setModule(dg.get(), M, nullptr);
+
+    Reader reader(M, data + sizeof header, size - sizeof header);
+    if (!reader.load(dg.get())) {
+        llvm::errs() << "ERROR: The graph in " << file << " is corrupted\n";
+        return nullptr;
+    }
+
+    setModule(dg.get(), M,
+              llvm::cast<llvm::Function>(dg->getEntry()->getKey()));
+    dg->buildCriteriaIndex();
+    return dg;
+}
+
+} // namespace dg
@@ -6,9 +6,13 @@
  #error "Need CFG enabled for building LLVM Dependence Graph"
 #endif
 
+#include <algorithm>
+#include <memory>
 #include <utility>
 #include <unordered_map>
+#include <unordered_set>
 #include <set>
+#include <vector>
 
 // ignore unused parameters in LLVM libraries
 #if (__clang__)
@@ -49,6 +53,8 @@
 #include "llvm-utils.h"
 
 #include "dg/ADT/Queue.h"
+#include "dg/util/parallel_for.h"
+#include "dg/util/Trace.h"
 
 #include "ControlFlowGraph.h"
 #include "MayHappenInParallel.h"
@@ -71,8 +77,58 @@ const std::map<llvm::Value *,
     return constructedFunctions;
 }
 
+// globals and heap objects (allocation call-sites) that the functions
+// or the functions called from them use, that is, the formal parameters
+// that the functions need besides the arguments.
+// See LLVMDependenceGraph::computeFormalGlobals()
+struct FormalGlobals {
+    std::vector<llvm::Value *> globals;
+    std::vector<llvm::Value *> heap;
+};
+
+struct LLVMDependenceGraph::BuildState {
+    // graphs of functions with nodes and blocks built in advance
+    // (in parallel), see LLVMDependenceGraph::buildBlocksInParallel()
+    std::unordered_map<const llvm::Function *,
+                       LLVMDependenceGraph *> prebuiltGraphs;
+
+    // the formal globals of the functions, the functions from one
+    // strongly connected component of the call graph share the same object
+    std::unordered_map<const llvm::Function *,
+                       std::shared_ptr<const FormalGlobals>> formalGlobals;
+
+    // the functions that may call the function (the call graph
+    // of computeFormalGlobals()), kept for the lazy graph only
+    std::unordered_map<const llvm::Function *,
+                       std::vector<llvm::Function *>> functionCallers;
+
+    // the lazily built graphs that are not connected to any call-site
+    // (yet), the graph of the entry function deletes them
+    std::set<LLVMDependenceGraph *> detachedGraphs;
+};
+
 LLVMDependenceGraph::~LLVMDependenceGraph()
 {
+    // this is the graph of the entry function, the graphs
+    // of the other functions go away with it
+    if (entryFunction) {
+        for (auto it = constructedFunctions.begin();
+             it != constructedFunctions.end();) {
+            if (it->second->getGlobalNodes() == getGlobalNodes())
+                it = constructedFunctions.erase(it);
+            else
+                ++it;
+        }
+    }
+
+    // the lazily built graphs that are not connected to any call-site
+    if (lazy && entryFunction && buildState) {
+        std::set<LLVMDependenceGraph *> graphs;
+        graphs.swap(buildState->detachedGraphs);
+        for (LLVMDependenceGraph *graph : graphs)
+            delete graph;
+    }
+
     // delete nodes
     for (auto I = begin(), E = end(); I != E; ++I) {
         LLVMNode *node = I->second;
@@ -161,16 +217,147 @@ bool LLVMDependenceGraph::build(llvm::Module *m, llvm::Function *entry)
     }
 
     module = m;
+    buildState = std::make_shared<BuildState>();
 
     // add global nodes. These will be shared across subgraphs
     addGlobals(m, this);
 
+    // the lazy graph builds only the graph of the entry function
+    if (buildThreads != 1 && !lazy)
+        buildBlocksInParallel();
+
     // build recursively DG from entry point
     build(entryFunction);
 //    computeInterferenceDependentEdges();
+
+    // delete the graphs of functions that turned out to be unreachable
+    auto& prebuiltGraphs = buildState->prebuiltGraphs;
+    for (auto& it : prebuiltGraphs) {
+        if (it.second != this)
+            delete it.second;
+    }
+    prebuiltGraphs.clear();
+
+    buildCriteriaIndex();
+
     return true;
 };
 
+void LLVMDependenceGraph::buildCriteriaIndex()
+{
+    using CalleesT = LLVMCriteriaIndex::CalleesT;
+
+    criteriaIndex.reset(new LLVMCriteriaIndex());
+
+    // the lazy graph has not built all the functions yet,
+    // take the functions and callees that it would build
+    if (lazy) {
+        std::vector<llvm::Function *> functions = getUnbuiltFunctions();
+        for (auto& it : constructedFunctions)
+            functions.push_back(llvm::cast<llvm::Function>(it.first));
+
+        std::vector<std::pair<llvm::Function *, bool>> callees;
+        criteriaIndex->build(functions,
+                             [this, &callees](llvm::CallInst *CI, CalleesT& funcs) {
+            callees.clear();
+            getCallees(CI, callees);
+            for (auto& callee : callees)
+                funcs.push_back(callee.first);
+        });
+        return;
+    }
+
+    std::vector<llvm::Function *> functions;
+    functions.reserve(constructedFunctions.size());
+    for (auto& it : constructedFunctions)
+        functions.push_back(llvm::cast<llvm::Function>(it.first));
+
+    criteriaIndex->build(functions, [](llvm::CallInst *CI, CalleesT& funcs) {
+        LLVMNode *node = findInstruction(CI, constructedFunctions);
+        assert(node && "Do not have the node of a call");
+        for (LLVMDependenceGraph *sub : node->getSubgraphs()) {
+            LLVMNode *entry = sub->getEntry();
+            assert(entry && "No entry node in graph");
+            funcs.push_back(llvm::cast<llvm::Function>(
+                                entry->getValue()->stripPointerCasts()));
+        }
+    });
+}
+
+static bool is_func_defined(const llvm::Function *func);
+
+// Get functions that may be called from the entry function. This is
+// an over-approximation of the functions whose graphs are built
+// by handleInstruction() -- calls via pointers (and threads)
+// may call any function whose address is taken
+static std::vector<llvm::Function *>
+getReachableFunctions(llvm::Module *M, llvm::Function *entry)
+{
+    using namespace llvm;
+
+    std::vector<Function *> addressTaken;
+    for (Function& F : *M) {
+        if (is_func_defined(&F) && F.hasAddressTaken())
+            addressTaken.push_back(&F);
+    }
+
+    std::set<Function *> visited;
+    std::vector<Function *> reachable;
+    bool addedAddressTaken = false;
+
+    auto add = [&](Function *F) {
+        if (is_func_defined(F) && visited.insert(F).second)
+            reachable.push_back(F);
+    };
+
+    add(entry);
+    for (size_t i = 0; i < reachable.size(); ++i) {
+        for (BasicBlock& B : *reachable[i]) {
+            for (Instruction& I : B) {
+                CallInst *CInst = dyn_cast<CallInst>(&I);
+                if (!CInst || CInst->isInlineAsm())
+                    continue;
+
+                Function *func = dyn_cast<Function>(
+                        CInst->getCalledValue()->stripPointerCasts());
+                if (func && !func->getName().equals("pthread_create")) {
+                    add(func);
+                } else if (!addedAddressTaken) {
+                    for (Function *F : addressTaken)
+                        add(F);
+                    addedAddressTaken = true;
+                }
+            }
+        }
+    }
+
+    return reachable;
+}
+
+void LLVMDependenceGraph::buildBlocksInParallel()
+{
+    auto& prebuiltGraphs = buildState->prebuiltGraphs;
+    assert(prebuiltGraphs.empty() && "Already have prebuilt graphs");
+    DG_TRACE_SCOPE("LLVMDependenceGraph::buildBlocksInParallel");
+
+    std::vector<std::pair<llvm::Function *, LLVMDependenceGraph *>> work;
+    for (llvm::Function *F : getReachableFunctions(module, entryFunction)) {
+        // the graph of the entry function is this graph
+        LLVMDependenceGraph *graph
+            = F == entryFunction ? this : new LLVMDependenceGraph();
+        prebuiltGraphs.emplace(F, graph);
+        work.emplace_back(F, graph);
+    }
+
+    // the graphs are independent and we only read the LLVM IR,
+    // so the workers need no synchronization apart from taking the work
+    util::parallel_for(work.size(), buildThreads, [&work](size_t i) {
+        DG_TRACE_SCOPE_DETAIL("LLVMDependenceGraph::buildBlocks",
+                              work[i].first->getName().str());
+        work[i].second->buildBlocks(work[i].first);
+    });
+}
+
 LLVMDependenceGraph *
 LLVMDependenceGraph::buildSubgraph(LLVMNode *node)
 {
@@ -219,88 +406,65 @@ bool LLVMDependenceGraph::addFormalGlobal(llvm::Value *val)
     return true;
 }
 
-static bool addSubgraphGlobParams(LLVMDependenceGraph *parentdg,
-                                  LLVMDGParameters *params)
-{
-    bool changed = false;
-    for (auto it = params->global_begin(), et = params->global_end();
-         it != et; ++it)
-        changed |= parentdg->addFormalGlobal(it->first);
-
-    // and add heap-allocated variables
-    for (const auto& it : *params) {
-        if (llvm::isa<llvm::CallInst>(it.first))
-            changed |= parentdg->addFormalParameter(it.first);
-    }
-
-    return changed;
-}
-
-void LLVMDependenceGraph::addSubgraphGlobalParameters(LLVMDependenceGraph *subgraph)
-{
-    LLVMDGParameters *params = subgraph->getParameters();
-    if (!params)
-        return;
-
-    // if we do not change anything, it means that the graph
-    // has these params already, and so must the callers of the graph
-    if (!addSubgraphGlobParams(this, params))
-        return;
-
-    // recursively add the formal parameters to all callers
-    for (LLVMNode *callsite : this->getCallers()) {
-        LLVMDependenceGraph *graph = callsite->getDG();
-        graph->addSubgraphGlobalParameters(this);
-
-        // update the actual parameters of the call-site
-        callsite->addActualParameters(this);
-    }
-}
-
 LLVMDependenceGraph *
-LLVMDependenceGraph::buildSubgraph(LLVMNode *node, llvm::Function *callFunc, bool fork)
+LLVMDependenceGraph::createSubgraph(llvm::Function *func)
 {
-    using namespace llvm;
-
-    LLVMBBlock *BB;
-
-    // if we don't have this subgraph constructed, construct it
-    // else just add call edge
-    LLVMDependenceGraph *&subgraph = constructedFunctions[callFunc];
-    if (!subgraph) {
-        // since we have reference the the pointer in
-        // constructedFunctions, we can assing to it
+    // since we have reference the the pointer in
+    // constructedFunctions, we can assing to it.
+    LLVMDependenceGraph *&subgraph = constructedFunctions[func];
+    assert(!subgraph && "Already have the graph of the function");
+
+    // If the nodes of the graph were already built, take the graph.
+    auto& prebuiltGraphs = buildState->prebuiltGraphs;
+    auto prebuilt = prebuiltGraphs.find(func);
+    if (prebuilt != prebuiltGraphs.end()) {
+        subgraph = prebuilt->second;
+        prebuiltGraphs.erase(prebuilt);
+    } else {
         subgraph = new LLVMDependenceGraph();
-        // set global nodes to this one, so that
-        // we'll share them
-        subgraph->setGlobalNodes(getGlobalNodes());
-        subgraph->module = module;
-        subgraph->PTA = PTA;
-        subgraph->threads = this->threads;
-        // make subgraphs gather the call-sites too
-        subgraph->gatherCallsites(gather_callsites, gatheredCallsites);
-
-        // make the real work
+    }
+
+    // set global nodes to this one, so that
+    // we'll share them
+    subgraph->setGlobalNodes(getGlobalNodes());
+    subgraph->buildState = buildState;
+    subgraph->module = module;
+    subgraph->PTA = PTA;
+    subgraph->threads = this->threads;
+    subgraph->lazy = lazy;
+    // make subgraphs gather the call-sites too
+    subgraph->gatherCallsites(gather_callsites, gatheredCallsites);
+
+    // make the real work
 #ifndef NDEBUG
-        bool ret =
+    bool ret =
 #endif
-        subgraph->build(callFunc);
+    subgraph->build(func);
 
 #ifndef NDEBUG
-        // at least for now use just assert, if we'll
-        // have a reason to handle such failures at some
-        // point, we can change it
-        assert(ret && "Building subgraph failed");
+    // at least for now use just assert, if we'll
+    // have a reason to handle such failures at some
+    // point, we can change it
+    assert(ret && "Building subgraph failed");
 #endif
 
-        // we built the subgraph, so it has refcount = 1,
-        // later in the code we call addSubgraph, which
-        // increases the refcount to 2, but we need this
-        // subgraph to has refcount 1, so unref it
-        subgraph->unref(false /* deleteOnZero */);
-    }
+    // we built the subgraph, so it has refcount = 1,
+    // later in the code we call addSubgraph, which
+    // increases the refcount to 2, but we need this
+    // subgraph to has refcount 1, so unref it
+    subgraph->unref(false /* deleteOnZero */);
+
+    if (lazy)
+        buildState->detachedGraphs.insert(subgraph);
 
-    BB = node->getBBlock();
+    return subgraph;
+}
+
+void LLVMDependenceGraph::connectSubgraph(LLVMNode *node,
+                                          LLVMDependenceGraph *subgraph,
+                                          llvm::Function *callFunc, bool fork)
+{
+    LLVMBBlock *BB = node->getBBlock();
     assert(BB && "do not have BB; this is a bug, sir");
     BB->addCallsite(node);
 
@@ -308,10 +472,8 @@ LLVMDependenceGraph::buildSubgraph(LLVMNode *node, llvm::Function *callFunc, boo
     // to entry node
     node->addControlDependence(subgraph->getEntry());
 
-    // add globals that are used in subgraphs
-    // it is necessary if this subgraph was creating due to function
-    // pointer call
-    addSubgraphGlobalParameters(subgraph);
+    // the subgraph has all its formal parameters (including the globals
+    // used in the functions it calls) already, see computeFormalGlobals()
     node->addActualParameters(subgraph, callFunc, fork);
 
     if (auto noret = subgraph->getNoReturn()) {
@@ -319,10 +481,118 @@ LLVMDependenceGraph::buildSubgraph(LLVMNode *node, llvm::Function *callFunc, boo
         auto actnoret = getOrCreateNoReturn(node);
         noret->addControlDependence(actnoret);
     }
+}
+
+LLVMDependenceGraph *
+LLVMDependenceGraph::buildSubgraph(LLVMNode *node, llvm::Function *callFunc, bool fork)
+{
+    // if we don't have this subgraph constructed, construct it
+    // else just add call edge
+    auto it = constructedFunctions.find(callFunc);
+    LLVMDependenceGraph *subgraph = it == constructedFunctions.end() ?
+                                        createSubgraph(callFunc) : it->second;
 
+    connectSubgraph(node, subgraph, callFunc, fork);
     return subgraph;
 }
 
+LLVMDependenceGraph *LLVMDependenceGraph::getOrBuildFunction(llvm::Function *func)
+{
+    auto it = constructedFunctions.find(func);
+    if (it != constructedFunctions.end())
+        return it->second;
+
+    // build only the graphs that the eager construction builds
+    if (!lazy || buildState->formalGlobals.count(func) == 0)
+        return nullptr;
+
+    return createSubgraph(func);
+}
+
+LLVMNode *LLVMDependenceGraph::getOrBuildNode(llvm::Value *val)
+{
+    if (auto *I = llvm::dyn_cast<llvm::Instruction>(val)) {
+        LLVMDependenceGraph *graph
+            = getOrBuildFunction(I->getParent()->getParent());
+        return graph ? graph->getNode(val) : nullptr;
+    }
+
+    return getNode(val);
+}
+
+std::vector<LLVMDependenceGraph *> LLVMDependenceGraph::getCallerGraphs()
+{
+    std::vector<LLVMDependenceGraph *> graphs;
+    if (!lazy)
+        return graphs;
+
+    auto& functionCallers = buildState->functionCallers;
+    auto *func = llvm::cast<llvm::Function>(getEntry()->getValue());
+    auto it = functionCallers.find(func);
+    if (it == functionCallers.end())
+        return graphs;
+
+    graphs.reserve(it->second.size());
+    for (llvm::Function *caller : it->second) {
+        LLVMDependenceGraph *graph = getOrBuildFunction(caller);
+        assert(graph && "Do not have the graph of a caller");
+        graphs.push_back(graph);
+    }
+
+    return graphs;
+}
+
+bool LLVMDependenceGraph::connectCallSites()
+{
+    using namespace llvm;
+
+    if (!lazy || callSitesConnected)
+        return false;
+
+    callSitesConnected = true;
+
+    auto *func = cast<Function>(getEntry()->getValue());
+    std::vector<std::pair<Function *, bool>> callees;
+    for (BasicBlock& B : *func) {
+        for (Instruction& I : B) {
+            CallInst *CInst = dyn_cast<CallInst>(&I);
+            if (!CInst)
+                continue;
+
+            LLVMNode *node = getNode(CInst);
+            assert(node && "Do not have the node of a call");
+
+            callees.clear();
+            getCallees(CInst, callees);
+            for (auto& callee : callees) {
+                LLVMDependenceGraph *subg = getOrBuildFunction(callee.first);
+                assert(subg && "Do not have the graph of a callee");
+
+                connectSubgraph(node, subg, callee.first, callee.second);
+                node->addSubgraph(subg);
+                buildState->detachedGraphs.erase(subg);
+            }
+        }
+    }
+
+    return true;
+}
+
+std::vector<llvm::Function *> LLVMDependenceGraph::getUnbuiltFunctions() const
+{
+    std::vector<llvm::Function *> functions;
+    if (!lazy)
+        return functions;
+
+    for (llvm::Function& F : *module) {
+        if (buildState->formalGlobals.count(&F) > 0 &&
+            constructedFunctions.count(&F) == 0)
+            functions.push_back(&F);
+    }
+
+    return functions;
+}
+
 static bool
 is_func_defined(const llvm::Function *func)
 {
@@ -410,6 +680,60 @@ bool LLVMDependenceGraph::addFormalParameter(llvm::Value *val)
     return true;
 }
 
+void LLVMDependenceGraph::getCallees(llvm::CallInst *CInst,
+                                     std::vector<std::pair<llvm::Function *, bool>>& callees) const
+{
+    using namespace llvm;
+
+    Value *strippedValue = CInst->getCalledValue()->stripPointerCasts();
+    Function *func = dyn_cast<Function>(strippedValue);
+    // if func is nullptr, then this is indirect call
+    // via function pointer. If we have the points-to information,
+    // take the functions that the pointer may point to
+    if (!func && !CInst->isInlineAsm() && PTA) {
+        using namespace analysis::pta;
+        PSNode *op = PTA->getPointsTo(strippedValue);
+        if (op) {
+            for (const Pointer& ptr : op->pointsTo) {
+                if (!ptr.isValid() || ptr.isInvalidated())
+                    continue;
+
+                // vararg may introduce imprecision here, so we
+                // must check that it is really pointer to a function
+                if (!isa<Function>(ptr.target->getUserData<Value>()))
+                    continue;
+
+                Function *F = ptr.target->getUserData<Function>();
+
+                if (F->size() == 0 || !llvmutils::callIsCompatible(F, CInst)) {
+                    if (threads && F && F->getName() == "pthread_create") {
+                        auto possibleFunctions = PTA->getPointsToFunctions(CInst->getArgOperand(2));
+                        for (auto &function : possibleFunctions) {
+                            if (function->size() > 0)
+                                callees.emplace_back(const_cast<llvm::Function *>(function),
+                                                     true /*this is fork*/);
+                        }
+                    }
+                    // else incompatible prototypes or the function
+                    // is only declaration
+                } else {
+                    callees.emplace_back(F, false);
+                }
+            }
+        }
+    }
+
+    if (is_func_defined(func))
+        callees.emplace_back(func, false);
+
+    if (threads && func && func->getName() == "pthread_create") {
+        auto possibleFunctions = PTA->getPointsToFunctions(CInst->getArgOperand(2));
+        for (auto &function : possibleFunctions)
+            callees.emplace_back(const_cast<llvm::Function *>(function),
+                                 true /*this is fork*/);
+    }
+}
+
 // FIXME copied from PointsTo.cpp, don't duplicate,
 // add it to analysis generic
 static bool isMemAllocationFunc(const llvm::Function *func)
@@ -424,6 +748,191 @@ static bool isMemAllocationFunc(const llvm::Function *func)
     return false;
 }
 
+// add the global that the instruction accesses (loads, stores or takes
+// an element of) into 'globals', unless it is there already
+static void addAccessedGlobals(llvm::Instruction *I,
+                               std::vector<llvm::Value *>& globals,
+                               std::unordered_set<llvm::Value *>& seen)
+{
+    using namespace llvm;
+
+    auto add = [&](Value *op) {
+        op = op->stripInBoundsOffsets();
+        if (isa<GlobalVariable>(op) && seen.insert(op).second)
+            globals.push_back(op);
+    };
+
+    if (isa<LoadInst>(I) || isa<GetElementPtrInst>(I)) {
+        add(I->getOperand(0));
+    } else if (isa<StoreInst>(I)) {
+        add(I->getOperand(0));
+        add(I->getOperand(1));
+    }
+}
+
+// Compute which globals and heap objects every function reachable
+// from 'entry' needs as formal parameters. These are the globals
+// that the function accesses and the memory that it allocates,
+// together with those of all the functions that it (transitively) calls.
+// The call graph is the same as the one that handleInstruction() builds
+// and it is processed bottom-up by strongly connected components
+// (Tarjan's algorithm), so every function is processed once and the
+// functions in one component (recursion) share the result.
+void LLVMDependenceGraph::computeFormalGlobals(llvm::Function *entry)
+{
+    using namespace llvm;
+
+    struct FunctionInfo {
+        unsigned index;
+        unsigned lowlink;
+        bool onStack;
+        // the next callee to visit
+        size_t next;
+        std::vector<Function *> callees;
+        // the values used directly in the function
+        std::vector<Value *> globals;
+        std::vector<Value *> heap;
+    };
+
+    auto& formalGlobals = buildState->formalGlobals;
+    auto& functionCallers = buildState->functionCallers;
+
+    // references to the elements stay valid on insertion
+    std::unordered_map<Function *, FunctionInfo> info;
+    std::vector<Function *> sccStack;
+    std::vector<Function *> dfsStack;
+    // the functions in the order of visiting
+    std::vector<Function *> visited;
+    unsigned index = 0;
+
+    auto visit = [&](Function *F) {
+        visited.push_back(F);
+        FunctionInfo& FI = info[F];
+        FI.index = FI.lowlink = index++;
+        FI.onStack = true;
+        FI.next = 0;
+        sccStack.push_back(F);
+        dfsStack.push_back(F);
+
+        std::unordered_set<Value *> seen;
+        std::vector<std::pair<Function *, bool>> callees;
+        for (BasicBlock& B : *F) {
+            for (Instruction& I : B) {
+                CallInst *CInst = dyn_cast<CallInst>(&I);
+                if (!CInst) {
+                    addAccessedGlobals(&I, FI.globals, seen);
+                    continue;
+                }
+
+                getCallees(CInst, callees);
+                if (isMemAllocationFunc(CInst->getCalledFunction()))
+                    FI.heap.push_back(CInst);
+            }
+        }
+
+        for (auto& callee : callees)
+            FI.callees.push_back(callee.first);
+    };
+
+    visit(entry);
+    while (!dfsStack.empty()) {
+        Function *F = dfsStack.back();
+        FunctionInfo& FI = info[F];
+
+        if (FI.next < FI.callees.size()) {
+            Function *callee = FI.callees[FI.next++];
+            auto it = info.find(callee);
+            if (it == info.end())
+                visit(callee);
+            else if (it->second.onStack)
+                FI.lowlink = std::min(FI.lowlink, it->second.index);
+            continue;
+        }
+
+        dfsStack.pop_back();
+        if (!dfsStack.empty()) {
+            FunctionInfo& parent = info[dfsStack.back()];
+            parent.lowlink = std::min(parent.lowlink, FI.lowlink);
+        }
+
+        if (FI.lowlink != FI.index)
+            continue;
+
+        // F is the root of a strongly connected component,
+        // all the components that it calls are done already
+        std::vector<Function *> scc;
+        Function *member;
+        do {
+            member = sccStack.back();
+            sccStack.pop_back();
+            info[member].onStack = false;
+            scc.push_back(member);
+        } while (member != F);
+
+        auto result = std::make_shared<FormalGlobals>();
+        std::unordered_set<Value *> seen;
+        auto merge = [&seen](std::vector<Value *>& to,
+                             const std::vector<Value *>& from) {
+            for (Value *val : from) {
+                if (seen.insert(val).second)
+                    to.push_back(val);
+            }
+        };
+
+        for (Function *M : scc) {
+            merge(result->globals, info[M].globals);
+            merge(result->heap, info[M].heap);
+        }
+
+        for (Function *M : scc) {
+            for (Function *callee : info[M].callees) {
+                auto it = formalGlobals.find(callee);
+                // the callee is in this component
+                if (it == formalGlobals.end())
+                    continue;
+
+                merge(result->globals, it->second->globals);
+                merge(result->heap, it->second->heap);
+            }
+        }
+
+        for (Function *M : scc)
+            formalGlobals[M] = result;
+    }
+
+    // the lazy graph builds the graphs of callers
+    // when it needs them, see getCallerGraphs()
+    if (!lazy)
+        return;
+
+    for (Function *F : visited) {
+        for (Function *callee : info[F].callees) {
+            auto& callers = functionCallers[callee];
+            if (callers.empty() || callers.back() != F)
+                callers.push_back(F);
+        }
+    }
+}
+
+void LLVMDependenceGraph::addFormalGlobals(llvm::Function *func)
+{
+    auto& formalGlobals = buildState->formalGlobals;
+    auto it = formalGlobals.find(func);
+    if (it == formalGlobals.end())
+        return;
+
+    for (llvm::Value *val : it->second->globals)
+        addFormalGlobal(val);
+
+    // if we allocate a memory in a function, we can pass
+    // it to other functions, so it is like global.
+    // We need it as parameter, so that if we define it,
+    // we can add def-use edges from parent, through the parameter
+    // to the definition
+    for (llvm::Value *val : it->second->heap)
+        addFormalParameter(val);
+}
+
 void LLVMDependenceGraph::handleInstruction(llvm::Value *val,
                                             LLVMNode *node,
                                             LLVMNode *prevNode)
@@ -433,45 +942,19 @@ void LLVMDependenceGraph::handleInstruction(llvm::Value *val,
     if (CallInst *CInst = dyn_cast<CallInst>(val)) {
         Value *strippedValue = CInst->getCalledValue()->stripPointerCasts();
         Function *func = dyn_cast<Function>(strippedValue);
-        // if func is nullptr, then this is indirect call
-        // via function pointer. If we have the points-to information,
-        // create the subgraph
-        if (!func && !CInst->isInlineAsm() && PTA) {
-            using namespace analysis::pta;
-            PSNode *op = PTA->getPointsTo(strippedValue);
-            if (op) {
-                for (const Pointer& ptr : op->pointsTo) {
-                    if (!ptr.isValid() || ptr.isInvalidated())
-                        continue;
-
-                    // vararg may introduce imprecision here, so we
-                    // must check that it is really pointer to a function
-                    if (!isa<Function>(ptr.target->getUserData<Value>()))
-                        continue;
-
-                    Function *F = ptr.target->getUserData<Function>();
-
-                    if (F->size() == 0 || !llvmutils::callIsCompatible(F, CInst)) {
-                        if (threads && F && F->getName() == "pthread_create") {
-                            auto possibleFunctions = PTA->getPointsToFunctions(CInst->getArgOperand(2));
-                            for (auto &function : possibleFunctions) {
-                                if (function->size() > 0) {
-                                    LLVMDependenceGraph *subg = buildSubgraph(node, const_cast<llvm::Function *>(function), true /*this is fork*/);
-                                    node->addSubgraph(subg);
-                                }
-                            }
-                        } else {
-                            // incompatible prototypes or the function
-                            // is only declaration
-                            continue;
-                        }
-                    } else {
-                        LLVMDependenceGraph *subg = buildSubgraph(node, F);
-                        node->addSubgraph(subg);
-                    }
-                }
-            } else
-                llvmutils::printerr("Had no PTA node", strippedValue);
+        if (!func && !CInst->isInlineAsm() && PTA
+            && !PTA->getPointsTo(strippedValue))
+            llvmutils::printerr("Had no PTA node", strippedValue);
+
+        // create the subgraphs of the functions that may be called
+        // (the lazy graph connects them later, see connectCallSites())
+        std::vector<std::pair<Function *, bool>> callees;
+        if (!lazy)
+            getCallees(CInst, callees);
+        for (auto& callee : callees) {
+            LLVMDependenceGraph *subg
+                = buildSubgraph(node, callee.first, callee.second);
+            node->addSubgraph(subg);
         }
 
         if (func && gather_callsites &&
@@ -479,27 +962,6 @@ void LLVMDependenceGraph::handleInstruction(llvm::Value *val,
             gatheredCallsites->insert(node);
         }
 
-        if (is_func_defined(func)) {
-            LLVMDependenceGraph *subg = buildSubgraph(node, func);
-            node->addSubgraph(subg);
-        }
-
-        // if we allocate a memory in a function, we can pass
-        // it to other functions, so it is like global.
-        // We need it as parameter, so that if we define it,
-        // we can add def-use edges from parent, through the parameter
-        // to the definition
-        if (isMemAllocationFunc(CInst->getCalledFunction()))
-            addFormalParameter(val);
-
-        if (threads && func && func->getName() == "pthread_create") {
-            auto possibleFunctions = PTA->getPointsToFunctions(CInst->getArgOperand(2));
-            for (auto &function : possibleFunctions) {
-                LLVMDependenceGraph *subg = buildSubgraph(node, const_cast<llvm::Function *>(function), true /*this is fork*/);
-                node->addSubgraph(subg);
-            }
-        }
-
         // no matter what is the function, this is a CallInst,
         // so create call-graph
         addCallNode(node);
@@ -511,54 +973,100 @@ void LLVMDependenceGraph::handleInstruction(llvm::Value *val,
         // depends on the previous instr
         if (prevNode)
             prevNode->addControlDependence(noret);
-    } else if (Instruction *Inst = dyn_cast<Instruction>(val)) {
-        if (isa<LoadInst>(val) || isa<GetElementPtrInst>(val)) {
-            Value *op = Inst->getOperand(0)->stripInBoundsOffsets();
-             if (isa<GlobalVariable>(op))
-                 addFormalGlobal(op);
-        } else if (isa<StoreInst>(val)) {
-            Value *op = Inst->getOperand(0)->stripInBoundsOffsets();
-            if (isa<GlobalVariable>(op))
-                addFormalGlobal(op);
-
-            op = Inst->getOperand(1)->stripInBoundsOffsets();
-            if (isa<GlobalVariable>(op))
-                addFormalGlobal(op);
-        }
     }
 }
 
-LLVMBBlock *LLVMDependenceGraph::build(llvm::BasicBlock& llvmBB)
+LLVMBBlock *LLVMDependenceGraph::createBBlock(llvm::BasicBlock& llvmBB)
 {
-    using namespace llvm;
-
     LLVMBBlock *BB = new LLVMBBlock();
-    LLVMNode *node = nullptr;
-    LLVMNode *prevNode = nullptr;
-
     BB->setKey(&llvmBB);
 
     // iterate over the instruction and create node for every single one of them
-    for (Instruction& Inst : llvmBB) {
-        prevNode = node;
-
-        Value *val = &Inst;
-        node = new LLVMNode(val);
+    for (llvm::Instruction& Inst : llvmBB) {
+        LLVMNode *node = new LLVMNode(&Inst);
 
         // add new node to this dependence graph
         addNode(node);
 
         // add the node to our basic block
         BB->append(node);
+    }
+
+    return BB;
+}
+
+void LLVMDependenceGraph::buildBlocks(llvm::Function *func)
+{
+    using namespace llvm;
+
+    assert(getBlocks().empty() && "Already have the blocks");
+
+    // the nodes and blocks are numbered in the order of instructions,
+    // so allocate the space for them at once
+    size_t instructionsNum = 0;
+    for (const llvm::BasicBlock& llvmBB : *func)
+        instructionsNum += llvmBB.size();
+    nodes.reserve(instructionsNum);
+
+    BBlocksMapT& blocks = getBlocks();
+    blocks.reserve(func->size());
+
+    for (llvm::BasicBlock& llvmBB : *func) {
+        LLVMBBlock *BB = createBBlock(llvmBB);
+        blocks[&llvmBB] = BB;
+
+        // first basic block is the entry BB
+        if (!getEntryBB())
+            setEntryBB(BB);
+    }
+
+    assert(blocks.size() == func->size()
+            && "Did not created all blocks");
+
+    // add CFG edges
+    for (auto& it : blocks) {
+        BasicBlock *llvmBB = cast<BasicBlock>(it.first);
+        LLVMBBlock *BB = it.second;
+        BB->setDG(this);
+
+        int idx = 0;
+        for (succ_iterator S = succ_begin(llvmBB), SE = succ_end(llvmBB);
+             S != SE; ++S) {
+            LLVMBBlock *succ = blocks[*S];
+            assert(succ && "Missing basic block");
+
+            // don't let overflow the labels silently
+            // if this ever happens, we need to change bit-size
+            // of the label (255 is reserved for edge to
+            // artificial single return value)
+            if (idx >= 255) {
+                errs() << "Too much of successors";
+                abort();
+            }
+
+            BB->addSuccessor(succ, idx++);
+        }
+    }
+}
 
-        // take instruction specific actions
-        handleInstruction(val, node, prevNode);
+void LLVMDependenceGraph::build(llvm::BasicBlock& llvmBB, LLVMBBlock *BB)
+{
+    using namespace llvm;
+
+    LLVMNode *node = nullptr;
+    LLVMNode *prevNode = nullptr;
+
+    // take instruction specific actions
+    for (LLVMNode *cur : BB->getNodes()) {
+        prevNode = node;
+        node = cur;
+        handleInstruction(node->getValue(), node, prevNode);
     }
 
     // did we created at least one node?
     if (!node) {
         assert(llvmBB.empty());
-        return BB;
+        return;
     }
 
     // check if this is the exit node of function
@@ -605,8 +1113,6 @@ LLVMBBlock *LLVMDependenceGraph::build(llvm::BasicBlock& llvmBB)
     // sanity check if we have the first and the last node set
     assert(BB->getFirstNode() && "No first node in BB");
     assert(BB->getLastNode() && "No last node in BB");
-
-    return BB;
 }
 
 static LLVMBBlock *createSingleExitBB(LLVMDependenceGraph *graph)
@@ -687,8 +1193,21 @@ bool LLVMDependenceGraph::build(llvm::Function *func)
     if (func->size() == 0)
         return false;
 
+    DG_TRACE_SCOPE_DETAIL("LLVMDependenceGraph::build", func->getName().str());
+
     constructedFunctions.insert(make_pair(func, this));
 
+    // the graph of a function built without the module
+    if (!buildState)
+        buildState = std::make_shared<BuildState>();
+
+    // if this is the graph of the entry function, find out which
+    // globals every function needs as formal parameters
+    // before building any graph
+    bool computedFormalGlobals = buildState->formalGlobals.empty();
+    if (computedFormalGlobals)
+        computeFormalGlobals(func);
+
     // create entry node
     LLVMNode *entry = new LLVMNode(func);
     addGlobalNode(entry);
@@ -698,45 +1217,17 @@ bool LLVMDependenceGraph::build(llvm::Function *func)
 
     // add formal parameters to this graph
     addFormalParameters();
+    addFormalGlobals(func);
 
-    // iterate over basic blocks
+    // create the nodes and blocks (unless they were already
+    // built in parallel)
     BBlocksMapT& blocks = getBlocks();
-    for (llvm::BasicBlock& llvmBB : *func) {
-        LLVMBBlock *BB = build(llvmBB);
-        blocks[&llvmBB] = BB;
+    if (blocks.empty())
+        buildBlocks(func);
 
-        // first basic block is the entry BB
-        if (!getEntryBB())
-            setEntryBB(BB);
-    }
-
-    assert(blocks.size() == func->size()
-            && "Did not created all blocks");
-
-    // add CFG edges
-    for (auto& it : blocks) {
-        BasicBlock *llvmBB = cast<BasicBlock>(it.first);
-        LLVMBBlock *BB = it.second;
-        BB->setDG(this);
-
-        int idx = 0;
-        for (succ_iterator S = succ_begin(llvmBB), SE = succ_end(llvmBB);
-             S != SE; ++S) {
-            LLVMBBlock *succ = blocks[*S];
-            assert(succ && "Missing basic block");
-
-            // don't let overflow the labels silently
-            // if this ever happens, we need to change bit-size
-            // of the label (255 is reserved for edge to
-            // artificial single return value)
-            if (idx >= 255) {
-                errs() << "Too much of successors";
-                abort();
-            }
-
-            BB->addSuccessor(succ, idx++);
-        }
-    }
+    // iterate over basic blocks and handle calls, globals, etc.
+    for (llvm::BasicBlock& llvmBB : *func)
+        build(llvmBB, blocks[&llvmBB]);
 
     // if graph has no return inst, just create artificial exit node
     // and point there
@@ -756,6 +1247,11 @@ bool LLVMDependenceGraph::build(llvm::Function *func)
     // add CFG edge from entry point to the first instruction
     entry->addControlDependence(getEntryBB()->getFirstNode());
 
+    // all the subgraphs are built now
+    // (the lazy graph needs the formal globals later)
+    if (computedFormalGlobals && !lazy)
+        buildState->formalGlobals.clear();
+
     return true;
 }
 
@@ -910,6 +1406,17 @@ bool LLVMDependenceGraph::getCallSites(const char *name, std::set<LLVMNode *> *c
 bool LLVMDependenceGraph::getCallSites(const char *names[],
                                        std::set<LLVMNode *> *callsites)
 {
+    if (criteriaIndex) {
+        for (const char **name = names; *name; ++name) {
+            for (llvm::Value *call : criteriaIndex->getCallSites(*name)) {
+                if (LLVMNode *node = getOrBuildNode(call))
+                    callsites->insert(node);
+            }
+        }
+
+        return callsites->size() != 0;
+    }
+
     for (auto& F : constructedFunctions) {
         for (auto& I : F.second->getBlocks()) {
             LLVMBBlock *BB = I.second;
@@ -928,6 +1435,17 @@ bool LLVMDependenceGraph::getCallSites(const char *names[],
 bool LLVMDependenceGraph::getCallSites(const std::vector<std::string>& names,
                                        std::set<LLVMNode *> *callsites)
 {
+    if (criteriaIndex) {
+        for (const auto& name : names) {
+            for (llvm::Value *call : criteriaIndex->getCallSites(name)) {
+                if (LLVMNode *node = getOrBuildNode(call))
+                    callsites->insert(node);
+            }
+        }
+
+        return callsites->size() != 0;
+    }
+
     for (const auto& F : constructedFunctions) {
         for (const auto& I : F.second->getBlocks()) {
             LLVMBBlock *BB = I.second;
@@ -1135,8 +1653,8 @@ void LLVMDependenceGraph::addNoreturnDependencies(LLVMNode *noret, LLVMBBlock *f
         auto cur = queue.pop();
 
         // do the stuff
-        for (auto node : cur->getNodes())
-            noret->addControlDependence(node);
+        noret->addOutcomingCDs(cur->getNodes().begin(),
+                               cur->getNodes().end());
 
         // queue successors
         for (auto& succ : cur->successors()) {
@@ -1148,26 +1666,28 @@ void LLVMDependenceGraph::addNoreturnDependencies(LLVMNode *noret, LLVMBBlock *f
 
 void LLVMDependenceGraph::addNoreturnDependencies()
 {
-    for (auto& F : getConstructedFunctions()) {
-        auto& blocks = F.second->getBlocks();
+    for (auto& F : getConstructedFunctions())
+        F.second->addFunctionNoreturnDependencies();
+}
 
-        for (auto& it : blocks) {
-            LLVMBBlock *B = it.second;
-            std::set<LLVMNode *> noreturns;
-            for (auto node : B->getNodes()) {
-                // add dependencies for the found no returns
-                for (auto nrt : noreturns) {
-                    nrt->addControlDependence(node);
-                }
+void LLVMDependenceGraph::addFunctionNoreturnDependencies()
+{
+    for (auto& it : getBlocks()) {
+        LLVMBBlock *B = it.second;
+        std::set<LLVMNode *> noreturns;
+        for (auto node : B->getNodes()) {
+            // add dependencies for the found no returns
+            for (auto nrt : noreturns) {
+                nrt->addControlDependence(node);
+            }
 
-                if (auto params = node->getParameters()) {
-                    if (auto noret = params->getNoReturn()) {
-                        // process the rest of the block
-                        noreturns.insert(noret);
+            if (auto params = node->getParameters()) {
+                if (auto noret = params->getNoReturn()) {
+                    // process the rest of the block
+                    noreturns.insert(noret);
 
-                        // process reachable nodes
-                        addNoreturnDependencies(noret, B);
-                    }
+                    // process reachable nodes
+                    addNoreturnDependencies(noret, B);
                 }
             }
         }
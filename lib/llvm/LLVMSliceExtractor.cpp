@@ -0,0 +1,493 @@
+#ifndef HAVE_LLVM
+# error "Need LLVM for LLVMSliceExtractor"
+#endif
+
+#include <cassert>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// ignore unused parameters in LLVM libraries
+#if (__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-parameter"
+#else
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/Function.h>
+#include <llvm/IR/Instructions.h>
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/raw_ostream.h>
+
+#if LLVM_VERSION_MAJOR >= 4
+#include <llvm/Bitcode/BitcodeReader.h>
+#include <llvm/Bitcode/BitcodeWriter.h>
+#else
+#include <llvm/Bitcode/ReaderWriter.h>
+#endif
+
+#if (__clang__)
+#pragma clang diagnostic pop // ignore -Wunused-parameter
+#else
+#pragma GCC diagnostic pop
+#endif
+
+#include "dg/llvm/LLVMSliceExtractor.h"
+#include "dg/llvm/LLVMSlicer.h"
+
+namespace dg {
+
+namespace {
+
+// Call 'func' on the functions, blocks and instructions of the module,
+// the position in this order identifies the value in the copy of the module
+template <typename ModuleT, typename FuncT>
+void forEachModuleValue(ModuleT& M, FuncT func)
+{
+    for (auto& F : M) {
+        func(&F);
+        for (auto& B : F) {
+            func(&B);
+            for (auto& I : B)
+                func(&I);
+        }
+    }
+}
+
+} // anonymous namespace
+
+///
+// Slice one function of the copy of the module. This follows
+// LLVMSlicer::sliceGraph(), but the changes of the CFG are done
+// on a copy of the blocks of the graph.
+class LLVMSliceExtractor::Pruner
+{
+    struct Block;
+    using EdgeT = std::pair<Block *, uint8_t>;
+
+    struct Block {
+        // the block in the graph (nullptr for a new exit block)
+        const LLVMBBlock *orig;
+        // the block in the copy (nullptr for the unified exit block)
+        llvm::BasicBlock *bb;
+        std::set<EdgeT> succs;
+        std::set<Block *> preds;
+        bool removed{false};
+
+        Block(const LLVMBBlock *o, llvm::BasicBlock *b) : orig(o), bb(b) {}
+
+        bool successorsAreSame() const
+        {
+            for (const EdgeT& e : succs) {
+                if (e.first != succs.begin()->first)
+                    return false;
+            }
+            return true;
+        }
+    };
+
+    const analysis::SliceSet<LLVMNode>& slice;
+    const std::unordered_map<const llvm::Value *, unsigned>& positions;
+    const std::vector<llvm::Value *>& values;
+    analysis::SlicerStatistics& statistics;
+
+    std::vector<std::unique_ptr<Block>> storage;
+    std::unordered_map<const LLVMBBlock *, Block *> blocks;
+
+    llvm::Value *copyOf(const llvm::Value *val) const
+    {
+        auto it = positions.find(val);
+        return it == positions.end() ? nullptr : values[it->second];
+    }
+
+    Block *getBlock(const LLVMBBlock *B)
+    {
+        Block *& b = blocks[B];
+        if (!b) {
+            llvm::Value *key = B->getKey();
+            storage.emplace_back(new Block(B, key ?
+                                  llvm::cast<llvm::BasicBlock>(copyOf(key))
+                                  : nullptr));
+            b = storage.back().get();
+        }
+        return b;
+    }
+
+    static void addSuccessor(Block *b, const EdgeT& edge)
+    {
+        b->succs.insert(edge);
+        edge.first->preds.insert(b);
+    }
+
+    static void removeSuccessors(Block *b)
+    {
+        for (const EdgeT& e : b->succs)
+            e.first->preds.erase(b);
+        b->succs.clear();
+    }
+
+    // like BBlock::removeSuccessorsTarget(), keeps the predecessors
+    static void removeSuccessorsTarget(Block *b, Block *target)
+    {
+        for (auto I = b->succs.begin(); I != b->succs.end();) {
+            if (I->first == target)
+                I = b->succs.erase(I);
+            else
+                ++I;
+        }
+    }
+
+    // like BBlock::isolate()
+    static void isolate(Block *b)
+    {
+        for (Block *pred : b->preds) {
+            std::set<EdgeT> newEdges;
+            for (auto I = pred->succs.begin(); I != pred->succs.end();) {
+                auto cur = I++;
+                if (cur->first != b)
+                    continue;
+
+                for (const EdgeT& succ : b->succs) {
+                    if (succ.first != b)
+                        newEdges.emplace(succ.first, cur->second);
+                }
+                pred->succs.erase(cur);
+            }
+
+            for (const EdgeT& edge : newEdges)
+                addSuccessor(pred, edge);
+        }
+
+        removeSuccessors(b);
+        b->preds.clear();
+    }
+
+    // like LLVMSlicer::removeBlocks()
+    static void removeBlocks(const std::vector<Block *>& toRemove)
+    {
+        std::vector<llvm::BasicBlock *> blks;
+        for (Block *b : toRemove) {
+            for (const EdgeT& succ : b->succs) {
+                if (succ.second == 255 || succ.first == b)
+                    continue;
+
+                if (succ.first->bb)
+                    LLVMSlicer::adjustPhiNodes(succ.first->bb, b->bb);
+            }
+
+            if (b->bb)
+                blks.push_back(b->bb);
+        }
+
+        LLVMSlicer::eraseBlocks(blks);
+
+        for (Block *b : toRemove) {
+            b->bb = nullptr;
+            b->removed = true;
+            isolate(b);
+        }
+    }
+
+    static llvm::ReturnInst *createReturn(llvm::Function *F,
+                                          llvm::BasicBlock *block)
+    {
+        using namespace llvm;
+
+        LLVMContext& Ctx = F->getContext();
+        if (F->getReturnType()->isVoidTy())
+            return ReturnInst::Create(Ctx, block);
+        // if this is main, than the safe exit equals to returning 0
+        if (F->getName().equals("main"))
+            return ReturnInst::Create(Ctx,
+                                      ConstantInt::get(Type::getInt32Ty(Ctx), 0),
+                                      block);
+        return ReturnInst::Create(Ctx, UndefValue::get(F->getReturnType()),
+                                  block);
+    }
+
+    // like LLVMSlicer::createNewExitBB()
+    Block *createNewExitBB(llvm::Function *F)
+    {
+        llvm::BasicBlock *block
+            = llvm::BasicBlock::Create(F->getContext(), "safe_return");
+        F->getBasicBlockList().push_back(block);
+        createReturn(F, block);
+
+        storage.emplace_back(new Block(nullptr, block));
+        return storage.back().get();
+    }
+
+    // like LLVMSlicer::adjustBBlocksSucessors()
+    Block *adjustSuccessors(llvm::Function *F, const std::vector<Block *>& order,
+                            Block *oldExitBB)
+    {
+        Block *newExitBB = nullptr;
+        auto getNewExitBB = [&]() {
+            if (!newExitBB)
+                newExitBB = createNewExitBB(F);
+            return newExitBB;
+        };
+
+        for (Block *BB : order) {
+            if (BB->removed || BB->succs.empty())
+                continue;
+
+            const auto tinst = BB->bb->getTerminator();
+            bool lastInSlice = slice.contains(BB->orig->getLastNode());
+
+            if (BB->succs.size() == 2 && !lastInSlice &&
+                !BB->successorsAreSame()) {
+                removeSuccessorsTarget(BB, BB);
+                assert(BB->succs.size() == 1 && "Should have only one successor");
+            }
+
+            if (BB->succs.size() == 1 && !lastInSlice) {
+                EdgeT edge = *BB->succs.begin();
+                edge.second = 0;
+                if (edge.first == oldExitBB)
+                    edge.first = getNewExitBB();
+
+                removeSuccessors(BB);
+                addSuccessor(BB, edge);
+                continue;
+            }
+
+            std::set<uint8_t> labels;
+            for (const EdgeT& succ : BB->succs) {
+                if (succ.second == 255 || succ.first == oldExitBB)
+                    continue;
+                labels.insert(succ.second);
+            }
+
+            for (unsigned i = 0; i < tinst->getNumSuccessors(); ++i) {
+                if (labels.count(i) == 0)
+                    addSuccessor(BB, EdgeT(getNewExitBB(), i));
+            }
+
+            if (newExitBB)
+                removeSuccessorsTarget(BB, oldExitBB);
+
+            if (BB->succs.size() > 1 && BB->successorsAreSame()) {
+                Block *succ = BB->succs.begin()->first;
+                removeSuccessors(BB);
+                addSuccessor(BB, EdgeT(succ, 0));
+            }
+        }
+
+        return newExitBB;
+    }
+
+    // like LLVMSlicer::reconnectBBlock()
+    static void reconnectBlock(Block *BB)
+    {
+        using namespace llvm;
+
+        auto tinst = BB->bb->getTerminator();
+        if (!tinst) {
+            if (BB->succs.size() == 1) {
+                const EdgeT& edge = *BB->succs.begin();
+                if (edge.second != 255) {
+                    BranchInst::Create(edge.first->bb, BB->bb);
+                    return;
+                }
+            }
+
+            assert(BB->succs.empty()
+                    && "Creating return to BBlock that has successors");
+            createReturn(BB->bb->getParent(), BB->bb);
+            return;
+        }
+
+        for (const EdgeT& succ : BB->succs) {
+            if (succ.second == 255)
+                continue;
+
+            assert(succ.first->bb && "No block in the copy");
+            tinst->setSuccessor(succ.second, succ.first->bb);
+        }
+    }
+
+    // like LLVMSlicer::ensureEntryBlock()
+    static void ensureEntryBlock(llvm::Function *F)
+    {
+        using namespace llvm;
+
+        if (F->begin() == F->end())
+            return;
+
+        BasicBlock *entryBlock = &F->getEntryBlock();
+        if (pred_begin(entryBlock) == pred_end(entryBlock))
+            return;
+
+        BasicBlock *block = BasicBlock::Create(F->getContext(), "single_entry");
+        BranchInst::Create(entryBlock, block);
+        F->getBasicBlockList().push_front(block);
+    }
+
+public:
+    Pruner(const analysis::SliceSet<LLVMNode>& slice,
+           const std::unordered_map<const llvm::Value *, unsigned>& positions,
+           const std::vector<llvm::Value *>& values,
+           analysis::SlicerStatistics& statistics)
+    : slice(slice), positions(positions), values(values),
+      statistics(statistics) {}
+
+    void prune(const LLVMDependenceGraph *graph)
+    {
+        storage.clear();
+        blocks.clear();
+
+        llvm::Function *F
+            = llvm::cast<llvm::Function>(copyOf(graph->getEntry()->getKey()));
+
+        // copy the CFG of the graph
+        std::vector<Block *> order;
+        for (const auto& it : graph->getBlocks()) {
+            Block *B = getBlock(it.second);
+            order.push_back(B);
+            for (const auto& edge : it.second->successors())
+                addSuccessor(B, EdgeT(getBlock(edge.target), edge.label));
+        }
+
+        Block *oldExitBB = getBlock(graph->getExitBB());
+
+        // remove the blocks that are not in the slice
+        // (in the same order as LLVMSlicer does)
+        std::set<const LLVMBBlock *> toRemove;
+        for (const auto& it : graph->getBlocks()) {
+            if (!slice.contains(it.second))
+                toRemove.insert(it.second);
+        }
+
+        std::vector<Block *> removedBlocks;
+        for (const LLVMBBlock *orig : toRemove) {
+            statistics.nodesRemoved += orig->size();
+            statistics.nodesTotal += orig->size();
+            ++statistics.blocksRemoved;
+
+            removedBlocks.push_back(blocks[orig]);
+        }
+        removeBlocks(removedBlocks);
+
+        Block *newExitBB = adjustSuccessors(F, order, oldExitBB);
+        if (newExitBB)
+            order.push_back(newExitBB);
+
+        // remove the instructions that are not in the slice
+        std::vector<llvm::Instruction *> insts;
+        for (const auto& it : *graph) {
+            const LLVMNode *n = it.second;
+            if (!newExitBB && n == graph->getExit())
+                continue;
+
+            auto bit = blocks.find(n->getBBlock());
+            if (bit != blocks.end() && bit->second->removed)
+                continue;
+
+            ++statistics.nodesTotal;
+
+            if (!LLVMSlicer::shouldSliceInst(n->getKey()) || slice.contains(n))
+                continue;
+
+            if (llvm::Value *val = copyOf(n->getKey())) {
+                if (auto *Inst = llvm::dyn_cast<llvm::Instruction>(val))
+                    insts.push_back(Inst);
+                else
+                    val->replaceAllUsesWith(llvm::UndefValue::get(val->getType()));
+            }
+            ++statistics.nodesRemoved;
+        }
+        LLVMSlicer::eraseInstructions(insts);
+
+        for (Block *B : order) {
+            if (!B->removed)
+                reconnectBlock(B);
+        }
+
+        ensureEntryBlock(F);
+    }
+};
+
+LLVMSliceExtractor::LLVMSliceExtractor(LLVMDependenceGraph *dg)
+{
+    llvm::Module *M = dg->getModule();
+    assert(M && "The graph has no module");
+
+    moduleId = M->getModuleIdentifier();
+    forEachModuleValue(*M, [this](const llvm::Value *val) {
+        positions.emplace(val, positions.size());
+    });
+
+    llvm::raw_svector_ostream ostream(bitcode);
+#if (LLVM_VERSION_MAJOR > 6)
+    llvm::WriteBitcodeToFile(*M, ostream);
+#else
+    llvm::WriteBitcodeToFile(M, ostream);
+#endif
+    // str() also flushes the stream in old LLVM versions
+    (void) ostream.str();
+}
+
+std::unique_ptr<llvm::Module>
+LLVMSliceExtractor::copy(llvm::LLVMContext& ctx) const
+{
+    llvm::MemoryBufferRef buffer(llvm::StringRef(bitcode.data(), bitcode.size()),
+                                 moduleId);
+#if LLVM_VERSION_MAJOR >= 4
+    auto parsed = llvm::parseBitcodeFile(buffer, ctx);
+    if (!parsed) {
+        llvm::errs() << "ERROR: Copying the module failed: "
+                     << llvm::toString(parsed.takeError()) << "\n";
+        return nullptr;
+    }
+#else
+    auto parsed = llvm::parseBitcodeFile(buffer, ctx);
+    if (!parsed) {
+        llvm::errs() << "ERROR: Copying the module failed: "
+                     << parsed.getError().message() << "\n";
+        return nullptr;
+    }
+#endif
+    return std::move(parsed.get());
+}
+
+std::unique_ptr<llvm::Module>
+LLVMSliceExtractor::extract(const analysis::SliceSet<LLVMNode>& slice,
+                            llvm::LLVMContext& ctx,
+                            analysis::SlicerStatistics *statistics) const
+{
+    std::unique_ptr<llvm::Module> M = copy(ctx);
+    if (!M)
+        return nullptr;
+
+    std::vector<llvm::Value *> values;
+    values.reserve(positions.size());
+    forEachModuleValue(*M, [&values](llvm::Value *val) {
+        values.push_back(val);
+    });
+
+    if (values.size() != positions.size()) {
+        llvm::errs() << "ERROR: The copy of the module differs\n";
+        return nullptr;
+    }
+
+    analysis::SlicerStatistics tmp;
+    Pruner pruner(slice, positions, values, statistics ? *statistics : tmp);
+    for (const auto& it : getConstructedFunctions()) {
+        if (dontTouch.count(it.first->getName().str()) > 0)
+            continue;
+
+        pruner.prune(it.second);
+    }
+
+    return M;
+}
+
+} // namespace dg
@@ -1,4 +1,5 @@
 #include <map>
+#include <vector>
 
 // ignore unused parameters in LLVM libraries
 #if (__clang__)
@@ -35,6 +36,7 @@
 
 #include "dg/llvm/LLVMNode.h"
 #include "dg/llvm/LLVMDependenceGraph.h"
+#include "dg/util/Trace.h"
 
 #include "llvm/llvm-utils.h"
 
@@ -77,15 +79,24 @@ static void addReturnEdge(LLVMNode *callNode, LLVMDependenceGraph *subgraph)
 LLVMDefUseAnalysis::LLVMDefUseAnalysis(LLVMDependenceGraph *dg,
                                        LLVMReachingDefinitions *rd,
                                        LLVMPointerAnalysis *pta,
-                                       const analysis::LLVMDefUseAnalysisOptions& opts)
+                                       const analysis::LLVMDefUseAnalysisOptions& opts,
+                                       bool interprocedural)
     : analysis::legacy::DataFlowAnalysis<LLVMNode>(dg->getEntryBB(),
-                                                   analysis::legacy::DATAFLOW_INTERPROCEDURAL),
+                                                   interprocedural ?
+                                                    analysis::legacy::DATAFLOW_INTERPROCEDURAL : 0),
       dg(dg), RD(rd), PTA(pta), DL(new DataLayout(dg->getModule())), _options(opts)
 {
     assert(PTA && "Need points-to information");
     assert(RD && "Need reaching definitions");
 }
 
+void LLVMDefUseAnalysis::run()
+{
+    DG_TRACE_SCOPE_DETAIL("LLVMDefUseAnalysis::run",
+                          dg->getEntry()->getValue()->getName().str());
+    analysis::legacy::DataFlowAnalysis<LLVMNode>::run();
+}
+
 void LLVMDefUseAnalysis::handleInlineAsm(LLVMNode *callNode)
 {
     CallInst *CI = cast<CallInst>(callNode->getValue());
@@ -270,7 +281,7 @@ void LLVMDefUseAnalysis::addUnknownDataDependence(LLVMNode *node, PSNode *pts)
     }
 }
 
-void LLVMDefUseAnalysis::addDataDependence(LLVMNode *node, llvm::Value *rdval)
+LLVMNode *LLVMDefUseAnalysis::getDefinitionNode(llvm::Value *rdval)
 {
     LLVMNode *rdnode = dg->getNode(rdval);
     if (!rdnode) {
@@ -278,30 +289,34 @@ void LLVMDefUseAnalysis::addDataDependence(LLVMNode *node, llvm::Value *rdval)
         // We need to add interprocedural edge
         llvm::Function *F
             = llvm::cast<llvm::Instruction>(rdval)->getParent()->getParent();
-        LLVMNode *entryNode = dg->getGlobalNode(F);
-        assert(entryNode && "Don't have built function");
-
         // get the graph where the node lives
-        LLVMDependenceGraph *graph = entryNode->getDG();
+        // (the lazy graph builds it if it is not built yet)
+        LLVMDependenceGraph *graph = dg->getOrBuildFunction(F);
+        assert(graph && "Don't have built function");
         assert(graph != dg && "Cannot find a node");
         rdnode = graph->getNode(rdval);
         if (!rdnode) {
             llvmutils::printerr("[DU] error: DG doesn't have val: ", rdval);
             abort();
-            return;
+            return nullptr;
         }
     }
 
     assert(rdnode);
-    rdnode->addDataDependence(node);
+    return rdnode;
 }
 
+void LLVMDefUseAnalysis::addDataDependence(LLVMNode *node, llvm::Value *rdval)
+{
+    getDefinitionNode(rdval)->addDataDependence(node);
+}
 
-void LLVMDefUseAnalysis::addDataDependence(LLVMNode *node, RDNode *rd)
+
+LLVMNode *LLVMDefUseAnalysis::getDefinitionNode(RDNode *rd)
 {
     llvm::Value *rdval = rd->getUserData<llvm::Value>();
     assert(rdval && "RDNode has not set the coresponding value");
-    addDataDependence(node, rdval);
+    return getDefinitionNode(rdval);
 }
 
 // \param mem   current reaching definitions point
@@ -311,6 +326,10 @@ void LLVMDefUseAnalysis::addDataDependence(LLVMNode *node, PSNode *pts,
     using namespace dg::analysis;
     static std::set<const llvm::Value *> reported_mappings;
 
+    // the definitions are gathered here and the edges
+    // are added at once at the end
+    std::vector<LLVMNode *> definitions;
+
     for (const pta::Pointer& ptr : pts->pointsTo) {
         if (!ptr.isValid())
             continue;
@@ -333,19 +352,19 @@ void LLVMDefUseAnalysis::addDataDependence(LLVMNode *node, PSNode *pts,
         std::set<RDNode *> defs;
         // Get even reaching definitions for UNKNOWN_MEMORY.
         // Since those can be ours definitions, we must add them always
-        mem->getReachingDefinitions(rd::UNKNOWN_MEMORY, Offset::UNKNOWN,
-                                    Offset::UNKNOWN, defs);
+        RD->getReachingDefinitions(mem, rd::UNKNOWN_MEMORY, Offset::UNKNOWN,
+                                   Offset::UNKNOWN, defs);
         if (!defs.empty()) {
             for (RDNode *rd : defs) {
                 assert(!rd->isUnknown() && "Unknown memory defined at unknown location?");
                 if (rd->getType() != RDNodeType::PHI)
-                    addDataDependence(node, rd);
+                    definitions.push_back(getDefinitionNode(rd));
             }
 
             defs.clear();
         }
 
-        mem->getReachingDefinitions(val, ptr.offset, size, defs);
+        RD->getReachingDefinitions(mem, val, ptr.offset, size, defs);
         if (defs.empty()) {
             llvm::GlobalVariable *GV
                 = llvm::dyn_cast<llvm::GlobalVariable>(llvmVal);
@@ -387,9 +406,11 @@ void LLVMDefUseAnalysis::addDataDependence(LLVMNode *node, PSNode *pts,
             }
 
             if (rd->getType() != RDNodeType::PHI)
-                addDataDependence(node, rd);
+                definitions.push_back(getDefinitionNode(rd));
         }
     }
+
+    node->addIncomingDDs(definitions.begin(), definitions.end());
 }
 
 void LLVMDefUseAnalysis::addDataDependence(LLVMNode *node,
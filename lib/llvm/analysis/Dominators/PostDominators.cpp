@@ -1,3 +1,7 @@
+#include <chrono>
+#include <utility>
+#include <vector>
+
 // ignore unused parameters in LLVM libraries
 #if (__clang__)
 #pragma clang diagnostic push
@@ -8,7 +12,6 @@
 #endif
 
 #include <llvm/IR/Function.h>
-#include <llvm/Analysis/PostDominators.h>
 
 #if (__clang__)
 #pragma clang diagnostic pop // ignore -Wunused-parameter
@@ -16,102 +19,80 @@
 #pragma GCC diagnostic pop
 #endif
 
-#include "dg/analysis/BFS.h"
+#include "dg/analysis/DominatorTree.h"
 #include "dg/analysis/PostDominanceFrontiers.h"
+#include "dg/util/parallel_for.h"
+#include "dg/util/Trace.h"
 
 #include "dg/llvm/LLVMDependenceGraph.h"
 
 namespace dg {
 
-void LLVMDependenceGraph::computePostDominators(bool addPostDomFrontiers)
+// compute post-dominators (and possibly control dependencies)
+// of one function. It touches only the blocks of the given graph,
+// so it can run for more functions in parallel
+static void computeGraphPostDominators(LLVMDependenceGraph *graph,
+                                       bool addPostDomFrontiers)
 {
-    using namespace llvm;
-    // iterate over all functions
-    for (auto& F : getConstructedFunctions()) {
-        analysis::PostDominanceFrontiers<LLVMNode> pdfrontiers;
+    auto& our_blocks = graph->getBlocks();
+    if (our_blocks.empty())
+        return;
 
-        // root of post-dominator tree
-        LLVMBBlock *root = nullptr;
-        Value *val = const_cast<Value *>(F.first);
-        Function& f = *cast<Function>(val);
-        PostDominatorTree *pdtree;
+    DG_TRACE_SCOPE_DETAIL("computePostDominators",
+                          graph->getEntry()->getValue()->getName().str());
 
-#if ((LLVM_VERSION_MAJOR == 3) && (LLVM_VERSION_MINOR < 9))
-        pdtree = new PostDominatorTree();
-        // compute post-dominator tree for this function
-        pdtree->runOnFunction(f);
-#else
-        PostDominatorTreeWrapperPass wrapper;
-        wrapper.runOnFunction(f);
-        pdtree = &wrapper.getPostDomTree();
-#ifndef NDEBUG
-        wrapper.verifyAnalysis();
-#endif
-#endif
+    std::vector<LLVMBBlock *> blocks;
+    blocks.reserve(our_blocks.size());
+    for (auto& it : our_blocks)
+        blocks.push_back(it.second);
 
-        // add immediate post-dominator edges
-        auto& our_blocks = F.second->getBlocks();
-        bool built = false;
-        for (auto& it : our_blocks) {
-            LLVMBBlock *BB = it.second;
-            BasicBlock *B = cast<BasicBlock>(const_cast<Value *>(it.first));
-            DomTreeNode *N = pdtree->getNode(B);
-            // when function contains infinite loop, we're screwed
-            // and we don't have anything
-            // FIXME: just check for the root,
-            // don't iterate over all blocks, stupid...
-            if (!N)
-                continue;
-
-            DomTreeNode *idom = N->getIDom();
-            BasicBlock *idomBB = idom ? idom->getBlock() : nullptr;
-            built = true;
-
-            if (idomBB) {
-                LLVMBBlock *pb = our_blocks[idomBB];
-                assert(pb && "Do not have constructed BB");
-                BB->setIPostDom(pb);
-                assert(cast<BasicBlock>(BB->getKey())->getParent()
-                        == cast<BasicBlock>(pb->getKey())->getParent()
-                        && "BBs are from diferent functions");
-            // if we do not have idomBB, then the idomBB is a root BB
-            } else {
-                // PostDominatorTree may has special root without BB set
-                // or it is the node without immediate post-dominator
-                if (!root) {
-                    root = new LLVMBBlock();
-                    root->setKey(nullptr);
-                    F.second->setPostDominatorTreeRoot(root);
-                }
-
-                BB->setIPostDom(root);
-            }
-        }
-
-        // well, if we haven't built the pdtree, this is probably infinite loop
-        // that has no pdtree. Until we have anything better, just add sound control
-        // edges that are not so precise - to predecessors.
-        if (!built && addPostDomFrontiers) {
-            for (auto& it : our_blocks) {
-                LLVMBBlock *BB = it.second;
-                for (const LLVMBBlock::BBlockEdge& succ : BB->successors()) {
-                    // in this case we add only the control dependencies,
-                    // since we have no pd frontiers
-                    BB->addControlDependence(succ.target);
-                }
-            }
-        }
-
-        if (addPostDomFrontiers) {
-            // assert(root && "BUG: must have root");
-            if (root)
-                pdfrontiers.compute(root, true /* store also control depend. */);
-        }
-
-#if ((LLVM_VERSION_MAJOR == 3) && (LLVM_VERSION_MINOR < 9))
-        delete pdtree;
-#endif
+    // root of post-dominator tree. It is the immediate post-dominator
+    // of the blocks that return from the function (the edges
+    // to the unified exit block are not taken into account)
+    // and of the blocks that end with 'unreachable'
+    LLVMBBlock *root = new LLVMBBlock();
+    root->setKey(nullptr);
+    graph->setPostDominatorTreeRoot(root);
+
+    analysis::BBlockDominators<LLVMNode>::computePostDominators(blocks, root);
+
+    if (addPostDomFrontiers) {
+        analysis::PostDominanceFrontiers<LLVMNode> pdfrontiers;
+        pdfrontiers.compute(root, true /* store also control depend. */);
     }
 }
 
+void LLVMDependenceGraph::computePostDominators(bool addPostDomFrontiers)
+{
+    using Clock = std::chrono::steady_clock;
+    DG_TRACE_SCOPE("LLVMDependenceGraph::computePostDominators");
+
+    std::vector<std::pair<llvm::Function *, LLVMDependenceGraph *>> work;
+    for (auto& F : getConstructedFunctions()) {
+        llvm::Value *val = const_cast<llvm::Value *>(F.first);
+        work.emplace_back(llvm::cast<llvm::Function>(val), F.second);
+    }
+
+    // the functions are independent, every task writes
+    // only to the blocks of its function and to its slot in 'times'
+    std::vector<uint64_t> times(work.size());
+    util::parallel_for(work.size(), buildThreads,
+                       [&work, &times, addPostDomFrontiers](size_t i) {
+        auto start = Clock::now();
+        computeGraphPostDominators(work[i].second, addPostDomFrontiers);
+        times[i] = std::chrono::duration_cast<std::chrono::microseconds>(
+                        Clock::now() - start).count();
+    });
+
+    cdTimes.clear();
+    cdTimes.reserve(work.size());
+    for (size_t i = 0; i < work.size(); ++i)
+        cdTimes.emplace_back(work[i].first, times[i]);
+}
+
+void LLVMDependenceGraph::computeFunctionPostDominators(bool addPostDomFrontiers)
+{
+    computeGraphPostDominators(this, addPostDomFrontiers);
+}
+
 } // namespace dg
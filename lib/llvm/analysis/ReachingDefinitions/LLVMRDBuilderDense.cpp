@@ -489,6 +489,7 @@ LLVMRDBuilderDense::createCallToFunction(const llvm::Function *F,
     if (callNode) {
         makeEdge(callNode, root);
         makeEdge(ret, returnNode);
+        addCallSite(callNode, returnNode, F, CInst);
         return {callNode, returnNode};
     }
 
@@ -828,6 +829,10 @@ LLVMRDBuilderDense::createCallToFunctions(const std::vector<const llvm::Function
             makeEdge(callNode, func.first);
             makeEdge(func.second, returnNode);
             hasFunction |= true;
+
+            auto it = subgraphs_map.find(function);
+            if (it != subgraphs_map.end() && it->second.root == func.first)
+                addCallSite(callNode, returnNode, function, CInst);
         }
     }
 
@@ -927,6 +932,9 @@ ReachingDefinitionsGraph LLVMRDBuilderDense::build()
 
     if (_options.threads) {
         matchForksAndJoins();
+    } else if (_options.modRefSummaries) {
+        computeModRefSummaries();
+        applyModRefSummaries();
     }
 
     ReachingDefinitionsGraph graph;
@@ -935,6 +943,170 @@ ReachingDefinitionsGraph LLVMRDBuilderDense::build()
     return graph;
 }
 
+void LLVMRDBuilderDense::addCallSite(RDNode *callNode, RDNode *returnNode,
+                                      const llvm::Function *callee,
+                                      const llvm::CallInst *CInst)
+{
+    callSites.push_back(CallSite{callNode, returnNode, callee});
+
+    const llvm::Function *caller = CInst->getParent()->getParent();
+    callGraph.addCall(caller, callee);
+}
+
+///
+// Add the memory that may be read via 'val' into the summary.
+// This mirrors what memory the def-use analysis asks about.
+void LLVMRDBuilderDense::addRef(ModRefSummary& summary, const llvm::Value *val)
+{
+    auto pts = PTA->getPointsTo(val);
+    if (!pts) {
+        summary.refUnknown = true;
+        return;
+    }
+
+    for (const auto& ptr : pts->pointsTo) {
+        if (!ptr.isValid() || ptr.isInvalidated())
+            continue;
+
+        RDNode *target = getNode(ptr.target->getUserData<llvm::Value>());
+        if (target)
+            summary.touched.insert(target);
+    }
+}
+
+///
+// Compute the mod/ref summary of the function without its callees.
+// 'roots' are the root nodes of all subgraphs (we do not want to enter
+// other procedures) and 'returns' maps call nodes to their return nodes.
+void LLVMRDBuilderDense::computeLocalSummary(const llvm::Function *F,
+                                             const Subgraph& subg,
+                                             const std::set<RDNode *>& roots,
+                                             const std::unordered_map<RDNode *, RDNode *>& returns)
+{
+    ModRefSummary& summary = summaries[F];
+
+    // definitions of unknown memory are queried on every use
+    summary.touched.insert(UNKNOWN_MEMORY);
+
+    std::set<RDNode *> visited;
+    std::vector<RDNode *> to_process{subg.root};
+    while (!to_process.empty()) {
+        RDNode *cur = to_process.back();
+        to_process.pop_back();
+
+        if (!visited.insert(cur).second)
+            continue;
+
+        for (const DefSite& ds : cur->defs)
+            summary.mod.insert(ds.target);
+
+        if (cur == subg.ret)
+            continue;
+
+        auto it = returns.find(cur);
+        if (it != returns.end())
+            to_process.push_back(it->second);
+
+        for (RDNode *succ : cur->getSuccessors()) {
+            if (roots.count(succ) == 0)
+                to_process.push_back(succ);
+        }
+    }
+
+    summary.touched.insert(summary.mod.begin(), summary.mod.end());
+
+    for (const llvm::BasicBlock& block : *F) {
+        for (const llvm::Instruction& Inst : block) {
+            if (auto LI = llvm::dyn_cast<llvm::LoadInst>(&Inst)) {
+                addRef(summary, LI->getPointerOperand());
+            } else if (auto CInst = llvm::dyn_cast<llvm::CallInst>(&Inst)) {
+                for (unsigned int i = 0; i < CInst->getNumArgOperands(); ++i) {
+                    const llvm::Value *arg = CInst->getArgOperand(i);
+                    if (arg->getType()->isPointerTy())
+                        addRef(summary, arg);
+                }
+            }
+        }
+    }
+}
+
+void LLVMRDBuilderDense::computeModRefSummaries()
+{
+    std::set<RDNode *> roots;
+    for (auto& it : subgraphs_map)
+        roots.insert(it.second.root);
+
+    std::unordered_map<RDNode *, RDNode *> returns;
+    for (const CallSite& cs : callSites)
+        returns.emplace(cs.callNode, cs.returnNode);
+
+    for (auto& it : subgraphs_map) {
+        computeLocalSummary(llvm::cast<llvm::Function>(it.first),
+                            it.second, roots, returns);
+    }
+
+    // propagate the summaries bottom-up in the call graph
+    // (until a fixpoint, because of recursion)
+    ADT::QueueFIFO<GenericCallGraph<const llvm::Function *>::FuncNode *> queue;
+    std::set<const llvm::Function *> queued;
+    for (auto& it : callGraph) {
+        queue.push(&it.second);
+        queued.insert(it.first);
+    }
+
+    while (!queue.empty()) {
+        auto *fnode = queue.pop();
+        queued.erase(fnode->value);
+
+        ModRefSummary& summary = summaries[fnode->value];
+        bool changed = false;
+        for (auto *callee : fnode->getCalls()) {
+            const ModRefSummary& cs = summaries[callee->value];
+            for (RDNode *target : cs.mod)
+                changed |= summary.mod.insert(target).second;
+            for (RDNode *target : cs.touched)
+                changed |= summary.touched.insert(target).second;
+            if (cs.refUnknown && !summary.refUnknown) {
+                summary.refUnknown = true;
+                changed = true;
+            }
+        }
+
+        if (!changed)
+            continue;
+
+        for (auto *caller : fnode->getCallers()) {
+            if (queued.insert(caller->value).second)
+                queue.push(caller);
+        }
+    }
+}
+
+///
+// Restrict the definitions that flow into procedures to the memory that
+// the procedures may touch and the definitions that flow out of procedures
+// to the memory that the procedures may modify. The rest of the definitions
+// bypass the procedures on the call sites.
+void LLVMRDBuilderDense::applyModRefSummaries()
+{
+    for (auto& it : subgraphs_map) {
+        const ModRefSummary& summary
+            = summaries[llvm::cast<llvm::Function>(it.first)];
+        if (!summary.refUnknown)
+            it.second.root->filter = DefSiteFilter(&summary.touched);
+        it.second.ret->filter = DefSiteFilter(&summary.mod);
+    }
+
+    for (const CallSite& cs : callSites) {
+        RDNode *bypass = new RDNode(RDNodeType::NOOP);
+        addNode(bypass);
+        bypass->filter = DefSiteFilter(&summaries[cs.callee].mod,
+                                       true /* exclude */);
+        makeEdge(cs.callNode, bypass);
+        makeEdge(bypass, cs.returnNode);
+    }
+}
+
 std::pair<RDNode *, RDNode *> LLVMRDBuilderDense::buildGlobals()
 {
     RDNode *cur = nullptr, *prev, *first = nullptr;
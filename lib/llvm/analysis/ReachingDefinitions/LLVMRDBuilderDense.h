@@ -1,6 +1,7 @@
 #ifndef _LLVM_DG_RD_DENSE_H_
 #define _LLVM_DG_RD_DENSE_H_
 
+#include <set>
 #include <vector>
 #include <unordered_map>
 
@@ -23,6 +24,7 @@
 #pragma GCC diagnostic pop
 #endif
 
+#include "dg/analysis/CallGraph.h"
 #include "dg/analysis/ReachingDefinitions/ReachingDefinitions.h"
 #include "llvm/analysis/ReachingDefinitions/LLVMRDBuilder.h"
 
@@ -113,6 +115,38 @@ private:
 
     bool buildUses{false};
 
+    // calls of defined functions (call node, return node, callee)
+    struct CallSite {
+        RDNode *callNode;
+        RDNode *returnNode;
+        const llvm::Function *callee;
+    };
+
+    std::vector<CallSite> callSites;
+    GenericCallGraph<const llvm::Function *> callGraph;
+
+    void addCallSite(RDNode *callNode, RDNode *returnNode,
+                     const llvm::Function *callee, const llvm::CallInst *CInst);
+
+    // memory that a function (or any function that it calls)
+    // may define or read
+    struct ModRefSummary {
+        std::set<RDNode *> mod;
+        // mod + ref
+        std::set<RDNode *> touched;
+        // we do not know what memory the function reads
+        bool refUnknown{false};
+    };
+
+    std::unordered_map<const llvm::Function *, ModRefSummary> summaries;
+
+    void addRef(ModRefSummary& summary, const llvm::Value *val);
+    void computeLocalSummary(const llvm::Function *F, const Subgraph& subg,
+                             const std::set<RDNode *>& roots,
+                             const std::unordered_map<RDNode *, RDNode *>& returns);
+    void computeModRefSummaries();
+    void applyModRefSummaries();
+
     bool isInlineAsm(const llvm::Instruction *instruction);
 
     void matchForksAndJoins();
@@ -16,7 +16,10 @@
 #endif
 
 #include "dg/analysis/ReachingDefinitions/SemisparseRda.h"
+#include "dg/analysis/ReachingDefinitions/DemandDrivenRda.h"
+#include "dg/analysis/ReachingDefinitions/MemorySsaRda.h"
 #include "dg/llvm/analysis/ReachingDefinitions/ReachingDefinitions.h"
+#include "dg/util/Trace.h"
 
 #include "LLVMRDBuilder.h"
 #include "LLVMRDBuilderDense.h"
@@ -31,6 +34,7 @@ LLVMReachingDefinitions::~LLVMReachingDefinitions() {
 }
 
 void LLVMReachingDefinitions::initializeSparseRDA() {
+    DG_TRACE_SCOPE("LLVMReachingDefinitions::buildGraph");
     builder = new LLVMRDBuilderSemisparse(m, pta, _options);
     // let the compiler do copy-ellision
     auto graph = builder->build();
@@ -40,6 +44,7 @@ void LLVMReachingDefinitions::initializeSparseRDA() {
 }
 
 void LLVMReachingDefinitions::initializeDenseRDA() {
+    DG_TRACE_SCOPE("LLVMReachingDefinitions::buildGraph");
     builder = new LLVMRDBuilderDense(m, pta, _options);
     auto graph = builder->build();
 
@@ -47,6 +52,28 @@ void LLVMReachingDefinitions::initializeDenseRDA() {
                     new ReachingDefinitionsAnalysis(std::move(graph)));
 }
 
+void LLVMReachingDefinitions::initializeDemandDrivenRDA() {
+    DG_TRACE_SCOPE("LLVMReachingDefinitions::buildGraph");
+    // the demand-driven analysis works on the same graph
+    // as the dense analysis
+    builder = new LLVMRDBuilderDense(m, pta, _options);
+    auto graph = builder->build();
+
+    demandRDA = new DemandDrivenRda(std::move(graph), _options);
+    RDA = std::unique_ptr<ReachingDefinitionsAnalysis>(demandRDA);
+}
+
+void LLVMReachingDefinitions::initializeMemorySsaRDA() {
+    DG_TRACE_SCOPE("LLVMReachingDefinitions::buildGraph");
+    // the chains are built over the graph from the dense builder,
+    // the definitions in the graph are given by our points-to analysis
+    builder = new LLVMRDBuilderDense(m, pta, _options);
+    auto graph = builder->build();
+
+    RDA = std::unique_ptr<ReachingDefinitionsAnalysis>(
+                    new MemorySsaRda(std::move(graph), _options));
+}
+
 RDNode *LLVMReachingDefinitions::getNode(const llvm::Value *val) {
     return builder->getNode(val);
 }
@@ -71,6 +98,13 @@ const RDNode *LLVMReachingDefinitions::getMapping(const llvm::Value *val) const
     return builder->getMapping(val);
 }
 
+size_t LLVMReachingDefinitions::getReachingDefinitions(RDNode *where, RDNode *what,
+                                                       const Offset& off,
+                                                       const Offset& len,
+                                                       std::set<RDNode *>& ret) {
+    assert(RDA);
+    return RDA->getReachingDefinitions(where, what, off, len, ret);
+}
 
 std::set<llvm::Value *>
 LLVMReachingDefinitions::getLLVMReachingDefinitions(llvm::Value *where, llvm::Value *what,
@@ -91,7 +125,7 @@ LLVMReachingDefinitions::getLLVMReachingDefinitions(llvm::Value *where, llvm::Va
         return defs;
     }
 
-    loc->getReachingDefinitions(val, offset, len, rdDefs);
+    getReachingDefinitions(loc, val, offset, len, rdDefs);
     if (rdDefs.empty()) {
         llvm::GlobalVariable *GV = llvm::dyn_cast<llvm::GlobalVariable>(what);
         if (!GV || !GV->hasInitializer()) {
@@ -109,8 +143,8 @@ LLVMReachingDefinitions::getLLVMReachingDefinitions(llvm::Value *where, llvm::Va
     }
 
     // Get reaching definitions for UNKNOWN_MEMORY, those can be our definitions.
-    loc->getReachingDefinitions(rd::UNKNOWN_MEMORY, Offset::UNKNOWN,
-                                Offset::UNKNOWN, rdDefs);
+    getReachingDefinitions(loc, rd::UNKNOWN_MEMORY, Offset::UNKNOWN,
+                           Offset::UNKNOWN, rdDefs);
 
     //map the values
     for (RDNode *nd : rdDefs) {
@@ -0,0 +1,386 @@
+// Microbenchmarks of the containers from include/dg/ADT
+// and of the containers that the analyses build on them.
+//
+// Every benchmark is run for all the sizes and densities given by the options
+// (-sizes 16,256,4096 -densities 0.01,0.5). The size is the number of
+// the elements that the benchmark works with and the density says how
+// densely the elements fill their range (the elements are taken from
+// [0, size/density)). Use -filter to run only some of the benchmarks
+// and -format csv|json -o file to store the results.
+
+#include <cassert>
+#include <random>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "dg/ADT/Bits.h"
+#include "dg/ADT/Bitvector.h"
+#include "dg/ADT/NumberSet.h"
+#include "dg/analysis/PointsTo/PointsToSet.h"
+#include "dg/analysis/ReachingDefinitions/DisjunctiveIntervalMap.h"
+#include "dg/analysis/ReachingDefinitions/RDMap.h"
+#include "dg/analysis/ReachingDefinitions/ReachingDefinitions.h"
+
+#include "benchmark.h"
+
+using namespace dg::ADT;
+using dg::benchmark::Runner;
+using dg::benchmark::doNotOptimize;
+
+namespace {
+
+// 'size' distinct numbers from [0, size/density) in a random order
+std::vector<uint64_t> randomElements(size_t size, double density,
+                                     unsigned seed) {
+    std::mt19937_64 rand(seed);
+    uint64_t range = std::max<uint64_t>(size, static_cast<uint64_t>(size / density));
+    std::uniform_int_distribution<uint64_t> dist(0, range - 1);
+
+    std::vector<uint64_t> elems;
+    std::unordered_set<uint64_t> seen;
+    while (elems.size() < size) {
+        uint64_t x = dist(rand);
+        if (seen.insert(x).second)
+            elems.push_back(x);
+    }
+    return elems;
+}
+
+template <typename T>
+T *fakePointer(uint64_t n) {
+    // never dereferenced, just distinct
+    return reinterpret_cast<T *>((n + 1) * 16);
+}
+
+///
+// SparseBitvector, BitvectorNumberSet and SmallNumberSet
+void benchmarkSets(Runner& runner, size_t size, double density) {
+    const auto A = randomElements(size, density, 1);
+    const auto B = randomElements(size, density, 2);
+
+    SparseBitvector bvA, bvB;
+    for (auto x : A)
+        bvA.set(x);
+    for (auto x : B)
+        bvB.set(x);
+    const SparseBitvector bvACopy(bvA);
+
+    runner.run("SparseBitvector/set", size, density, [&]() {
+        SparseBitvector bv;
+        for (auto x : A)
+            bv.set(x);
+        doNotOptimize(bv);
+    });
+
+    runner.run("SparseBitvector/get", size, density, [&]() {
+        size_t found = 0;
+        for (auto x : B)
+            found += bvA.get(x);
+        doNotOptimize(found);
+    });
+
+    runner.run("SparseBitvector/copy", size, density, [&]() {
+        SparseBitvector bv(bvA);
+        doNotOptimize(bv);
+    });
+
+    runner.run("SparseBitvector/copy+union", size, density, [&]() {
+        SparseBitvector bv(bvA);
+        bool changed = bv.set(bvB);
+        doNotOptimize(changed);
+    });
+
+    // the most frequent union in a fixpoint computation
+    // is the one that does not change anything
+    runner.run("SparseBitvector/union-unchanged", size, density, [&]() {
+        bool changed = bvA.set(bvACopy);
+        doNotOptimize(changed);
+    });
+
+    runner.run("SparseBitvector/size", size, density, [&]() {
+        size_t s = bvA.size();
+        doNotOptimize(s);
+    });
+
+    runner.run("SparseBitvector/iterate", size, density, [&]() {
+        uint64_t sum = 0;
+        for (auto x : bvA)
+            sum += x;
+        doNotOptimize(sum);
+    });
+
+    runner.run("BitvectorNumberSet/add", size, density, [&]() {
+        BitvectorNumberSet S;
+        for (auto x : A)
+            S.add(x);
+        doNotOptimize(S);
+    });
+
+    // the small set holds the numbers below 64, the others lift it
+    runner.run("SmallNumberSet/add", size, density, [&]() {
+        SmallNumberSet S;
+        for (auto x : A)
+            S.add(x);
+        doNotOptimize(S);
+    });
+
+    SmallNumberSet small;
+    for (auto x : A)
+        small.add(x);
+
+    runner.run("SmallNumberSet/has", size, density, [&]() {
+        size_t found = 0;
+        for (auto x : B)
+            found += small.has(x);
+        doNotOptimize(found);
+    });
+
+    runner.run("SmallNumberSet/iterate", size, density, [&]() {
+        uint64_t sum = 0;
+        for (auto x : small)
+            sum += x;
+        doNotOptimize(sum);
+    });
+}
+
+///
+// Bits (the elements are taken modulo 64)
+void benchmarkBits(Runner& runner, size_t size, double density) {
+    auto A = randomElements(size, density, 1);
+    for (auto& x : A)
+        x %= Bits<uint64_t>::bitsNum();
+
+    runner.run("Bits/set", size, density, [&]() {
+        Bits<uint64_t> bits;
+        for (auto x : A)
+            bits.set(x);
+        doNotOptimize(bits);
+    });
+
+    Bits<uint64_t> bits;
+    for (auto x : A)
+        bits.set(x);
+
+    runner.run("Bits/get", size, density, [&]() {
+        size_t found = 0;
+        for (auto x : A)
+            found += bits.get(x + 1);
+        doNotOptimize(found);
+    });
+
+    runner.run("Bits/size", size, density, [&]() {
+        size_t s = bits.size();
+        doNotOptimize(s);
+    });
+
+    runner.run("Bits/iterate", size, density, [&]() {
+        uint64_t sum = 0;
+        for (auto x : bits)
+            sum += x;
+        doNotOptimize(sum);
+    });
+}
+
+///
+// DisjunctiveIntervalMap, the intervals have the length 1 to 8
+// and start at the (scaled) elements, so that the sparse ones do not
+// overlap and the dense ones overlap a lot
+void benchmarkIntervalMap(Runner& runner, size_t size, double density) {
+    using MapT = dg::analysis::rd::DisjunctiveIntervalMap<int, int64_t>;
+
+    const auto A = randomElements(size, density, 1);
+    const auto B = randomElements(size, density, 2);
+    auto interval = [](uint64_t x) {
+        int64_t start = static_cast<int64_t>(x * 4);
+        return MapT::IntervalT(start, start + static_cast<int64_t>(x % 8));
+    };
+
+    runner.run("DisjunctiveIntervalMap/add", size, density, [&]() {
+        MapT M;
+        int val = 0;
+        for (auto x : A)
+            M.add(interval(x), ++val);
+        doNotOptimize(M);
+    });
+
+    runner.run("DisjunctiveIntervalMap/update", size, density, [&]() {
+        MapT M;
+        int val = 0;
+        for (auto x : A)
+            M.update(interval(x), ++val);
+        doNotOptimize(M);
+    });
+
+    MapT M;
+    int val = 0;
+    for (auto x : A)
+        M.add(interval(x), ++val);
+
+    runner.run("DisjunctiveIntervalMap/overlaps", size, density, [&]() {
+        size_t found = 0;
+        for (auto x : B)
+            found += M.overlaps(interval(x));
+        doNotOptimize(found);
+    });
+
+    runner.run("DisjunctiveIntervalMap/overlapsFull", size, density, [&]() {
+        size_t found = 0;
+        for (auto x : B)
+            found += M.overlapsFull(interval(x));
+        doNotOptimize(found);
+    });
+}
+
+///
+// PointsToSet (bitvectors of offsets) and SimplePointsToSet (std::set).
+// The density also says how many offsets the targets have:
+// the denser set has less targets with more offsets.
+template <typename PTSetT>
+void benchmarkPointsToSet(Runner& runner, const std::string& name,
+                          size_t size, double density) {
+    using namespace dg::analysis::pta;
+    using dg::analysis::Offset;
+
+    const uint64_t targets = std::max<uint64_t>(1, static_cast<uint64_t>(size * (1.0 - density)));
+    auto pointers = [targets](const std::vector<uint64_t>& elems) {
+        std::vector<Pointer> ptrs;
+        for (auto x : elems)
+            ptrs.emplace_back(fakePointer<PSNode>(x % targets), Offset(x / targets));
+        return ptrs;
+    };
+    const auto A = pointers(randomElements(size, density, 1));
+    const auto B = pointers(randomElements(size, density, 2));
+
+    runner.run(name + "/add", size, density, [&]() {
+        PTSetT S;
+        for (const auto& ptr : A)
+            S.add(ptr);
+        doNotOptimize(S);
+    });
+
+    PTSetT SA, SB;
+    for (const auto& ptr : A)
+        SA.add(ptr);
+    for (const auto& ptr : B)
+        SB.add(ptr);
+    const PTSetT SACopy(SA);
+
+    runner.run(name + "/copy+union", size, density, [&]() {
+        PTSetT S(SA);
+        bool changed = S.add(SB);
+        doNotOptimize(changed);
+    });
+
+    runner.run(name + "/union-unchanged", size, density, [&]() {
+        bool changed = SA.add(SACopy);
+        doNotOptimize(changed);
+    });
+
+    runner.run(name + "/pointsTo", size, density, [&]() {
+        size_t found = 0;
+        for (const auto& ptr : B)
+            found += SA.pointsTo(ptr);
+        doNotOptimize(found);
+    });
+
+    runner.run(name + "/iterate", size, density, [&]() {
+        uint64_t sum = 0;
+        for (const auto& ptr : SA)
+            sum += *ptr.offset;
+        doNotOptimize(sum);
+    });
+}
+
+///
+// RDMap, the denser map has less defined memory objects
+// with more definitions (as in benchmarkPointsToSet)
+void benchmarkRDMap(Runner& runner, size_t size, double density) {
+    using namespace dg::analysis::rd;
+
+    const uint64_t targets = std::max<uint64_t>(1, static_cast<uint64_t>(size * (1.0 - density)));
+    std::vector<RDNode> nodes(size);
+    auto defsites = [&](const std::vector<uint64_t>& elems) {
+        std::vector<std::pair<DefSite, RDNode *>> defs;
+        for (auto x : elems)
+            defs.emplace_back(DefSite(&nodes[x % targets], (x / targets) * 4, 4),
+                              &nodes[x % size]);
+        return defs;
+    };
+    const auto A = defsites(randomElements(size, density, 1));
+    const auto B = defsites(randomElements(size, density, 2));
+
+    runner.run("RDMap/add", size, density, [&]() {
+        RDMap M;
+        for (const auto& def : A)
+            M.add(def.first, def.second);
+        doNotOptimize(M);
+    });
+
+    runner.run("RDMap/update", size, density, [&]() {
+        RDMap M;
+        for (const auto& def : A)
+            M.update(def.first, def.second);
+        doNotOptimize(M);
+    });
+
+    RDMap MA, MB;
+    for (const auto& def : A)
+        MA.add(def.first, def.second);
+    for (const auto& def : B)
+        MB.add(def.first, def.second);
+
+    runner.run("RDMap/merge", size, density, [&]() {
+        RDMap M;
+        bool changed = M.merge(&MA);
+        changed |= M.merge(&MB);
+        doNotOptimize(changed);
+    });
+
+    runner.run("RDMap/get", size, density, [&]() {
+        size_t found = 0;
+        std::set<RDNode *> defs;
+        for (const auto& def : B) {
+            found += MA.get(def.first, defs);
+            defs.clear();
+        }
+        doNotOptimize(found);
+    });
+}
+
+} // anonymous namespace
+
+int main(int argc, char *argv[])
+{
+    Runner::Options opts;
+    if (!dg::benchmark::parseOptions(argc, argv, opts)) {
+        std::cerr << "Usage: " << argv[0]
+                  << " [-sizes N,...] [-densities D,...] [-warmup N]"
+                     " [-repetitions N] [-min-time SEC] [-filter STR]"
+                     " [-format csv|json] [-o FILE]\n";
+        return 1;
+    }
+
+    Runner runner(opts);
+    for (size_t size : opts.sizes) {
+        for (double density : opts.densities) {
+            if (size == 0 || density <= 0.0 || density > 1.0) {
+                std::cerr << "Invalid size or density: " << size
+                          << ", " << density << "\n";
+                return 1;
+            }
+
+            benchmarkSets(runner, size, density);
+            benchmarkBits(runner, size, density);
+            benchmarkIntervalMap(runner, size, density);
+            benchmarkPointsToSet<dg::analysis::pta::PointsToSet>(
+                runner, "PointsToSet", size, density);
+            benchmarkPointsToSet<dg::analysis::pta::SimplePointsToSet>(
+                runner, "SimplePointsToSet", size, density);
+            benchmarkRDMap(runner, size, density);
+        }
+    }
+
+    return runner.write() ? 0 : 1;
+}
@@ -6,6 +6,7 @@
 
 #include "dg/ADT/Queue.h"
 #include "dg/ADT/Bitvector.h"
+#include "dg/ADT/IndexedMap.h"
 #include "dg/analysis/ReachingDefinitions/RDMap.h"
 
 using namespace dg::ADT;
@@ -150,6 +151,52 @@ public:
     }
 };
 
+class TestIndexedMap : public Test
+{
+public:
+    TestIndexedMap() : Test("indexed map test")
+    {}
+
+    void test()
+    {
+        IndexedMap<int, int> M;
+        check(M.empty(), "empty map not empty");
+        check(M.find(3) == M.end(), "found element in empty map");
+
+        check(M.emplace(30, 3).second, "emplace failed");
+        check(M.emplace(10, 1).second, "emplace failed");
+        check(!M.emplace(30, 4).second, "emplaced a present key");
+        M[20] = 2;
+        check(M.size() == 3, "wrong size");
+        check(M.find(30)->second == 3, "wrong value");
+        check(M.count(20) == 1 && M.count(40) == 0, "count bug");
+        check(M.getIndex(10) == 1, "wrong dense index");
+
+        // iteration goes in the order of insertion
+        int keys[] = {30, 10, 20};
+        int i = 0;
+        for (auto& it : M)
+            check(it.first == keys[i++], "wrong iteration order");
+        check(i == 3, "wrong number of iterated elements");
+
+        // erasing while iterating
+        for (auto& it : M) {
+            if (it.first != 20)
+                M.erase(it.first);
+        }
+        check(M.size() == 1, "wrong size after erase");
+        check(M.find(10) == M.end(), "found erased element");
+        check(M.begin()->first == 20, "wrong first element");
+        check(++M.begin() == M.end(), "iterated over erased element");
+
+        M[10] = 5;
+        M.compact();
+        check(M.getIndex(20) == 0 && M.getIndex(10) == 1, "compact bug");
+        check(M.find(10)->second == 5, "wrong value after compact");
+        check(M.erase(30) == 0, "erased non-existing element");
+    }
+};
+
 }; // namespace tests
 }; // namespace dg
 
@@ -162,6 +209,7 @@ int main()
     Runner.add(new TestFIFO());
     Runner.add(new TestPrioritySet());
     Runner.add(new TestIntervalsHandling());
+    Runner.add(new TestIndexedMap());
 
     return Runner();
 }
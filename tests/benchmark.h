@@ -0,0 +1,255 @@
+#ifndef _DG_TESTS_BENCHMARK_H_
+#define _DG_TESTS_BENCHMARK_H_
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace dg {
+namespace benchmark {
+
+// keep the compiler from optimizing the value away
+template <typename T>
+inline void doNotOptimize(const T& val) {
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r"(&val) : "memory");
+#else
+    static volatile const void *sink;
+    sink = &val;
+#endif
+}
+
+///
+// A minimal framework for microbenchmarks. A benchmark is a function
+// that does one iteration of the measured work. The runner runs it
+// a few times to warm up and to find how many iterations take at least
+// the minimal time, and then measures the given number of repetitions
+// of these iterations. The results are the statistics of the time
+// of one iteration over the repetitions.
+class Runner {
+public:
+    struct Options {
+        std::vector<size_t> sizes{16, 256, 4096};
+        std::vector<double> densities{0.01, 0.5};
+        unsigned warmup{2};
+        unsigned repetitions{10};
+        // the minimal time of one repetition (in seconds)
+        double minTime{0.01};
+        // run only the benchmarks whose name contains this string
+        std::string filter;
+        std::string format{"csv"};
+        std::string output;
+    };
+
+    struct Result {
+        std::string name;
+        size_t size;
+        double density;
+        uint64_t iterations;
+        unsigned repetitions;
+        // the time of one iteration (in nanoseconds)
+        double min, max, mean, median, stddev;
+    };
+
+    Runner(const Options& opts) : options(opts) {}
+
+    const Options& getOptions() const { return options; }
+    const std::vector<Result>& getResults() const { return results; }
+
+    bool enabled(const std::string& name) const {
+        return options.filter.empty() ||
+               name.find(options.filter) != std::string::npos;
+    }
+
+    void run(const std::string& name, size_t size, double density,
+             const std::function<void()>& iteration) {
+        if (!enabled(name))
+            return;
+
+        for (unsigned i = 0; i < options.warmup; ++i)
+            iteration();
+
+        // calibrate the number of iterations of one repetition
+        uint64_t iterations = 1;
+        while (true) {
+            double t = measure(iteration, iterations);
+            if (t >= options.minTime || iterations >= (1ULL << 30))
+                break;
+            // aim a bit above the minimal time
+            double factor = t > 0 ? 1.4 * options.minTime / t : 10.0;
+            iterations = std::max(iterations + 1,
+                                  static_cast<uint64_t>(iterations * std::min(factor, 10.0)));
+        }
+
+        std::vector<double> times;
+        for (unsigned i = 0; i < options.repetitions; ++i)
+            times.push_back(measure(iteration, iterations) * 1e9 / iterations);
+
+        results.push_back(statistics(name, size, density, iterations, times));
+        const Result& r = results.back();
+        const auto flags = std::cerr.flags();
+        const auto precision = std::cerr.precision();
+        std::cerr << std::left << std::setw(40) << name
+                  << " size " << std::setw(6) << size
+                  << " density " << std::setw(5) << density
+                  << " median " << std::fixed << std::setprecision(1)
+                  << r.median << " ns\n";
+        std::cerr.flags(flags);
+        std::cerr.precision(precision);
+    }
+
+    void writeCSV(std::ostream& out) const {
+        out << "benchmark,size,density,iterations,repetitions,"
+               "min_ns,max_ns,mean_ns,median_ns,stddev_ns\n";
+        for (const Result& r : results) {
+            out << r.name << "," << r.size << "," << r.density << ","
+                << r.iterations << "," << r.repetitions << ","
+                << r.min << "," << r.max << "," << r.mean << ","
+                << r.median << "," << r.stddev << "\n";
+        }
+    }
+
+    void writeJSON(std::ostream& out) const {
+        out << "[";
+        for (size_t i = 0; i < results.size(); ++i) {
+            const Result& r = results[i];
+            out << (i == 0 ? "\n" : ",\n");
+            out << "{\"benchmark\": \"" << r.name << "\", \"size\": " << r.size
+                << ", \"density\": " << r.density
+                << ", \"iterations\": " << r.iterations
+                << ", \"repetitions\": " << r.repetitions
+                << ", \"min_ns\": " << r.min << ", \"max_ns\": " << r.max
+                << ", \"mean_ns\": " << r.mean << ", \"median_ns\": " << r.median
+                << ", \"stddev_ns\": " << r.stddev << "}";
+        }
+        out << "\n]\n";
+    }
+
+    // write the results in the format and to the file from the options
+    // (to the standard output if there is no file)
+    bool write() const {
+        std::ofstream file;
+        if (!options.output.empty()) {
+            file.open(options.output);
+            if (!file.is_open()) {
+                std::cerr << "Failed opening " << options.output << "\n";
+                return false;
+            }
+        }
+
+        std::ostream& out = options.output.empty() ? std::cout : file;
+        if (options.format == "json")
+            writeJSON(out);
+        else
+            writeCSV(out);
+        return out.good();
+    }
+
+private:
+    const Options options;
+    std::vector<Result> results;
+
+    using Clock = std::chrono::steady_clock;
+
+    static double measure(const std::function<void()>& iteration,
+                          uint64_t iterations) {
+        auto start = Clock::now();
+        for (uint64_t i = 0; i < iterations; ++i)
+            iteration();
+        return std::chrono::duration<double>(Clock::now() - start).count();
+    }
+
+    static Result statistics(const std::string& name, size_t size,
+                             double density, uint64_t iterations,
+                             std::vector<double>& times) {
+        Result r;
+        r.name = name;
+        r.size = size;
+        r.density = density;
+        r.iterations = iterations;
+        r.repetitions = static_cast<unsigned>(times.size());
+
+        std::sort(times.begin(), times.end());
+        r.min = times.front();
+        r.max = times.back();
+        size_t n = times.size();
+        r.median = n % 2 ? times[n / 2] : (times[n / 2 - 1] + times[n / 2]) / 2;
+
+        double sum = 0.0;
+        for (double t : times)
+            sum += t;
+        r.mean = sum / n;
+
+        double var = 0.0;
+        for (double t : times)
+            var += (t - r.mean) * (t - r.mean);
+        r.stddev = n > 1 ? std::sqrt(var / (n - 1)) : 0.0;
+
+        return r;
+    }
+};
+
+template <typename T>
+std::vector<T> parseList(const char *str) {
+    std::vector<T> ret;
+    std::istringstream ss(str);
+    std::string item;
+    while (std::getline(ss, item, ',')) {
+        std::istringstream is(item);
+        T val;
+        if (is >> val)
+            ret.push_back(val);
+    }
+    return ret;
+}
+
+// parse the options of the runner, return false on an unknown option
+inline bool parseOptions(int argc, char *argv[], Runner::Options& opts) {
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        const char *val = i + 1 < argc ? argv[i + 1] : nullptr;
+
+        if (!val) {
+            return false;
+        } else if (strcmp(arg, "-sizes") == 0) {
+            opts.sizes = parseList<size_t>(val);
+        } else if (strcmp(arg, "-densities") == 0) {
+            opts.densities = parseList<double>(val);
+        } else if (strcmp(arg, "-warmup") == 0) {
+            opts.warmup = static_cast<unsigned>(std::strtoul(val, nullptr, 10));
+        } else if (strcmp(arg, "-repetitions") == 0) {
+            opts.repetitions = static_cast<unsigned>(std::strtoul(val, nullptr, 10));
+        } else if (strcmp(arg, "-min-time") == 0) {
+            opts.minTime = std::strtod(val, nullptr);
+        } else if (strcmp(arg, "-filter") == 0) {
+            opts.filter = val;
+        } else if (strcmp(arg, "-format") == 0) {
+            opts.format = val;
+        } else if (strcmp(arg, "-o") == 0) {
+            opts.output = val;
+        } else {
+            return false;
+        }
+        ++i;
+    }
+
+    if (opts.repetitions == 0)
+        opts.repetitions = 1;
+
+    return opts.format == "csv" || opts.format == "json";
+}
+
+} // namespace benchmark
+} // namespace dg
+
+#endif // _DG_TESTS_BENCHMARK_H_
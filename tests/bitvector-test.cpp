@@ -1,7 +1,10 @@
 #define CATCH_CONFIG_MAIN
 #include "catch.hpp"
 
+#include <algorithm>
+#include <iterator>
 #include <random>
+#include <set>
 
 #include "dg/ADT/Bitvector.h"
 
@@ -205,3 +208,127 @@ TEST_CASE("Merge random bitvectors (union)", "SparseBitvector") {
 //    B2.merge(B1);
 //    REQUIRE(B1 == B2);
 }
+
+static std::set<uint64_t> toSet(const SparseBitvector& B) {
+    std::set<uint64_t> S;
+    for (auto x : B)
+        S.insert(x);
+    return S;
+}
+
+TEST_CASE("Size", "SparseBitvector") {
+    SparseBitvector B;
+    REQUIRE(B.size() == 0);
+    B.set(5);
+    B.set(5);
+    B.set(64);
+    B.set(1000);
+    REQUIRE(B.size() == 3);
+    REQUIRE(B.unset(5) == true);
+    REQUIRE(B.unset(5) == false);
+    REQUIRE(B.unset(6) == false);
+    REQUIRE(B.size() == 2);
+    REQUIRE(B.unset(64) == true);
+    REQUIRE(B.unset(1000) == true);
+    REQUIRE(B.size() == 0);
+    REQUIRE(B.empty());
+    REQUIRE(B.begin() == B.end());
+}
+
+TEST_CASE("Iterator order", "SparseBitvector") {
+    SparseBitvector B;
+    std::default_random_engine generator;
+    std::uniform_int_distribution<uint64_t> distribution(0, 100000);
+
+    for (int i = 0; i < 1000; ++i)
+        B.set(distribution(generator));
+
+    uint64_t last = 0;
+    bool first = true;
+    size_t n = 0;
+    for (auto x : B) {
+        REQUIRE((first || last < x));
+        first = false;
+        last = x;
+        ++n;
+    }
+    REQUIRE(n == B.size());
+}
+
+TEST_CASE("Operations on random bitvectors", "SparseBitvector") {
+    std::default_random_engine generator;
+
+    // different densities so that the chunks are sometimes shared
+    // and sometimes not
+    for (uint64_t range : {100UL, 1000UL, 100000UL, ~static_cast<uint64_t>(0)}) {
+        std::uniform_int_distribution<uint64_t> distribution(0, range);
+
+        for (int round = 0; round < 20; ++round) {
+            SparseBitvector B1, B2;
+            std::set<uint64_t> S1, S2;
+            for (int i = 0; i < 200; ++i) {
+                auto x = distribution(generator);
+                auto y = distribution(generator);
+                B1.set(x);
+                S1.insert(x);
+                B2.set(y);
+                S2.insert(y);
+            }
+
+            REQUIRE(toSet(B1) == S1);
+            REQUIRE(B1.size() == S1.size());
+
+            std::set<uint64_t> U(S1), I, D;
+            U.insert(S2.begin(), S2.end());
+            std::set_intersection(S1.begin(), S1.end(), S2.begin(), S2.end(),
+                                  std::inserter(I, I.begin()));
+            std::set_difference(S1.begin(), S1.end(), S2.begin(), S2.end(),
+                                std::inserter(D, D.begin()));
+
+            SparseBitvector BU(B1);
+            REQUIRE(BU.set(B2) == (U != S1));
+            REQUIRE(toSet(BU) == U);
+            REQUIRE(BU.size() == U.size());
+            // nothing changes the second time
+            REQUIRE(BU.set(B2) == false);
+            REQUIRE(BU.set(B1) == false);
+
+            SparseBitvector BI(B1);
+            REQUIRE(BI.intersect(B2) == (I != S1));
+            REQUIRE(toSet(BI) == I);
+            REQUIRE(BI.size() == I.size());
+            REQUIRE(BI.intersect(B2) == false);
+
+            SparseBitvector BD(B1);
+            REQUIRE(BD.unset(B2) == (D != S1));
+            REQUIRE(toSet(BD) == D);
+            REQUIRE(BD.size() == D.size());
+            REQUIRE(BD.unset(B2) == false);
+
+            // (B1 - B2) | (B1 & B2) == B1
+            REQUIRE(BD.set(BI) == !I.empty());
+            REQUIRE(BD == B1);
+        }
+    }
+}
+
+TEST_CASE("Operations with itself and empty bitvector", "SparseBitvector") {
+    SparseBitvector B, E;
+    B.set(1);
+    B.set(1000);
+
+    REQUIRE(B.set(B) == false);
+    REQUIRE(B.intersect(B) == false);
+    REQUIRE(B.set(E) == false);
+    REQUIRE(B.unset(E) == false);
+    REQUIRE(B.size() == 2);
+
+    REQUIRE(E.set(B) == true);
+    REQUIRE(E == B);
+
+    REQUIRE(B.intersect(SparseBitvector()) == true);
+    REQUIRE(B.empty());
+
+    REQUIRE(E.unset(E) == true);
+    REQUIRE(E.empty());
+}
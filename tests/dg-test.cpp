@@ -1,11 +1,18 @@
+#include <algorithm>
 #include <cassert>
 #include <cstdarg>
 #include <cstdio>
+#include <set>
+#include <vector>
 
 #include "test-runner.h"
 #include "test-dg.h"
 
 #include "dg/analysis/Slicing.h"
+#include "dg/analysis/SummaryEdges.h"
+#include "dg/analysis/DominatorTree.h"
+#include "dg/analysis/DominanceFrontiers.h"
+#include "dg/analysis/PostDominanceFrontiers.h"
 #include "dg/DG2Dot.h"
 
 namespace dg {
@@ -160,6 +167,34 @@ public:
         check(IT2.insert(&n2), "unique element wrong retval");
 
         check(IT == IT2, "containers with same content does not equal");
+
+        TestNode n3(3);
+        TestNode n4(4);
+        TestNode *nodes[] = {&n4, &n1, &n3, &n4, &n2};
+
+        EdgesContainer<TestNode> IT3;
+        check(IT3.insert(nodes, nodes + 5) == 4, "bulk insert bug");
+        check(IT3.size() == 4, "size() bug");
+        check(IT3.insert(nodes, nodes + 5) == 0, "bulk insert of present elements");
+        check(IT3.contains(&n3) && IT3.contains(&n4), "bulk insert bug");
+
+        // the elements are sorted
+        check(std::is_sorted(IT3.begin(), IT3.end()), "container is not sorted");
+
+        check(IT3.erase(&n3) == 1, "erase bug");
+        check(IT3.erase(&n3) == 0, "erased non-existing element");
+        IT3.intersect(IT);
+        check(IT3 == IT, "intersect bug");
+
+        TestNode n5(5);
+        check(n5.addIncomingDDs(nodes, nodes + 5) == 4, "bulk add of edges bug");
+        check(n5.getRevDataDependenciesNum() == 4, "bulk add of edges bug");
+        check(n4.getDataDependenciesNum() == 1, "bulk add of edges bug");
+        check(n5.addOutcomingCDs(nodes, nodes + 2) == 2, "bulk add of edges bug");
+        check(n1.getRevControlDependenciesNum() == 1, "bulk add of edges bug");
+        n5.isolate();
+        check(n4.getDataDependenciesNum() == 0, "isolate after bulk add bug");
+        check(n1.getRevControlDependenciesNum() == 0, "isolate after bulk add bug");
 #endif
     }
 };
@@ -251,6 +286,7 @@ public:
         nodes_remove_edge_test();
         //nodes_isolate_test();
         nodes_remove_test();
+        nodes_delete_batch_test();
         bb_isolate_test();
         bb_remove_test();
         nodes_in_bb_remove_test();
@@ -337,6 +373,36 @@ private:
         }
     }
 
+    void nodes_delete_batch_test()
+    {
+        TestDG d;
+        TestNode **nodes = create_full_graph(d, NODES_NUM);
+
+        std::vector<TestNode *> removed = {nodes[2], nodes[3], nodes[7]};
+        std::set<TestNode *> isRemoved(removed.begin(), removed.end());
+        d.deleteNodes(removed,
+                      [&isRemoved](TestNode *n) { return isRemoved.count(n) > 0; });
+
+        check(d.size() == NODES_NUM - 3, "should have %d but have %d size",
+              NODES_NUM - 3, d.size());
+        check(d.getNode(3) == nullptr, "deleted node is still in the graph");
+        // the holes after the deleted nodes are removed
+        check(d.getNodes()->getIndex(8) == 5, "nodes not compacted, index %u",
+              static_cast<unsigned>(d.getNodes()->getIndex(8)));
+
+        for (int i = 0; i < NODES_NUM; ++i) {
+            if (i == 2 || i == 3 || i == 7)
+                continue;
+
+            check(nodes[i]->getDataDependenciesNum() == NODES_NUM - 4,
+                  "node[%d]: should have %u but have %u",
+                  i, NODES_NUM - 4, nodes[i]->getDataDependenciesNum());
+            check(nodes[i]->getRevControlDependenciesNum() == NODES_NUM - 4,
+                  "node[%d]: should have %u but have %u",
+                  i, NODES_NUM - 4, nodes[i]->getRevControlDependenciesNum());
+        }
+    }
+
     void bb_isolate_test()
     {
         TestDG d;
@@ -676,6 +742,277 @@ public:
     }
 };
 
+class TestDominators : public Test
+{
+public:
+    TestDominators() : Test("dominators test")
+    {}
+
+    void test()
+    {
+#if ENABLE_CFG
+        TestNode n1(1), n2(2), n3(3), n4(4), n5(5), n6(6), n7(7);
+        TestBBlock B1(&n1), B2(&n2), B3(&n3), B4(&n4),
+                   B5(&n5), B6(&n6), B7(&n7);
+
+        //  B1 -> B2, B3, B6
+        //  B2 -> B4
+        //  B3 -> B4
+        //  B4 -> B5, B2
+        //  B6 -> B7
+        //  B7 -> B6
+        B1.addSuccessor(&B2);
+        B1.addSuccessor(&B3);
+        B1.addSuccessor(&B6);
+        B2.addSuccessor(&B4);
+        B3.addSuccessor(&B4);
+        B4.addSuccessor(&B5);
+        B4.addSuccessor(&B2);
+        B6.addSuccessor(&B7);
+        B7.addSuccessor(&B6);
+
+        analysis::BBlockDominators<TestNode>::computeDominators(&B1);
+        check(B1.getIDom() == nullptr, "entry has idom");
+        check(B2.getIDom() == &B1, "wrong idom of B2");
+        check(B3.getIDom() == &B1, "wrong idom of B3");
+        check(B4.getIDom() == &B1, "wrong idom of B4");
+        check(B5.getIDom() == &B4, "wrong idom of B5");
+        check(B6.getIDom() == &B1, "wrong idom of B6");
+        check(B7.getIDom() == &B6, "wrong idom of B7");
+        check(B1.getDominators().size() == 4, "wrong dominator tree");
+
+        analysis::DominanceFrontiers<TestNode> df;
+        df.compute(&B1);
+        check(B2.getDomFrontiers().size() == 1 &&
+              *B2.getDomFrontiers().begin() == &B4, "wrong DF of B2");
+        check(B4.getDomFrontiers().size() == 1 &&
+              *B4.getDomFrontiers().begin() == &B2, "wrong DF of B4");
+        check(B7.getDomFrontiers().size() == 1 &&
+              *B7.getDomFrontiers().begin() == &B6, "wrong DF of B7");
+
+        // B6 and B7 do not reach the exit (B5),
+        // so one of them is taken as an additional exit
+        TestBBlock root;
+        analysis::BBlockDominators<TestNode>::computePostDominators(
+                        {&B1, &B2, &B3, &B4, &B5, &B6, &B7}, &root);
+        check(B5.getIPostDom() == &root, "wrong ipdom of B5");
+        check(B4.getIPostDom() == &B5, "wrong ipdom of B4");
+        check(B2.getIPostDom() == &B4, "wrong ipdom of B2");
+        check(B3.getIPostDom() == &B4, "wrong ipdom of B3");
+        check(B1.getIPostDom() == &root, "wrong ipdom of B1");
+        check(B7.getIPostDom() == &root, "wrong ipdom of B7");
+        check(B6.getIPostDom() == &B7, "wrong ipdom of B6");
+
+        analysis::PostDominanceFrontiers<TestNode> pdf;
+        pdf.compute(&root, true);
+        check(B1.controlDependence().contains(&B2), "B2 is not CD on B1");
+        check(B1.controlDependence().contains(&B3), "B3 is not CD on B1");
+        check(B1.controlDependence().contains(&B6), "B6 is not CD on B1");
+        check(B4.controlDependence().contains(&B2), "B2 is not CD on B4");
+        // B1 decides whether we get to B5 or loop forever
+        check(B1.controlDependence().contains(&B5), "B5 is not CD on B1");
+        check(B2.controlDependence().empty(), "B2 has CD");
+#endif // ENABLE_CFG
+    }
+};
+
+class TestSummaryEdges : public Test
+{
+public:
+    TestSummaryEdges() : Test("summary edges test")
+    {}
+
+    static TestNode *addNode(TestDG *dg, int key)
+    {
+        TestNode *n = new TestNode(key);
+        dg->addNode(n);
+        return n;
+    }
+
+    static DGParameters<TestNode> *addParams(TestDG *dg, TestNode *cs,
+                                             TestNode **in, TestNode **out)
+    {
+        auto *params = new DGParameters<TestNode>(cs);
+        auto nodes = params->construct(100, cs ? -cs->getKey() : 100);
+        nodes.first->setDG(dg);
+        nodes.second->setDG(dg);
+        *in = nodes.first;
+        *out = nodes.second;
+        return params;
+    }
+
+    void test()
+    {
+        // the graphs are shared between the call-sites,
+        // just leak them
+        TestDG *main = new TestDG();
+        TestDG *f = new TestDG();
+
+        // int f(int p) { return r(p); }
+        TestNode *fentry = addNode(f, 1);
+        f->setEntry(fentry);
+        TestNode *fin, *fout;
+        f->setParameters(addParams(f, nullptr, &fin, &fout));
+        TestNode *r = addNode(f, 2);
+        fin->addDataDependence(r);
+        r->addDataDependence(fout);
+
+        // x1 = ...; y1 = f(x1); x2 = ...; y2 = f(x2); use(y1);
+        TestNode *mentry = addNode(main, 10);
+        main->setEntry(mentry);
+        TestNode *x1 = addNode(main, 11);
+        TestNode *c1 = addNode(main, 12);
+        TestNode *x2 = addNode(main, 13);
+        TestNode *c2 = addNode(main, 14);
+        TestNode *use = addNode(main, 15);
+
+        TestNode *a1in, *a1out, *a2in, *a2out;
+        c1->setParameters(addParams(main, c1, &a1in, &a1out));
+        c2->setParameters(addParams(main, c2, &a2in, &a2out));
+        for (TestNode *c : {c1, c2}) {
+            c->addSubgraph(f);
+            c->addControlDependence(fentry);
+        }
+
+        x1->addDataDependence(a1in);
+        a1in->addDataDependence(fin);
+        fout->addDataDependence(a1out);
+        a1out->addDataDependence(use);
+        c1->addControlDependence(a1in);
+        c1->addControlDependence(a1out);
+
+        x2->addDataDependence(a2in);
+        a2in->addDataDependence(fin);
+        fout->addDataDependence(a2out);
+        c2->addControlDependence(a2in);
+        c2->addControlDependence(a2out);
+
+        analysis::SummaryEdges<TestNode> summaries;
+        summaries.compute(main);
+        check(summaries.size() == 2, "wrong number of summary edges: %u",
+              summaries.size());
+        check(summaries.getSummary(fout) &&
+              summaries.getSummary(fout)->count(fin) == 1,
+              "missing summary edge fin -> fout");
+        check(summaries.getDescendingCallSite(fout, a1out) == c1,
+              "fout -> a1out is not an edge to the call-site");
+        check(summaries.isAscending(a2in, fin), "a2in -> fin is not ascending");
+
+        // the context-insensitive walk goes from f to both call-sites
+        analysis::WalkAndMark<TestNode> wm;
+        wm.mark(use, 1);
+        check(x2->getSlice() == 1, "x2 not in the context-insensitive slice");
+
+        analysis::TwoPhaseWalkAndMark<TestNode> twm(summaries);
+        twm.mark({use}, 2);
+        for (TestNode *n : {use, a1out, c1, a1in, x1, mentry, fout, r, fin, fentry})
+            check(n->getSlice() == 2, "node %d not in the slice", n->getKey());
+        for (TestNode *n : {x2, a2in, c2})
+            check(n->getSlice() != 2, "node %d in the slice", n->getKey());
+        check(twm.getMarkedNodesNum() < wm.getMarkedNodesNum(),
+              "the two-phase slicing marked %u nodes, the walk %u",
+              twm.getMarkedNodesNum(), wm.getMarkedNodesNum());
+    }
+};
+
+class TestBatchSlicing : public Test
+{
+public:
+    TestBatchSlicing() : Test("batch slicing test")
+    {}
+
+    void test()
+    {
+        TestDG d;
+        TestNode *e = new TestNode(0);
+        TestNode *n1 = new TestNode(1);
+        TestNode *n2 = new TestNode(2);
+        TestNode *n3 = new TestNode(3);
+        TestNode *n4 = new TestNode(4);
+        TestNode *n5 = new TestNode(5);
+        for (TestNode *n : {e, n1, n2, n3, n4, n5})
+            d.addNode(n);
+        d.setEntry(e);
+
+        // n1 -> n2 -> n3 <- n4, n5
+        n1->addDataDependence(n2);
+        n2->addDataDependence(n3);
+        n4->addControlDependence(n3);
+
+        analysis::BatchWalkAndMark<TestNode> batch;
+        batch.mark({{n3}, {n5}, {n2}});
+
+        check(batch.getMask(e) == 7, "wrong mask of the entry: %lu",
+              batch.getMask(e));
+        check(batch.getMask(n1) == 5, "wrong mask of n1: %lu", batch.getMask(n1));
+        check(batch.getMask(n2) == 5, "wrong mask of n2: %lu", batch.getMask(n2));
+        check(batch.getMask(n3) == 1, "wrong mask of n3: %lu", batch.getMask(n3));
+        check(batch.getMask(n4) == 1, "wrong mask of n4: %lu", batch.getMask(n4));
+        check(batch.getMask(n5) == 2, "wrong mask of n5: %lu", batch.getMask(n5));
+
+        // the slices are the same as with the usual walk
+        analysis::WalkAndMark<TestNode> wm;
+        wm.mark(n2, 1);
+        check(batch.materialize(2, 2) == wm.getMarkedNodesNum(),
+              "wrong number of nodes in the slice");
+        for (TestNode *n : {e, n1, n2, n3, n4, n5}) {
+            check((n->getSlice() == 2) == ((batch.getMask(n) & 4) != 0),
+                  "node %d wrongly marked", n->getKey());
+        }
+    }
+};
+
+class TestReadOnlySlicing : public Test
+{
+public:
+    TestReadOnlySlicing() : Test("read-only slicing test")
+    {}
+
+    void test()
+    {
+        TestDG d;
+        TestNode *e = new TestNode(0);
+        TestNode *n1 = new TestNode(1);
+        TestNode *n2 = new TestNode(2);
+        TestNode *n3 = new TestNode(3);
+        TestNode *n4 = new TestNode(4);
+        TestNode *n5 = new TestNode(5);
+        for (TestNode *n : {e, n1, n2, n3, n4, n5})
+            d.addNode(n);
+        d.setEntry(e);
+
+        // e -> n1 -> n2 -> n3 <- n4, n5
+        e->addControlDependence(n1);
+        n1->addDataDependence(n2);
+        n2->addDataDependence(n3);
+        n4->addControlDependence(n3);
+
+        analysis::SliceSet<TestNode> slice;
+        analysis::ReadOnlyWalkAndMark<TestNode>::mark({n3}, slice);
+        for (TestNode *n : {e, n1, n2, n3, n4, n5})
+            check(n->getSlice() == 0, "node %d marked in the graph",
+                  n->getKey());
+
+        // the same nodes as with the usual walk
+        analysis::WalkAndMark<TestNode> wm;
+        wm.mark(n3, 1);
+        check(slice.size() == wm.getMarkedNodesNum(),
+              "wrong number of nodes in the slice: %lu", slice.size());
+        for (TestNode *n : {e, n1, n2, n3, n4, n5})
+            check(slice.contains(n) == (n->getSlice() == 1),
+                  "node %d wrongly marked", n->getKey());
+
+        // more slices can be kept at once
+        analysis::SliceSet<TestNode> forward;
+        analysis::ReadOnlyWalkAndMark<TestNode>::mark({n2}, forward, true);
+        check(forward.size() == 2 && forward.contains(n2) &&
+              forward.contains(n3) && !forward.contains(n1) &&
+              !forward.contains(n4) && !forward.contains(n5),
+              "wrong forward slice");
+        check(slice.contains(n4), "the first slice changed");
+    }
+};
+
 }; // namespace tests
 }; // namespace dg
 
@@ -689,6 +1026,10 @@ int main(void)
     Runner.add(new TestAdd());
     Runner.add(new TestRemove());
     Runner.add(new TestSlicingCFG());
+    Runner.add(new TestDominators());
+    Runner.add(new TestSummaryEdges());
+    Runner.add(new TestBatchSlicing());
+    Runner.add(new TestReadOnlySlicing());
 
     return Runner();
 }
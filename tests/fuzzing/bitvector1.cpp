@@ -21,6 +21,7 @@ int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
     for (auto x : S) {
         assert(B.get(x));
     }
+    assert(B.size() == S.size());
 
     for (unsigned int i = 0; i < elems; ++i) {
         if (S.count(i) > 0)
@@ -36,6 +37,7 @@ int LLVMFuzzerTestOneInput(const uint8_t *data, size_t size) {
     for (auto x : S) {
         assert(!B.get(x));
     }
+    assert(B.empty());
 
     return 0;
 }
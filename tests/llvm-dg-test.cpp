@@ -1,9 +1,38 @@
 #include <assert.h>
 #include <cstdarg>
 #include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include <string>
+
+// ignore unused parameters in LLVM libraries
+#if (__clang__)
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wunused-parameter"
+#else
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-parameter"
+#endif
+
+#include <llvm/IR/LLVMContext.h>
+#include <llvm/IR/Module.h>
+#include <llvm/IRReader/IRReader.h>
+#include <llvm/Support/MemoryBuffer.h>
+#include <llvm/Support/SourceMgr.h>
+
+#if (__clang__)
+#pragma clang diagnostic pop // ignore -Wunused-parameter
+#else
+#pragma GCC diagnostic pop
+#endif
 
 #include "dg/llvm/LLVMDependenceGraph.h"
+#include "dg/llvm/LLVMDependenceGraphBuilder.h"
+#include "dg/llvm/LLVMSlicer.h"
 #include "dg/analysis/DFS.h"
+#include "dg/util/TimeReport.h"
+#include "dg/util/Trace.h"
 #include "test-runner.h"
 
 
@@ -55,6 +84,309 @@ struct TestRefcount : public Test
     }
 };
 
+// the formal parameters for globals must be computed
+// also for the functions that call the function using the globals
+// only recursively (here 'b' calls 'a' that calls 'b' again
+// and uses the global and the memory it allocates after the call)
+static const char *recursiveModule = R"(
+@g = global i32 0
+
+declare i8* @malloc(i64)
+
+define void @b(i32 %n) {
+  %c = icmp sgt i32 %n, 0
+  br i1 %c, label %rec, label %out
+rec:
+  %m = sub i32 %n, 1
+  call void @a(i32 %m)
+  br label %out
+out:
+  ret void
+}
+
+define void @a(i32 %n) {
+  call void @b(i32 %n)
+  %p = call i8* @malloc(i64 4)
+  %v = load i32, i32* @g
+  store i32 %v, i32* @g
+  ret void
+}
+
+define i32 @main() {
+  call void @a(i32 2)
+  ret i32 0
+}
+)";
+
+struct TestFormalGlobals : public Test
+{
+    TestFormalGlobals() : Test("formal globals test") {}
+
+    void test()
+    {
+        llvm::LLVMContext ctx;
+        llvm::SMDiagnostic err;
+        std::unique_ptr<llvm::Module> M
+            = llvm::parseIR(llvm::MemoryBufferRef(recursiveModule, "rec"),
+                            err, ctx);
+        check(M != nullptr, "failed parsing the module");
+        if (!M)
+            return;
+
+        LLVMDependenceGraph dg;
+        check(dg.build(M.get(), M->getFunction("main")),
+              "failed building the graph");
+
+        llvm::Value *g = M->getGlobalVariable("g");
+        // the call of malloc in 'a'
+        llvm::Value *alloc
+            = M->getFunction("a")->getEntryBlock().front().getNextNode();
+
+        for (const char *name : {"main", "a", "b"}) {
+            auto it = getConstructedFunctions().find(M->getFunction(name));
+            check(it != getConstructedFunctions().end(),
+                  "no graph for '%s'", name);
+            if (it == getConstructedFunctions().end())
+                continue;
+
+            LLVMDGParameters *params = it->second->getParameters();
+            check(params && params->findGlobal(g),
+                  "'%s' has no formal parameter for @g", name);
+            check(params && params->findParameter(alloc),
+                  "'%s' has no formal parameter for the allocation", name);
+        }
+    }
+};
+
+// building a graph must not change the state of another graph
+// that is still being built lazily
+struct TestTwoGraphs : public Test
+{
+    TestTwoGraphs() : Test("two graphs test") {}
+
+    void test()
+    {
+        llvm::LLVMContext ctx;
+        llvm::SMDiagnostic err;
+        std::unique_ptr<llvm::Module> M1
+            = llvm::parseIR(llvm::MemoryBufferRef(recursiveModule, "rec1"),
+                            err, ctx);
+        std::unique_ptr<llvm::Module> M2
+            = llvm::parseIR(llvm::MemoryBufferRef(recursiveModule, "rec2"),
+                            err, ctx);
+        check(M1 != nullptr && M2 != nullptr, "failed parsing the modules");
+        if (!M1 || !M2)
+            return;
+
+        llvmdg::LLVMDependenceGraphOptions opts;
+        opts.lazy = true;
+        llvmdg::LLVMDependenceGraphBuilder builder(M1.get(), opts);
+        auto lazy = std::move(builder.constructCFGOnly());
+        check(lazy != nullptr, "failed building the lazy graph");
+        if (!lazy)
+            return;
+
+        LLVMDependenceGraph eager;
+        check(eager.build(M2.get(), M2->getFunction("main")),
+              "failed building the graph");
+
+        llvm::Value *g = M2->getGlobalVariable("g");
+        for (const char *name : {"main", "a", "b"}) {
+            auto it = getConstructedFunctions().find(M2->getFunction(name));
+            check(it != getConstructedFunctions().end(),
+                  "no graph for '%s'", name);
+            if (it == getConstructedFunctions().end())
+                continue;
+
+            LLVMDGParameters *params = it->second->getParameters();
+            check(params && params->findGlobal(g),
+                  "'%s' has no formal parameter for @g", name);
+        }
+
+        check(lazy->getUnbuiltFunctions().size() == 2,
+              "building another graph changed the lazy graph");
+
+        std::set<LLVMNode *> callSites;
+        lazy->getCallSites("malloc", &callSites);
+        check(callSites.size() == 1, "did not find the call of malloc");
+    }
+};
+
+// the nodes of the module marked with the slice id
+static std::set<const llvm::Value *> getMarked(const llvm::Module *M,
+                                               uint32_t slice_id)
+{
+    std::set<const llvm::Value *> marked;
+    for (auto& it : getConstructedFunctions()) {
+        if (llvm::cast<llvm::Function>(it.first)->getParent() != M)
+            continue;
+
+        for (auto& nd : *it.second) {
+            if (nd.second->getSlice() == slice_id)
+                marked.insert(nd.first);
+        }
+    }
+
+    return marked;
+}
+
+struct TestLazyGraph : public Test
+{
+    TestLazyGraph() : Test("lazy graph test") {}
+
+    // mark the slice w.r.t. the call of malloc
+    std::set<const llvm::Value *> markSlice(bool lazy)
+    {
+        llvm::LLVMContext ctx;
+        llvm::SMDiagnostic err;
+        std::unique_ptr<llvm::Module> M
+            = llvm::parseIR(llvm::MemoryBufferRef(recursiveModule, "rec"),
+                            err, ctx);
+        check(M != nullptr, "failed parsing the module");
+        if (!M)
+            return {};
+
+        llvmdg::LLVMDependenceGraphOptions opts;
+        opts.lazy = lazy;
+        llvmdg::LLVMDependenceGraphBuilder builder(M.get(), opts);
+        auto dg = std::move(builder.constructCFGOnly());
+        check(dg != nullptr, "failed building the graph");
+        if (!dg)
+            return {};
+
+        if (lazy) {
+            check(dg->getUnbuiltFunctions().size() == 2,
+                  "the lazy graph built more than the entry function");
+        }
+
+        std::set<LLVMNode *> callSites;
+        dg->getCallSites("malloc", &callSites);
+        check(callSites.size() == 1, "did not find the call of malloc");
+        if (callSites.size() != 1)
+            return {};
+
+        if (lazy) {
+            // finding the call built the graph of 'a'
+            auto unbuilt = dg->getUnbuiltFunctions();
+            check(unbuilt.size() == 1 && unbuilt[0] == M->getFunction("b"),
+                  "finding the call did not build the graph of 'a'");
+        }
+
+        dg = builder.computeDependencies(std::move(dg));
+
+        LLVMSlicer slicer;
+        if (lazy) {
+            slicer.setGraphCallback([&builder](DependenceGraph<LLVMNode> *graph) {
+                builder.computeFunctionDependencies(
+                    static_cast<LLVMDependenceGraph *>(graph));
+            });
+        }
+
+        uint32_t slice_id = slicer.mark(*callSites.begin());
+        return getMarked(M.get(), slice_id);
+    }
+
+    void test()
+    {
+        auto eager = markSlice(false);
+        auto lazy = markSlice(true);
+
+        check(!eager.empty(), "nothing is in the slice");
+        check(eager.size() == lazy.size(),
+              "the lazy graph marked %lu nodes instead of %lu",
+              (unsigned long) lazy.size(), (unsigned long) eager.size());
+    }
+};
+
+struct TestTimeReport : public Test
+{
+    TestTimeReport() : Test("time report test") {}
+
+    void test()
+    {
+        llvm::LLVMContext ctx;
+        llvm::SMDiagnostic err;
+        std::unique_ptr<llvm::Module> M
+            = llvm::parseIR(llvm::MemoryBufferRef(recursiveModule, "rec"),
+                            err, ctx);
+        check(M != nullptr, "failed parsing the module");
+        if (!M)
+            return;
+
+        util::TimeReport report;
+        llvmdg::LLVMDependenceGraphBuilder builder(M.get());
+        builder.setTimeReport(&report);
+        auto dg = std::move(builder.build());
+        check(dg != nullptr, "failed building the graph");
+
+        const util::TimeReport::Phase& root = report.getRoot();
+        std::set<std::string> phases;
+        for (const auto& phase : root.subphases) {
+            phases.insert(phase->name);
+            check(phase->runs == 1, "phase %s run %u times",
+                  phase->name.c_str(), phase->runs);
+            check(phase->wallTime <= root.wallTime,
+                  "phase %s took longer than the whole build",
+                  phase->name.c_str());
+        }
+
+        for (const char *name : {"pointer analysis", "reaching definitions",
+                                 "graph construction", "def-use analysis",
+                                 "control dependencies"}) {
+            check(phases.count(name) > 0, "missing phase %s", name);
+        }
+
+        // the fixpoint of the pointer analysis iterates at least once
+        const auto& pta = *root.subphases[0];
+        check(pta.name == "pointer analysis" &&
+              pta.counters.size() == 3 && pta.counters[1].second > 0,
+              "wrong counters of the pointer analysis");
+    }
+};
+
+struct TestTrace : public Test
+{
+    TestTrace() : Test("trace test") {}
+
+    void test()
+    {
+        if (!util::Tracer::isAvailable())
+            return;
+
+        llvm::LLVMContext ctx;
+        llvm::SMDiagnostic err;
+        std::unique_ptr<llvm::Module> M
+            = llvm::parseIR(llvm::MemoryBufferRef(recursiveModule, "rec"),
+                            err, ctx);
+        check(M != nullptr, "failed parsing the module");
+        if (!M)
+            return;
+
+        const char *file = "llvm-dg-test-trace.json";
+        util::Tracer::get().start(file);
+        {
+            llvmdg::LLVMDependenceGraphBuilder builder(M.get());
+            auto dg = std::move(builder.build());
+            check(dg != nullptr, "failed building the graph");
+        }
+        check(util::Tracer::get().stop(), "failed writing the trace");
+        check(!util::Tracer::isOn(), "the tracing is still on");
+
+        std::ifstream in(file);
+        std::string trace((std::istreambuf_iterator<char>(in)),
+                          std::istreambuf_iterator<char>());
+        std::remove(file);
+
+        for (const char *event : {"PointerAnalysis::run",
+                                  "ReachingDefinitionsAnalysis::run",
+                                  "LLVMDefUseAnalysis::run",
+                                  "LLVMDependenceGraph::computePostDominators"}) {
+            check(trace.find(std::string("\"") + event + "\"") != std::string::npos,
+                  "the trace does not have %s", event);
+        }
+    }
+};
+
 }
 }
 
@@ -65,6 +397,11 @@ int main(void)
     TestRunner Runner;
 
     Runner.add(new TestRefcount());
+    Runner.add(new TestFormalGlobals());
+    Runner.add(new TestLazyGraph());
+    Runner.add(new TestTwoGraphs());
+    Runner.add(new TestTimeReport());
+    Runner.add(new TestTrace());
 
     return Runner();
 }
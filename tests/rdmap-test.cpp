@@ -117,3 +117,88 @@ TEST_CASE("iterator", "DisjunctiveIntervalMap") {
 */
 
 
+TEST_CASE("Copy-on-write", "SharedRDMap") {
+    RDMap M;
+    M.add(DefSite(&A, 0, 4), &B);
+
+    RDMap N(M);
+    REQUIRE(!N.empty());
+    REQUIRE(!N.add(DefSite(&A, 0, 4), &B));
+    REQUIRE(N.add(DefSite(&A, 0, 4), &C));
+
+    std::set<RDNode *> rd;
+    M.get(&A, 0, 4, rd);
+    REQUIRE(rd.size() == 1);
+    REQUIRE(*(rd.begin()) == &B);
+
+    rd.clear();
+    N.get(&A, 0, 4, rd);
+    REQUIRE(rd.size() == 2);
+
+    RDMapMemoryCounter counter;
+    counter.add(M);
+    counter.add(N);
+    REQUIRE(counter.maps == 2);
+    REQUIRE(counter.chunks == 2);
+}
+
+TEST_CASE("Merge shares chunks", "SharedRDMap") {
+    RDMap M, N, O;
+    M.add(DefSite(&A, 0, 4), &B);
+    M.add(DefSite(&C, 0, 4), &B);
+
+    REQUIRE(N.merge(&M));
+    REQUIRE(!N.merge(&M));
+    REQUIRE(O.assign(N));
+    REQUIRE(!O.assign(N));
+
+    // strong update of C must not touch the shared chunk
+    DefSiteSet overwrites;
+    overwrites.insert(DefSite(&C, 0, 4), DefSiteSet::ELEMENT | DefSiteSet::STRONG);
+    RDMap P;
+    P.update(DefSite(&C, 0, 4), &A);
+    REQUIRE(P.merge(&M, &overwrites));
+
+    std::set<RDNode *> rd;
+    P.get(&C, 0, 4, rd);
+    REQUIRE(rd.size() == 1);
+    REQUIRE(*(rd.begin()) == &A);
+
+    rd.clear();
+    M.get(&C, 0, 4, rd);
+    REQUIRE(rd.size() == 1);
+    REQUIRE(*(rd.begin()) == &B);
+
+    RDMapMemoryCounter counter;
+    for (RDMap *map : {&M, &N, &O, &P})
+        counter.add(*map);
+    REQUIRE(counter.maps == 4);
+    REQUIRE(counter.sharedMaps == 1);
+    // A is shared by all the maps, C by M and N, P has its own C
+    REQUIRE(counter.chunks == 3);
+    REQUIRE(counter.unsharedEntries == 8);
+}
+
+TEST_CASE("Object range with zero-length def-site", "DefSiteSet") {
+    // memset(p, 0, 0) defines (p, 0, 0) in the builds without assertions,
+    // it is smaller than any other def-site of the object
+    DefSite empty(&B, 0, 1);
+    empty.len = 0;
+
+    DefSiteSet defs;
+    defs.insert(DefSite(&A, 4, 4));
+    defs.insert(DefSite(&B, 0, 4));
+    defs.insert(empty);
+    defs.insert(DefSite(&C, 0, 4));
+
+    auto range = defs.getObjectRange(&B);
+    REQUIRE(range.second - range.first == 2);
+    REQUIRE(range.first->ds == empty);
+    REQUIRE((range.first + 1)->ds == DefSite(&B, 0, 4));
+
+    RDNode node;
+    node.addDef(DefSite(&A, 4, 4));
+    node.getDefines().insert(empty);
+    REQUIRE(node.defines(&B, 0));
+    REQUIRE(!node.defines(&C));
+}
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <assert.h>
 #include <cstdarg>
 #include <cstdio>
@@ -8,6 +9,8 @@
 
 #include "dg/analysis/ReachingDefinitions/ReachingDefinitions.h"
 #include "dg/analysis/ReachingDefinitions/RDMap.h"
+#include "dg/analysis/ReachingDefinitions/DemandDrivenRda.h"
+#include "dg/analysis/ReachingDefinitions/MemorySsaRda.h"
 
 namespace dg {
 namespace tests {
@@ -237,12 +240,269 @@ public:
         //dumpMap(&S2);
     }
 
+    void filters()
+    {
+        // a call of procedure that touches only AL2:
+        // S1 -> S2 -> CALL -> ROOT -> S3 -> RET -> RETURN
+        //                \-> BYPASS ------------/
+        RDNode AL1, AL2;
+        RDNode S1, S2, S3;
+        RDNode CALL(RDNodeType::CALL), RETURN(RDNodeType::RETURN);
+        RDNode ROOT(RDNodeType::NOOP), RET(RDNodeType::NOOP);
+        RDNode BYPASS(RDNodeType::NOOP);
+
+        S1.addDef(&AL1, 0, 4, true /* strong update */);
+        S2.addDef(&AL2, 0, 4, true /* strong update */);
+        S3.addDef(&AL2, 0, 4, true /* strong update */);
+
+        std::set<RDNode *> mod{&AL2};
+        ROOT.filter = DefSiteFilter(&mod);
+        RET.filter = DefSiteFilter(&mod);
+        BYPASS.filter = DefSiteFilter(&mod, true /* exclude */);
+
+        AL1.addSuccessor(&AL2);
+        AL2.addSuccessor(&S1);
+        S1.addSuccessor(&S2);
+        S2.addSuccessor(&CALL);
+        CALL.addSuccessor(&ROOT);
+        ROOT.addSuccessor(&S3);
+        S3.addSuccessor(&RET);
+        RET.addSuccessor(&RETURN);
+        CALL.addSuccessor(&BYPASS);
+        BYPASS.addSuccessor(&RETURN);
+
+        ReachingDefinitionsAnalysis RD(&AL1);
+        RD.run();
+        DemandDrivenRda demand(&AL1);
+        MemorySsaRda mssa(&AL1);
+
+        std::set<RDNode *> rd;
+        S3.getReachingDefinitions(&AL1, 0, 4, rd);
+        check(rd.empty(), "AL1 should not get into the procedure");
+        demand.getDefinitions(&S3, &AL1, 0, 4, rd);
+        mssa.getDefinitions(&S3, DefSite(&AL1, 0, 4), rd);
+        check(rd.empty(), "AL1 should not get into the procedure");
+
+        for (ReachingDefinitionsAnalysis *A :
+                {&RD, static_cast<ReachingDefinitionsAnalysis *>(&demand),
+                 static_cast<ReachingDefinitionsAnalysis *>(&mssa)}) {
+            rd.clear();
+            A->getReachingDefinitions(&RETURN, &AL1, 0, 4, rd);
+            check(rd.size() == 1, "Should have one r.d.");
+            check(rd.count(&S1) == 1, "Should be S1");
+            rd.clear();
+            A->getReachingDefinitions(&RETURN, &AL2, 0, 4, rd);
+            check(rd.size() == 1, "Should have one r.d.");
+            check(rd.count(&S3) == 1, "Should be S3");
+        }
+    }
+
     void test()
     {
         basic1();
         basic2();
         basic3();
         basic4();
+        filters();
+    }
+};
+
+class DemandDrivenRDATest : public Test
+{
+public:
+    DemandDrivenRDATest()
+        : Test("Demand-driven reaching definitions test") {}
+
+    void linear()
+    {
+        RDNode AL1;
+        RDNode S1;
+        RDNode S2;
+        RDNode S3;
+
+        S1.addDef(&AL1, 0, 4, true /* strong update */);
+        S2.addDef(&AL1, 2, 4, true /* strong update */);
+        S3.addDef(&AL1, 0, 8, true /* strong update */);
+
+        AL1.addSuccessor(&S1);
+        S1.addSuccessor(&S2);
+        S2.addSuccessor(&S3);
+
+        DemandDrivenRda RD(&AL1);
+        RD.run();
+
+        std::set<RDNode *> rd;
+        RD.getDefinitions(&S2, &AL1, 0, 1, rd);
+        check(rd.size() == 1, "Should have had one r.d.");
+        check(*(rd.begin()) == &S1, "Should be S1");
+        rd.clear();
+        // S2 overwrites the whole queried memory, so (unlike
+        // the dense analysis) we do not get S1 here
+        RD.getDefinitions(&S2, &AL1, 2, 1, rd);
+        check(rd.size() == 1, "Should have had one r.d.");
+        check(*(rd.begin()) == &S2, "Should be S2");
+        rd.clear();
+        RD.getDefinitions(&S2, &AL1, 1, 2, rd);
+        check(rd.size() == 2, "Should have two r.d.");
+        rd.clear();
+        RD.getDefinitions(&S2, &AL1, 6, 1, rd);
+        check(rd.size() == 0, "Should not have r.d.");
+        rd.clear();
+        RD.getDefinitions(&S3, &AL1, analysis::Offset::UNKNOWN,
+                          analysis::Offset::UNKNOWN, rd);
+        check(rd.size() == 3, "Should have had three r.d.");
+        rd.clear();
+        RD.getDefinitions(&S3, &AL1, 2, 1, rd);
+        check(rd.size() == 1, "Should have had one r.d.");
+        check(*(rd.begin()) == &S3, "Should be S3");
+    }
+
+    void branches()
+    {
+        // AL1 -> S1 -> (S2 | S3) -> PHI -> S4 -> L
+        // and a loop from L back to S4
+        RDNode AL1;
+        RDNode S1, S2, S3, S4;
+        RDNode PHI(RDNodeType::PHI);
+        RDNode L;
+
+        S1.addDef(&AL1, 0, 4, true /* strong update */);
+        S2.addDef(&AL1, 0, 4, true /* strong update */);
+        S3.addDef(&AL1, 4, 4, true /* strong update */);
+        S4.addDef(&AL1, 4, 4, false /* weak update */);
+
+        AL1.addSuccessor(&S1);
+        S1.addSuccessor(&S2);
+        S1.addSuccessor(&S3);
+        S2.addSuccessor(&PHI);
+        S3.addSuccessor(&PHI);
+        PHI.addSuccessor(&S4);
+        S4.addSuccessor(&L);
+        L.addSuccessor(&S4);
+
+        ReachingDefinitionsAnalysis dense(&AL1);
+        dense.run();
+        DemandDrivenRda RD(&AL1);
+        RD.run();
+
+        // the demand-driven analysis must give the same
+        // results as the dense analysis on these graphs
+        for (RDNode *where : {&S2, &S3, &PHI, &S4, &L}) {
+            for (uint64_t off : {0, 4}) {
+                std::set<RDNode *> expected, rd;
+                where->getReachingDefinitions(&AL1, off, 4, expected);
+                RD.getDefinitions(where, &AL1, off, 4, rd);
+                check(rd == expected, "Results differ from dense RDA");
+            }
+        }
+
+        std::set<RDNode *> rd;
+        RD.getDefinitions(&L, &AL1, 0, 4, rd);
+        check(rd.size() == 2, "Should have two r.d.");
+        check(rd.count(&S1) == 1, "Should contain S1");
+        check(rd.count(&S2) == 1, "Should contain S2");
+
+        check(RD.getStatistics().queries == 11, "Wrong number of queries");
+        check(RD.getStatistics().cacheHits > 0, "Should have hit the cache");
+    }
+
+    void test()
+    {
+        linear();
+        branches();
+    }
+};
+
+class MemorySsaRDATest : public Test
+{
+public:
+    MemorySsaRDATest()
+        : Test("Memory SSA reaching definitions test") {}
+
+    void objects()
+    {
+        RDNode AL1, AL2;
+        RDNode S1, S2, S3;
+
+        S1.addDef(&AL1, 0, 4, true /* strong update */);
+        S2.addDef(&AL2, 0, 4, true /* strong update */);
+        S3.addDef(&AL2, 0, 4, false /* weak update */);
+
+        AL1.addSuccessor(&AL2);
+        AL2.addSuccessor(&S1);
+        S1.addSuccessor(&S2);
+        S2.addSuccessor(&S3);
+
+        MemorySsaRda RD(&AL1);
+        RD.run();
+
+        std::set<RDNode *> rd;
+        RD.getDefinitions(&S3, DefSite(&AL1, 0, 4), rd);
+        check(rd.size() == 1, "Should have had one r.d.");
+        check(*(rd.begin()) == &S1, "Should be S1");
+        rd.clear();
+        RD.getDefinitions(&S3, DefSite(&AL2, 0, 4), rd);
+        check(rd.size() == 2, "Should have two r.d.");
+        rd.clear();
+        RD.getDefinitions(&S1, DefSite(&AL2, 0, 4), rd);
+        check(rd.size() == 0, "Should not have r.d.");
+        check(RD.getPhisNum() == 0, "Should not have any phi");
+    }
+
+    void loops()
+    {
+        // AL1 -> S1 -> H -> (S2 | S3) -> J -> H and H -> E
+        RDNode AL1;
+        RDNode S1, S2, S3;
+        RDNode H(RDNodeType::PHI), J(RDNodeType::PHI), E;
+
+        S1.addDef(&AL1, 0, 8, true /* strong update */);
+        S2.addDef(&AL1, 0, 4, true /* strong update */);
+        S3.addDef(&AL1, 4, 4, true /* strong update */);
+
+        AL1.addSuccessor(&S1);
+        S1.addSuccessor(&H);
+        H.addSuccessor(&S2);
+        H.addSuccessor(&S3);
+        H.addSuccessor(&E);
+        S2.addSuccessor(&J);
+        S3.addSuccessor(&J);
+        J.addSuccessor(&H);
+
+        ReachingDefinitionsAnalysis dense(&AL1);
+        dense.run();
+        MemorySsaRda RD(&AL1);
+        RD.run();
+
+        // the results may be only more precise than the results
+        // of the dense analysis (S2 and S3 overwrite the queried
+        // memory, but not the whole definition from S1)
+        for (RDNode *where : {&S1, &H, &S2, &S3, &J, &E}) {
+            for (uint64_t off : {0, 4}) {
+                std::set<RDNode *> expected, rd;
+                where->getReachingDefinitions(&AL1, off, 4, expected);
+                RD.getDefinitions(where, DefSite(&AL1, off, 4), rd);
+                check(std::includes(expected.begin(), expected.end(),
+                                    rd.begin(), rd.end()),
+                      "Results are not subset of dense RDA results");
+            }
+        }
+
+        std::set<RDNode *> rd;
+        RD.getDefinitions(&S2, DefSite(&AL1, 0, 4), rd);
+        check(rd.size() == 1, "Should have had one r.d.");
+        check(*(rd.begin()) == &S2, "Should be S2");
+        rd.clear();
+        RD.getDefinitions(&E, DefSite(&AL1, 0, 4), rd);
+        check(rd.size() == 2, "Should have two r.d.");
+        check(rd.count(&S1) == 1, "Should contain S1");
+        check(rd.count(&S2) == 1, "Should contain S2");
+    }
+
+    void test()
+    {
+        objects();
+        loops();
     }
 };
 
@@ -255,6 +515,8 @@ int main(void)
     TestRunner Runner;
 
     Runner.add(new ReachingDefinitionsTest());
+    Runner.add(new DemandDrivenRDATest());
+    Runner.add(new MemorySsaRDATest());
 
     return Runner();
 }
@@ -0,0 +1,43 @@
+#!/bin/bash
+
+TESTS_DIR=`dirname $0`
+source "$TESTS_DIR/test-runner.sh"
+
+set_environment
+
+CODE="$TESTS_DIR/sources/funcptr1.c"
+NAME=${CODE%.*}
+BCFILE="$NAME.bc"
+CACHEFILE="$NAME.dgcache"
+SLICEDFILE="$NAME.sliced"
+LINKEDFILE="$SLICEDFILE.linked"
+
+rm -f "$CACHEFILE" "$NAME.built.sliced"
+
+# compile in.c out.bc
+compile "$CODE" "$BCFILE"
+
+if [ ! -z "$DG_TESTS_PTA" ]; then
+	export DG_TESTS_PTA="-pta $DG_TESTS_PTA"
+fi
+
+# build the graph and store it
+llvm-slicer $DG_TESTS_PTA -dg-cache "$CACHEFILE" -c test_assert \
+	"$BCFILE" -o "$NAME.built.sliced" || exit 1
+test -f "$CACHEFILE" || errmsg "The graph was not stored"
+
+# slice again using the stored graph
+llvm-slicer $DG_TESTS_PTA -dg-cache "$CACHEFILE" -c test_assert \
+	"$BCFILE" 2>&1 | tee "$NAME.log"
+grep -q 'Loading the dependence graph' "$NAME.log" \
+	|| errmsg "The stored graph was not used"
+
+# the slices must be the same
+cmp "$NAME.built.sliced" "$SLICEDFILE" \
+	|| errmsg "The slice from the stored graph differs"
+
+# link assert to the code
+link_with_assert "$SLICEDFILE" "$LINKEDFILE"
+
+# run the code and check result
+get_result "$LINKEDFILE"
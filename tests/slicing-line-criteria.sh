@@ -0,0 +1,39 @@
+#!/bin/bash
+
+TESTS_DIR=`dirname $0`
+source "$TESTS_DIR/test-runner.sh"
+
+set_environment
+
+CODE="$TESTS_DIR/sources/test1.c"
+NAME=${CODE%.*}
+BCFILE="$NAME.bc"
+SLICEDFILE="$NAME.sliced"
+LINKEDFILE="$SLICEDFILE.linked"
+
+rm -f "$SLICEDFILE"
+
+# compile in.c out.bc with the debugging information
+TESTS_CFLAGS="$TESTS_CFLAGS -g"
+compile "$CODE" "$BCFILE"
+
+if [ ! -z "$DG_TESTS_PTA" ]; then
+	export DG_TESTS_PTA="-pta $DG_TESTS_PTA"
+fi
+
+# the line in other file must not match
+llvm-slicer $DG_TESTS_PTA -c 'other.c:10:a' "$BCFILE" 2>&1 | tee "$NAME.log"
+grep -q 'Matched line' "$NAME.log" \
+	&& errmsg "Matched a line of other file"
+
+# 'a = b + c' on the line 10 of test1.c
+llvm-slicer $DG_TESTS_PTA -c 'test_assert,test1.c:10:a' "$BCFILE" 2>&1 \
+	| tee "$NAME.log"
+grep -q 'Matched line 10 with variable a' "$NAME.log" \
+	|| errmsg "Did not match the line criterion"
+
+# link assert to the code
+link_with_assert "$SLICEDFILE" "$LINKEDFILE"
+
+# run the code and check result
+get_result "$LINKEDFILE"
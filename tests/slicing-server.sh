@@ -0,0 +1,66 @@
+#!/bin/bash
+
+TESTS_DIR=`dirname $0`
+source "$TESTS_DIR/test-runner.sh"
+
+set_environment
+
+CODE="$TESTS_DIR/sources/funcptr1.c"
+NAME=${CODE%.*}
+BCFILE="$NAME.bc"
+SLICEDFILE="$NAME.server.sliced"
+LINKEDFILE="$SLICEDFILE.linked"
+
+rm -f "$SLICEDFILE" "$NAME.server.empty.sliced"
+
+# compile in.c out.bc
+compile "$CODE" "$BCFILE"
+
+if [ ! -z "$DG_TESTS_PTA" ]; then
+	export DG_TESTS_PTA="-pta $DG_TESTS_PTA"
+fi
+
+# slice twice on one graph, the second slice must not be affected
+# by the marks of the first one
+ANSWERS=`llvm-slicer $DG_TESTS_PTA -server - -server-jobs 1 "$BCFILE" <<END
+backward $NAME.server.empty.sliced nonexistent_function
+backward $SLICEDFILE test_assert
+quit
+END`
+
+echo "$ANSWERS"
+echo "$ANSWERS" | grep -q "^OK $SLICEDFILE\$" || errmsg "Slicing request failed"
+echo "$ANSWERS" | grep -q "^ERROR" && errmsg "Slicing request failed"
+
+# the request whose slicing dies must be answered too. The output is
+# a named pipe without a reader, so the child blocks until it is killed
+FIFO="$NAME.server.fifo"
+rm -f "$FIFO"
+mkfifo "$FIFO" || errmsg "Failed creating a named pipe"
+
+coproc SERVER { exec llvm-slicer $DG_TESTS_PTA -server - -server-jobs 1 "$BCFILE"; }
+SERVER_JOB=$SERVER_PID
+echo "backward $FIFO test_assert" >&${SERVER[1]}
+
+CHILD=""
+for I in `seq 1 600`; do
+	CHILD=`pgrep -P $SERVER_JOB`
+	[ ! -z "$CHILD" ] && break
+	sleep 0.1
+done
+[ -z "$CHILD" ] && errmsg "The server did not start slicing the request"
+kill -KILL $CHILD
+
+read -t 60 ANSWER <&${SERVER[0]}
+echo "quit" >&${SERVER[1]}
+wait $SERVER_JOB
+rm -f "$FIFO"
+
+echo "$ANSWER"
+echo "$ANSWER" | grep -q "^ERROR $FIFO " || errmsg "Killed request was not answered"
+
+# link assert to the code
+link_with_assert "$SLICEDFILE" "$LINKEDFILE"
+
+# run the code and check result
+get_result "$LINKEDFILE"
@@ -0,0 +1,44 @@
+#!/bin/bash
+
+TESTS_DIR=`dirname $0`
+source "$TESTS_DIR/test-runner.sh"
+
+set_environment
+
+CODE="$TESTS_DIR/sources/funcptr1.c"
+NAME=${CODE%.*}
+BCFILE="$NAME.bc"
+SLICEDFILE="$NAME.1.sliced"
+LINKEDFILE="$SLICEDFILE.linked"
+
+rm -f "$NAME".[12].sliced "$NAME".[12].forked
+
+# compile in.c out.bc
+compile "$CODE" "$BCFILE"
+
+if [ ! -z "$DG_TESTS_PTA" ]; then
+	export DG_TESTS_PTA="-pta $DG_TESTS_PTA"
+fi
+
+# slice in child processes
+llvm-slicer $DG_TESTS_PTA -c 'test_assert;nonexistent_function' "$BCFILE" \
+	|| errmsg "Slicing in child processes failed"
+mv "$NAME.1.sliced" "$NAME.1.forked"
+mv "$NAME.2.sliced" "$NAME.2.forked"
+
+# slice the copies of the module in threads
+llvm-slicer $DG_TESTS_PTA -slice-threads 2 \
+	-c 'test_assert;nonexistent_function' "$BCFILE" \
+	|| errmsg "Slicing in threads failed"
+
+# the slices must be the same
+cmp "$NAME.1.forked" "$NAME.1.sliced" \
+	|| errmsg "The slice from the thread differs"
+cmp "$NAME.2.forked" "$NAME.2.sliced" \
+	|| errmsg "The empty slice from the thread differs"
+
+# link assert to the code
+link_with_assert "$SLICEDFILE" "$LINKEDFILE"
+
+# run the code and check result
+get_result "$LINKEDFILE"
@@ -3,6 +3,11 @@
 
 #include <chrono>
 #include <iostream>
+#include <memory>
+#include <string>
+
+#include "dg/util/TimeReport.h"
+#include "dg/util/Trace.h"
 
 namespace dg {
 namespace debug {
@@ -47,6 +52,45 @@ public:
         out << sec << " sec " << msec << " ms" << std::endl;
     }
 };
+
+///
+// The report of the phases of the tool (see -time-report) that is
+// written into the file when this object is destroyed (i.e., whenever
+// main() returns). Without the file, no report is created.
+class TimeReportFile
+{
+    std::unique_ptr<util::TimeReport> report{};
+    std::string file;
+
+public:
+    TimeReportFile(const std::string& f, const std::string& tool) : file(f)
+    {
+        if (!file.empty())
+            report.reset(new util::TimeReport(tool));
+    }
+
+    ~TimeReportFile()
+    {
+        if (report && !report->writeJSON(file))
+            std::cerr << "WARNING: Failed writing the time report to "
+                      << file << std::endl;
+    }
+
+    util::TimeReport *get() { return report.get(); }
+};
+
+// trace the analyses into the file (see dg/util/Trace.h),
+// the trace is written when the program exits
+inline void startTracing(const std::string& file)
+{
+    if (!util::Tracer::isAvailable()) {
+        std::cerr << "WARNING: dg was compiled without ENABLE_TRACING, "
+                     "the trace will be empty" << std::endl;
+    }
+
+    util::Tracer::get().start(file);
+}
+
 } // namespace debug
 } // namespace dg
 
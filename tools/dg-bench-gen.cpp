@@ -0,0 +1,402 @@
+// Generator of synthetic LLVM modules for benchmarking the analyses.
+//
+// The module is written as textual LLVM IR that all the tools can read.
+// Its shape is given by the parameters:
+//
+//  -functions N     the number of the worker functions
+//  -depth D         the workers are split into D layers, a worker calls
+//                   the workers from the next layer (the call depth is D)
+//  -calls C         how many workers a worker calls
+//  -pointers P      how many pointers every worker stores and loads
+//                   (to the locals, the globals, the heap and the argument)
+//  -fptr-tables T   the number of global tables of function pointers,
+//                   the workers call also via these tables
+//  -lists L         the number of linked lists that the workers
+//                   build and the main function goes through
+//  -threads K       the number of threads that the main function
+//                   creates (pthread_create) and joins
+//  -seed S          the seed of the pseudo-random choices
+//
+// The main function calls __assert_fail depending on the computed
+// values, so the module can be sliced with '-c __assert_fail'.
+// The same parameters give the same module.
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct Parameters {
+    unsigned functions{100};
+    unsigned depth{5};
+    unsigned calls{2};
+    unsigned pointers{4};
+    unsigned fptrTables{0};
+    unsigned lists{0};
+    unsigned threads{0};
+    unsigned seed{0};
+};
+
+const char *WORKER_TYPE = "i32 (i32*, i32)";
+const unsigned FPTR_TABLE_SIZE = 4;
+
+class Generator {
+    const Parameters& params;
+    std::mt19937 rand;
+    std::ostringstream out;
+
+    unsigned globalsNum;
+    unsigned layerSize;
+    // the number of the registers in the current function
+    unsigned regs{0};
+
+    unsigned random(unsigned n) {
+        return std::uniform_int_distribution<unsigned>(0, n - 1)(rand);
+    }
+
+    std::string reg() { return "%r" + std::to_string(regs++); }
+
+    unsigned layerOf(unsigned f) const { return f / layerSize; }
+
+    std::string global(unsigned n) const { return "@g" + std::to_string(n); }
+    std::string worker(unsigned n) const { return "@f" + std::to_string(n); }
+    std::string node(unsigned l) const { return "%struct.node" + std::to_string(l); }
+
+    std::string randomGlobal() { return global(random(globalsNum)); }
+
+    void declarations() {
+        out << "; generated by dg-bench-gen -functions " << params.functions
+            << " -depth " << params.depth << " -calls " << params.calls
+            << " -pointers " << params.pointers
+            << " -fptr-tables " << params.fptrTables
+            << " -lists " << params.lists << " -threads " << params.threads
+            << " -seed " << params.seed << "\n\n";
+
+        for (unsigned l = 0; l < params.lists; ++l)
+            out << node(l) << " = type { i32, " << node(l) << "* }\n";
+        if (params.lists > 0)
+            out << "\n";
+
+        for (unsigned g = 0; g < globalsNum; ++g)
+            out << global(g) << " = global i32 0\n";
+        out << "@gp = global i32* null\n";
+        out << "@idx = global i32 0\n";
+        for (unsigned l = 0; l < params.lists; ++l)
+            out << "@head" << l << " = global " << node(l) << "* null\n";
+
+        for (unsigned t = 0; t < params.fptrTables; ++t) {
+            out << "@tbl" << t << " = global [" << FPTR_TABLE_SIZE << " x "
+                << WORKER_TYPE << "*] [";
+            for (unsigned i = 0; i < FPTR_TABLE_SIZE; ++i) {
+                out << (i == 0 ? "" : ", ") << WORKER_TYPE << "* "
+                    << worker(random(params.functions));
+            }
+            out << "]\n";
+        }
+        out << "\n";
+
+        out << "declare i8* @malloc(i64)\n";
+        out << "declare void @__assert_fail(i8*, i8*, i32, i8*)\n";
+        if (params.threads > 0) {
+            out << "declare i32 @pthread_create(i64*, i8*, i8* (i8*)*, i8*)\n";
+            out << "declare i32 @pthread_join(i64, i8**)\n";
+        }
+        out << "\n";
+    }
+
+    void lists() {
+        for (unsigned l = 0; l < params.lists; ++l) {
+            const std::string N = node(l);
+
+            out << "define void @push" << l << "(" << N << "** %head, i32 %v) {\n"
+                << "entry:\n"
+                << "  %m = call i8* @malloc(i64 16)\n"
+                << "  %n = bitcast i8* %m to " << N << "*\n"
+                << "  %val = getelementptr " << N << ", " << N << "* %n, i32 0, i32 0\n"
+                << "  store i32 %v, i32* %val\n"
+                << "  %old = load " << N << "*, " << N << "** %head\n"
+                << "  %next = getelementptr " << N << ", " << N << "* %n, i32 0, i32 1\n"
+                << "  store " << N << "* %old, " << N << "** %next\n"
+                << "  store " << N << "* %n, " << N << "** %head\n"
+                << "  ret void\n"
+                << "}\n\n";
+
+            out << "define i32 @sum" << l << "(" << N << "* %h) {\n"
+                << "entry:\n"
+                << "  %cur = alloca " << N << "*\n"
+                << "  %sum = alloca i32\n"
+                << "  store " << N << "* %h, " << N << "** %cur\n"
+                << "  store i32 0, i32* %sum\n"
+                << "  br label %loop\n"
+                << "loop:\n"
+                << "  %c = load " << N << "*, " << N << "** %cur\n"
+                << "  %end = icmp eq " << N << "* %c, null\n"
+                << "  br i1 %end, label %done, label %body\n"
+                << "body:\n"
+                << "  %vp = getelementptr " << N << ", " << N << "* %c, i32 0, i32 0\n"
+                << "  %v = load i32, i32* %vp\n"
+                << "  %s = load i32, i32* %sum\n"
+                << "  %s2 = add i32 %s, %v\n"
+                << "  store i32 %s2, i32* %sum\n"
+                << "  %np = getelementptr " << N << ", " << N << "* %c, i32 0, i32 1\n"
+                << "  %n = load " << N << "*, " << N << "** %np\n"
+                << "  store " << N << "* %n, " << N << "** %cur\n"
+                << "  br label %loop\n"
+                << "done:\n"
+                << "  %r = load i32, i32* %sum\n"
+                << "  ret i32 %r\n"
+                << "}\n\n";
+        }
+    }
+
+    void workerFunction(unsigned f) {
+        regs = 0;
+        out << "define i32 " << worker(f) << "(i32* %p, i32 %n) {\n"
+            << "entry:\n"
+            << "  %a = alloca i32\n"
+            << "  %b = alloca i32\n"
+            << "  store i32 %n, i32* %a\n"
+            << "  store i32 0, i32* %b\n";
+
+        // the memory that the pointers of the function point to
+        std::vector<std::string> targets = {"%a", "%b", "%p"};
+        if (params.pointers > 0) {
+            std::string m = reg();
+            out << "  " << m << " = call i8* @malloc(i64 4)\n";
+            std::string h = reg();
+            out << "  " << h << " = bitcast i8* " << m << " to i32*\n";
+            targets.push_back(h);
+        }
+
+        for (unsigned i = 0; i < params.pointers; ++i) {
+            std::string target = random(4) == 0 ? randomGlobal()
+                                                : targets[random(targets.size())];
+            std::string pp = reg();
+            out << "  " << pp << " = alloca i32*\n";
+            // some pointers go through the shared global pointer
+            if (random(3) == 0) {
+                out << "  store i32* " << target << ", i32** @gp\n";
+                pp = "@gp";
+            } else {
+                out << "  store i32* " << target << ", i32** " << pp << "\n";
+            }
+            std::string q = reg();
+            out << "  " << q << " = load i32*, i32** " << pp << "\n";
+            if (random(2) == 0) {
+                out << "  store i32 " << i << ", i32* " << q << "\n";
+            } else {
+                std::string v = reg();
+                out << "  " << v << " = load i32, i32* " << q << "\n";
+                std::string s = reg();
+                out << "  " << s << " = load i32, i32* %b\n";
+                std::string t = reg();
+                out << "  " << t << " = add i32 " << s << ", " << v << "\n";
+                out << "  store i32 " << t << ", i32* %b\n";
+            }
+            targets.push_back(q);
+        }
+
+        out << "  %c = icmp sgt i32 %n, 0\n"
+            << "  br i1 %c, label %calls, label %exit\n"
+            << "calls:\n"
+            << "  %dec = sub i32 %n, 1\n";
+
+        const unsigned layer = layerOf(f);
+        const unsigned next = (layer + 1) * layerSize;
+        if (next < params.functions) {
+            const unsigned nextSize = std::min(layerSize, params.functions - next);
+            for (unsigned i = 0; i < params.calls; ++i) {
+                std::string r = reg();
+                out << "  " << r << " = call i32 " << worker(next + random(nextSize))
+                    << "(i32* " << targets[random(targets.size())] << ", i32 %dec)\n";
+                out << "  store i32 " << r << ", i32* %b\n";
+            }
+        }
+
+        if (params.fptrTables > 0 && random(2) == 0) {
+            std::string i = reg();
+            out << "  " << i << " = load i32, i32* @idx\n";
+            std::string slot = reg();
+            out << "  " << slot << " = getelementptr [" << FPTR_TABLE_SIZE
+                << " x " << WORKER_TYPE << "*], [" << FPTR_TABLE_SIZE
+                << " x " << WORKER_TYPE << "*]* @tbl" << random(params.fptrTables)
+                << ", i32 0, i32 " << i << "\n";
+            std::string fp = reg();
+            out << "  " << fp << " = load " << WORKER_TYPE << "*, "
+                << WORKER_TYPE << "** " << slot << "\n";
+            std::string r = reg();
+            out << "  " << r << " = call i32 " << fp << "(i32* "
+                << targets[random(targets.size())] << ", i32 %dec)\n";
+            out << "  store i32 " << r << ", i32* %b\n";
+        }
+
+        if (params.lists > 0 && random(2) == 0) {
+            unsigned l = random(params.lists);
+            out << "  call void @push" << l << "(" << node(l) << "** @head" << l
+                << ", i32 %n)\n";
+        }
+
+        out << "  br label %exit\n"
+            << "exit:\n"
+            << "  %res = load i32, i32* %b\n"
+            << "  store i32 %res, i32* " << randomGlobal() << "\n"
+            << "  ret i32 %res\n"
+            << "}\n\n";
+    }
+
+    void threadFunctions() {
+        for (unsigned t = 0; t < params.threads; ++t) {
+            out << "define i8* @thread" << t << "(i8* %arg) {\n"
+                << "entry:\n"
+                << "  %p = bitcast i8* %arg to i32*\n"
+                << "  %r = call i32 " << worker(random(std::min(layerSize, params.functions)))
+                << "(i32* %p, i32 " << params.depth << ")\n"
+                << "  store i32 %r, i32* " << randomGlobal() << "\n"
+                << "  ret i8* null\n"
+                << "}\n\n";
+        }
+    }
+
+    void mainFunction() {
+        regs = 0;
+        out << "define i32 @main() {\n"
+            << "entry:\n"
+            << "  %x = alloca i32\n"
+            << "  store i32 0, i32* %x\n"
+            << "  store i32 " << random(FPTR_TABLE_SIZE) << ", i32* @idx\n";
+
+        for (unsigned t = 0; t < params.threads; ++t) {
+            out << "  %tid" << t << " = alloca i64\n"
+                << "  " << reg() << " = call i32 @pthread_create(i64* %tid" << t
+                << ", i8* null, i8* (i8*)* @thread" << t << ", i8* bitcast (i32* "
+                << randomGlobal() << " to i8*))\n";
+        }
+
+        // call the first layer
+        for (unsigned f = 0; f < std::min(layerSize, params.functions); ++f) {
+            std::string r = reg();
+            out << "  " << r << " = call i32 " << worker(f)
+                << "(i32* %x, i32 " << params.depth << ")\n";
+            out << "  store i32 " << r << ", i32* " << randomGlobal() << "\n";
+        }
+
+        for (unsigned t = 0; t < params.threads; ++t) {
+            std::string tid = reg();
+            out << "  " << tid << " = load i64, i64* %tid" << t << "\n"
+                << "  " << reg() << " = call i32 @pthread_join(i64 " << tid
+                << ", i8** null)\n";
+        }
+
+        for (unsigned l = 0; l < params.lists; ++l) {
+            std::string h = reg();
+            out << "  " << h << " = load " << node(l) << "*, " << node(l)
+                << "** @head" << l << "\n";
+            std::string s = reg();
+            out << "  " << s << " = call i32 @sum" << l << "(" << node(l)
+                << "* " << h << ")\n";
+            out << "  store i32 " << s << ", i32* " << global(0) << "\n";
+        }
+
+        out << "  %v = load i32, i32* " << global(0) << "\n"
+            << "  %c = icmp eq i32 %v, 0\n"
+            << "  br i1 %c, label %fail, label %ok\n"
+            << "fail:\n"
+            << "  call void @__assert_fail(i8* null, i8* null, i32 0, i8* null)\n"
+            << "  br label %ok\n"
+            << "ok:\n"
+            << "  ret i32 0\n"
+            << "}\n";
+    }
+
+public:
+    Generator(const Parameters& p)
+    : params(p), rand(p.seed),
+      globalsNum(std::max(4u, p.functions / 4)),
+      layerSize((p.functions + p.depth - 1) / p.depth) {}
+
+    std::string generate() {
+        declarations();
+        lists();
+        for (unsigned f = 0; f < params.functions; ++f)
+            workerFunction(f);
+        threadFunctions();
+        mainFunction();
+        return out.str();
+    }
+};
+
+void usage(const char *prog) {
+    std::cerr << "Usage: " << prog << " [-functions N] [-depth D] [-calls C]"
+              << " [-pointers P] [-fptr-tables T] [-lists L] [-threads K]"
+              << " [-seed S] [-o output.ll]\n";
+}
+
+} // anonymous namespace
+
+int main(int argc, char *argv[])
+{
+    Parameters params;
+    const char *output = nullptr;
+
+    struct {
+        const char *name;
+        unsigned *value;
+    } numeric[] = {
+        {"-functions", &params.functions},
+        {"-depth", &params.depth},
+        {"-calls", &params.calls},
+        {"-pointers", &params.pointers},
+        {"-fptr-tables", &params.fptrTables},
+        {"-lists", &params.lists},
+        {"-threads", &params.threads},
+        {"-seed", &params.seed},
+    };
+
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output = argv[++i];
+            continue;
+        }
+
+        bool found = false;
+        for (auto& opt : numeric) {
+            if (strcmp(argv[i], opt.name) == 0 && i + 1 < argc) {
+                *opt.value = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 0));
+                found = true;
+                break;
+            }
+        }
+
+        if (!found) {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (params.functions == 0 || params.depth == 0) {
+        std::cerr << "The number of functions and the depth must be positive\n";
+        return 1;
+    }
+
+    std::string module = Generator(params).generate();
+    if (!output) {
+        std::cout << module;
+        return 0;
+    }
+
+    std::ofstream out(output);
+    out << module;
+    if (!out.good()) {
+        std::cerr << "Failed writing " << output << "\n";
+        return 1;
+    }
+
+    return 0;
+}
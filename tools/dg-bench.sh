@@ -0,0 +1,172 @@
+#!/bin/bash
+#
+# Run llvm-slicer with every configuration of the analyses on the modules
+# generated by dg-bench-gen and write the results into a table,
+# so that the scaling of the analyses can be compared between commits.
+#
+# Usage: dg-bench.sh [-o results.json] [-format json|csv] [-sizes "N ..."]
+#                    [-pta "fi fs inv"] [-rda "dense ss demand mssa"]
+#                    [-cd-alg "classic ce"]
+#                    [-timeout SECONDS] [-gen dg-bench-gen] [-slicer llvm-slicer]
+#                    [options of dg-bench-gen]
+#
+# The sizes are the numbers of functions of the generated modules,
+# the other options (-depth, -calls, -pointers, -fptr-tables, -lists,
+# -threads, -seed) are passed to dg-bench-gen. In the JSON format,
+# every run has also the time report of llvm-slicer (-time-report).
+# The runs that fail or time out are in the table with their status.
+
+set -e
+
+DIR="$(cd "$(dirname "$0")" && pwd)"
+
+OUTPUT="dg-bench.json"
+FORMAT="json"
+SIZES="10 20 40 80"
+PTA="fi fs inv"
+RDA="dense ss demand mssa"
+CD_ALG="classic ce"
+TIMEOUT=300
+GEN="$DIR/dg-bench-gen"
+SLICER="$DIR/llvm-slicer"
+GEN_OPTS=()
+THREADS=0
+
+while [ $# -gt 0 ]; do
+	case "$1" in
+		-o) OUTPUT="$2"; shift ;;
+		-format) FORMAT="$2"; shift ;;
+		-sizes) SIZES="$2"; shift ;;
+		-pta) PTA="$2"; shift ;;
+		-rda) RDA="$2"; shift ;;
+		-cd-alg) CD_ALG="$2"; shift ;;
+		-timeout) TIMEOUT="$2"; shift ;;
+		-gen) GEN="$2"; shift ;;
+		-slicer) SLICER="$2"; shift ;;
+		-threads) THREADS="$2"; GEN_OPTS+=("$1" "$2"); shift ;;
+		-depth|-calls|-pointers|-fptr-tables|-lists|-seed)
+			GEN_OPTS+=("$1" "$2"); shift ;;
+		*)
+			echo "Unknown option: $1" >&2
+			exit 1 ;;
+	esac
+	shift
+done
+
+if [ "$FORMAT" != "json" -a "$FORMAT" != "csv" ]; then
+	echo "Unknown format: $FORMAT" >&2
+	exit 1
+fi
+
+for BIN in "$GEN" "$SLICER"; do
+	if [ ! -x "$BIN" ]; then
+		echo "Do not have $BIN" >&2
+		exit 1
+	fi
+done
+
+SLICER_OPTS=()
+if [ "$THREADS" != "0" ]; then
+	SLICER_OPTS+=(-threads)
+fi
+
+TIMEOUT_CMD=()
+if which timeout &>/dev/null; then
+	TIMEOUT_CMD=(timeout "$TIMEOUT")
+fi
+
+TMP="$(mktemp -d)"
+trap 'rm -rf "$TMP"' EXIT
+
+COMMIT="$(git -C "$DIR" rev-parse HEAD 2>/dev/null || echo unknown)"
+DATE="$(date -u +%Y-%m-%dT%H:%M:%SZ)"
+
+# the parameters of the module as a JSON object
+gen_params() {
+	local SIZE="$1"
+	printf '"functions": %s' "$SIZE"
+	set -- "${GEN_OPTS[@]}"
+	while [ $# -gt 0 ]; do
+		printf ', "%s": %s' "$(echo "${1#-}" | tr '-' '_')" "$2"
+		shift 2
+	done
+}
+
+# the same as CSV columns
+gen_params_csv() {
+	local SIZE="$1"
+	printf '%s' "$SIZE"
+	for P in -depth -calls -pointers -fptr-tables -lists -threads -seed; do
+		local VAL=""
+		set -- "${GEN_OPTS[@]}"
+		while [ $# -gt 0 ]; do
+			if [ "$1" = "$P" ]; then VAL="$2"; fi
+			shift 2
+		done
+		printf ',%s' "$VAL"
+	done
+}
+
+if [ "$FORMAT" = "json" ]; then
+	printf '{\n"commit": "%s",\n"date": "%s",\n"runs": [' "$COMMIT" "$DATE" > "$OUTPUT"
+else
+	echo "commit,functions,depth,calls,pointers,fptr_tables,lists,threads,seed,pta,rda,cd_alg,status,exit_code,wall_time,nodes,removed_nodes" > "$OUTPUT"
+fi
+
+FIRST=1
+for SIZE in $SIZES; do
+	MODULE="$TMP/module-$SIZE.ll"
+	"$GEN" -functions "$SIZE" "${GEN_OPTS[@]}" -o "$MODULE"
+
+	for P in $PTA; do
+	for R in $RDA; do
+	for C in $CD_ALG; do
+		echo "functions=$SIZE pta=$P rda=$R cd-alg=$C" >&2
+
+		rm -f "$TMP/report.json"
+		START=$(date +%s%N)
+		EXIT=0
+		"${TIMEOUT_CMD[@]}" "$SLICER" -c __assert_fail -pta "$P" -rda "$R" -cd-alg "$C" \
+			"${SLICER_OPTS[@]}" -time-report="$TMP/report.json" \
+			"$MODULE" -o "$TMP/sliced.bc" 2>"$TMP/log" || EXIT=$?
+		END=$(date +%s%N)
+
+		STATUS=ok
+		if [ ${#TIMEOUT_CMD[@]} -gt 0 -a $EXIT = 124 ]; then
+			STATUS=timeout
+		elif [ $EXIT != 0 ]; then
+			STATUS=failed
+		fi
+
+		WALL="$(awk -v s="$START" -v e="$END" 'BEGIN { printf "%.3f", (e - s) / 1e9 }')"
+		# INFO: Sliced away X from Y nodes in DG
+		REMOVED="$(sed -n 's/.*Sliced away \([0-9]*\) from.*/\1/p' "$TMP/log" | tail -1)"
+		NODES="$(sed -n 's/.*Sliced away [0-9]* from \([0-9]*\) nodes.*/\1/p' "$TMP/log" | tail -1)"
+
+		if [ "$FORMAT" = "json" ]; then
+			[ $FIRST = 1 ] || printf ',' >> "$OUTPUT"
+			FIRST=0
+			{
+				printf '\n{%s, "pta": "%s", "rda": "%s", "cd_alg": "%s", ' \
+					"$(gen_params "$SIZE")" "$P" "$R" "$C"
+				printf '"status": "%s", "exit_code": %s, "wall_time": %s, "nodes": %s, "removed_nodes": %s' \
+					"$STATUS" "$EXIT" "$WALL" "${NODES:-null}" "${REMOVED:-null}"
+				if [ "$STATUS" = ok -a -s "$TMP/report.json" ]; then
+					printf ',\n"report":\n'
+					cat "$TMP/report.json"
+				fi
+				printf '}'
+			} >> "$OUTPUT"
+		else
+			echo "$COMMIT,$(gen_params_csv "$SIZE"),$P,$R,$C,$STATUS,$EXIT,$WALL,$NODES,$REMOVED" >> "$OUTPUT"
+		fi
+	done
+	done
+	done
+done
+
+if [ "$FORMAT" = "json" ]; then
+	printf '\n]\n}\n' >> "$OUTPUT"
+fi
+
+echo "Results written to $OUTPUT" >&2
@@ -70,6 +70,8 @@ int main(int argc, char *argv[])
     const char *pts = "fi";
     const char *rda = "dense";
     const char *entry_func = "main";
+    const char *time_report = "";
+    const char *trace = "";
     CD_ALG cd_alg = CD_ALG::CLASSIC;
 
     using namespace debug;
@@ -120,6 +122,14 @@ int main(int argc, char *argv[])
                 abort();
             }
 
+        } else if (strcmp(argv[i], "-time-report") == 0) {
+            time_report = argv[++i];
+        } else if (strncmp(argv[i], "-time-report=", 13) == 0) {
+            time_report = argv[i] + 13;
+        } else if (strcmp(argv[i], "-trace") == 0) {
+            trace = argv[++i];
+        } else if (strncmp(argv[i], "-trace=", 7) == 0) {
+            trace = argv[i] + 7;
         } else {
             module = argv[i];
         }
@@ -176,7 +186,13 @@ int main(int argc, char *argv[])
         abort();
     }
 
+    // written into the file when main() returns
+    TimeReportFile timeReport(time_report, "llvm-dg-dump");
+    if (*trace)
+        startTracing(trace);
+
     llvmdg::LLVMDependenceGraphBuilder builder(M, options);
+    builder.setTimeReport(timeReport.get());
     auto dg = builder.build();
 
 
@@ -687,6 +687,7 @@ int main(int argc, char *argv[])
     const char *module = nullptr;
     PTType type = FLOW_INSENSITIVE;
     uint64_t field_senitivity = Offset::UNKNOWN;
+    const char *time_report = "";
 
     // parse options
     for (int i = 1; i < argc; ++i) {
@@ -723,6 +724,10 @@ int main(int argc, char *argv[])
             entry_func = argv[i + 1];
         } else if (strcmp(argv[i], "-display-only") == 0) {
             display_only = argv[i + 1];
+        } else if (strcmp(argv[i], "-time-report") == 0) {
+            time_report = argv[++i];
+        } else if (strncmp(argv[i], "-time-report=", 13) == 0) {
+            time_report = argv[i] + 13;
         } else {
             module = argv[i];
         }
@@ -747,6 +752,9 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    // written into the file when main() returns
+    dg::debug::TimeReportFile timeReport(time_report, "llvm-ps-dump");
+
     TimeMeasure tm;
     if (display_only) {
         for (const auto& func : splitList(display_only)) {
@@ -763,6 +771,8 @@ int main(int argc, char *argv[])
     LLVMPointerAnalysis PTA(M, entry_func, field_senitivity, threads);
 
     tm.start();
+    std::unique_ptr<dg::util::TimeReport::Scope> phase(
+        new dg::util::TimeReport::Scope(timeReport.get(), "pointer analysis"));
 
     // use createAnalysis instead of the run() method so that we won't delete
     // the analysis data (like memory objects) which may be needed
@@ -801,6 +811,14 @@ int main(int argc, char *argv[])
         PA->run();
     }
 
+    if (timeReport.get()) {
+        timeReport.get()->setCounter("nodes", PA->getPS()->size());
+        timeReport.get()->setCounter("iterations", PA->getIterationsNum());
+        timeReport.get()->setCounter("processed nodes",
+                                     PA->getProcessedNodesNum());
+    }
+    phase.reset();
+
     tm.stop();
     tm.report("INFO: Points-to analysis [new] took");
 
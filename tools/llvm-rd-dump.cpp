@@ -169,8 +169,9 @@ dumpMap(RDNode *node, bool dot = false)
     }
 }
 
+template <typename DefSites>
 static void
-dumpDefSites(const std::set<DefSite>& defs, const char *kind, bool dot = false)
+dumpDefSites(const DefSites& defs, const char *kind, bool dot = false)
 {
     for (const DefSite& def : defs) {
         printf("%s: ", kind);
@@ -271,6 +272,26 @@ dumpRDdot(LLVMReachingDefinitions *RD, bool dump_rd)
     printf("}\n");
 }
 
+static void
+dumpMemoryUsage(LLVMReachingDefinitions *RD)
+{
+    RDMapMemoryCounter counter;
+    for (RDNode *node : RD->getNodes())
+        counter.add(node->getReachingDefinitions());
+
+    llvm::errs() << "INFO: Reaching definitions maps: " << counter.maps
+                 << " (" << counter.sharedMaps << " shared with another node)\n"
+                 << "INFO: Stored " << counter.chunks << " chunks, "
+                 << counter.entries << " def-sites and "
+                 << counter.definitions << " definitions\n"
+                 << "INFO: Without sharing: " << counter.unsharedEntries
+                 << " def-sites and " << counter.unsharedDefinitions
+                 << " definitions\n"
+                 << "INFO: Estimated memory: " << counter.bytes() / 1024
+                 << " kB (" << counter.unsharedBytes() / 1024
+                 << " kB without sharing)\n";
+}
+
 static void
 dumpRD(LLVMReachingDefinitions *RD, bool todot, bool dump_rd)
 {
@@ -292,10 +313,12 @@ int main(int argc, char *argv[])
     bool todot = false;
     bool threads = false;
     bool dump_rd = false;
+    bool memory = false;
     const char *module = nullptr;
     Offset::type field_senitivity = Offset::UNKNOWN;
     bool rd_strong_update_unknown = false;
     Offset::type max_set_size = Offset::UNKNOWN;
+    const char *time_report = "";
 
     enum {
         FLOW_SENSITIVE = 1,
@@ -334,15 +357,21 @@ int main(int argc, char *argv[])
             verbose = true;
         } else if (strcmp(argv[i], "-dump-rd") == 0) {
             dump_rd = true;
+        } else if (strcmp(argv[i], "-memory") == 0) {
+            memory = true;
         } else if (strcmp(argv[i], "-entry") == 0) {
             entryFunc = argv[i+1];
+        } else if (strcmp(argv[i], "-time-report") == 0) {
+            time_report = argv[++i];
+        } else if (strncmp(argv[i], "-time-report=", 13) == 0) {
+            time_report = argv[i] + 13;
         } else {
             module = argv[i];
         }
     }
 
     if (!module) {
-        errs() << "Usage: % IR_module [-pts fs|fi] [-dot] [-v] [output_file]\n";
+        errs() << "Usage: % IR_module [-pts fs|fi] [-dot] [-v] [-memory] [output_file]\n";
         return 1;
     }
 
@@ -360,16 +389,27 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    // written into the file when main() returns
+    debug::TimeReportFile timeReport(time_report, "llvm-rd-dump");
     debug::TimeMeasure tm;
 
     LLVMPointerAnalysis PTA(M, entryFunc, field_senitivity, threads);
 
     tm.start();
 
-    if (type == FLOW_INSENSITIVE) {
-        PTA.run<pta::PointerAnalysisFI>();
-    } else {
-        PTA.run<pta::PointerAnalysisFS>();
+    {
+        util::TimeReport::Scope phase(timeReport.get(), "pointer analysis");
+        if (type == FLOW_INSENSITIVE) {
+            PTA.run<pta::PointerAnalysisFI>();
+        } else {
+            PTA.run<pta::PointerAnalysisFS>();
+        }
+
+        if (timeReport.get()) {
+            timeReport.get()->setCounter("iterations", PTA.getIterationsNum());
+            timeReport.get()->setCounter("processed nodes",
+                                         PTA.getProcessedNodesNum());
+        }
     }
 
     tm.stop();
@@ -383,13 +423,25 @@ int main(int argc, char *argv[])
 
     LLVMReachingDefinitions RD(M, &PTA, opts);
     tm.start();
-    if (rda == RdaType::SEMISPARSE) {
-        RD.run<dg::analysis::rd::SemisparseRda>();
-    } else
-        RD.run<dg::analysis::rd::ReachingDefinitionsAnalysis>();
+    {
+        util::TimeReport::Scope phase(timeReport.get(), "reaching definitions");
+        if (rda == RdaType::SEMISPARSE) {
+            RD.run<dg::analysis::rd::SemisparseRda>();
+        } else
+            RD.run<dg::analysis::rd::ReachingDefinitionsAnalysis>();
+
+        if (timeReport.get()) {
+            timeReport.get()->setCounter("iterations", RD.getIterationsNum());
+            timeReport.get()->setCounter("processed nodes",
+                                         RD.getProcessedNodesNum());
+        }
+    }
     tm.stop();
     tm.report("INFO: Reaching definitions analysis took");
 
+    if (memory)
+        dumpMemoryUsage(&RD);
+
     dumpRD(&RD, todot, dump_rd);
 
     return 0;
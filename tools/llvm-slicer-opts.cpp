@@ -30,7 +30,7 @@ SlicerOptions parseSlicerOptions(int argc, char *argv[]) {
     llvm::cl::opt<std::string> inputFile(llvm::cl::Positional, llvm::cl::Required,
         llvm::cl::desc("<input file>"), llvm::cl::init(""), llvm::cl::cat(SlicingOpts));
 
-    llvm::cl::opt<std::string> slicingCriteria("c", llvm::cl::Required,
+    llvm::cl::opt<std::string> slicingCriteria("c",
         llvm::cl::desc("Slice with respect to the call-sites of a given function\n"
                        "i. e.: '-c foo' or '-c __assert_fail'. Special value is a 'ret'\n"
                        "in which case the slice is taken with respect to the return value\n"
@@ -39,7 +39,11 @@ SlicerOptions parseSlicerOptions(int argc, char *argv[]) {
                        "l must be empty when v is a global variable. For local variables,\n"
                        "the variable v must be used on the line l.\n"
                        "You can use comma-separated list of more slicing criteria,\n"
-                       "e.g. -c foo,5:x,:glob\n"), llvm::cl::value_desc("crit"),
+                       "e.g. -c foo,5:x,:glob\n"
+                       "More slices can be computed at once by separating\n"
+                       "groups of criteria with ';', e.g. -c 'foo;bar,5:x'.\n"
+                       "The i-th slice is then saved to <output>.i.bc\n"
+                       "Required unless the slicer runs as a server (-server).\n"), llvm::cl::value_desc("crit"),
                        llvm::cl::init(""), llvm::cl::cat(SlicingOpts));
 
     llvm::cl::opt<std::string> secondarySlicingCriteria("2c",
@@ -84,6 +88,14 @@ SlicerOptions parseSlicerOptions(int argc, char *argv[]) {
                        "the whole memory. May be unsound for out-of-bound access\n"),
                        llvm::cl::init(false), llvm::cl::cat(SlicingOpts));
 
+    llvm::cl::opt<bool> rdaModRefSummaries("rd-modref-summaries",
+        llvm::cl::desc("Let definitions of memory bypass the procedures that do not\n"
+                       "touch the memory (using mod/ref summaries of procedures).\n"
+                       "The definitions are then missing inside these procedures,\n"
+                       "which def-use analysis does not query. Not used with threads.\n"
+                       "Default: false\n"),
+                       llvm::cl::init(false), llvm::cl::cat(SlicingOpts));
+
     llvm::cl::opt<bool> undefinedArePure("undefined-are-pure",
         llvm::cl::desc("Assume that undefined functions have no side-effects\n"),
                        llvm::cl::init(false), llvm::cl::cat(SlicingOpts));
@@ -96,10 +108,53 @@ SlicerOptions parseSlicerOptions(int argc, char *argv[]) {
         llvm::cl::desc("Perform forward slicing\n"),
                        llvm::cl::init(false), llvm::cl::cat(SlicingOpts));
 
+    llvm::cl::opt<bool> twoPhaseSlicing("two-phase-slicing",
+        llvm::cl::desc("Compute summary edges of procedures and use the two-phase\n"
+                       "context-sensitive interprocedural slicing (backward slicing\n"
+                       "only). Default: false\n"),
+                       llvm::cl::init(false), llvm::cl::cat(SlicingOpts));
+
+    llvm::cl::opt<std::string> dgCacheFile("dg-cache",
+        llvm::cl::desc("Store the dependence graph into the given file and load it\n"
+                       "from the file next time instead of building it (if the file\n"
+                       "was created for the same module and the same options of\n"
+                       "the analyses). Not used with the criteria or annotations\n"
+                       "that need the pointer analysis or reaching definitions.\n"),
+                       llvm::cl::value_desc("file"),
+                       llvm::cl::init(""), llvm::cl::cat(SlicingOpts));
+
+    llvm::cl::opt<std::string> timeReportFile("time-report",
+        llvm::cl::desc("Write the wall and CPU time, the memory and the statistics\n"
+                       "(e.g., iterations of the analyses) of the phases\n"
+                       "of slicing into the file as JSON\n"),
+                       llvm::cl::value_desc("file"),
+                       llvm::cl::init(""), llvm::cl::cat(SlicingOpts));
+
+    llvm::cl::opt<std::string> traceFile("trace",
+        llvm::cl::desc("Write the trace of the analyses into the file in the Chrome\n"
+                       "trace-event format (about:tracing, Perfetto). The same\n"
+                       "as setting the DG_TRACE environment variable\n"),
+                       llvm::cl::value_desc("file"),
+                       llvm::cl::init(""), llvm::cl::cat(SlicingOpts));
+
     llvm::cl::opt<bool> threads("threads",
         llvm::cl::desc("Consider threads are in input file (default=false)."),
         llvm::cl::init(false), llvm::cl::cat(SlicingOpts));
 
+    llvm::cl::opt<unsigned> buildThreads("dg-build-threads",
+        llvm::cl::desc("Create the nodes of functions and compute their\n"
+                       "control dependencies using N threads\n"
+                       "(0 = the number of cores). Default: 1\n"),
+                       llvm::cl::value_desc("N"),
+                       llvm::cl::init(1), llvm::cl::cat(SlicingOpts));
+
+    llvm::cl::opt<bool> lazyDG("lazy-dg",
+        llvm::cl::desc("Build the graphs of functions and compute their\n"
+                       "dependencies only when the slicing reaches them.\n"
+                       "The slice is the same. Only for backward slicing\n"
+                       "w.r.t. one group of criteria. Default: false\n"),
+                       llvm::cl::init(false), llvm::cl::cat(SlicingOpts));
+
     llvm::cl::opt<LLVMPointerAnalysisOptions::AnalysisType> ptaType("pta",
         llvm::cl::desc("Choose pointer analysis to use:"),
         llvm::cl::values(
@@ -116,7 +171,9 @@ SlicerOptions parseSlicerOptions(int argc, char *argv[]) {
         llvm::cl::desc("Choose reaching definitions analysis to use:"),
         llvm::cl::values(
             clEnumValN(LLVMReachingDefinitionsAnalysisOptions::AnalysisType::dense, "dense", "Dense RDA (default)"),
-            clEnumValN(LLVMReachingDefinitionsAnalysisOptions::AnalysisType::ss,    "ss",    "Semi-sparse RDA")
+            clEnumValN(LLVMReachingDefinitionsAnalysisOptions::AnalysisType::ss,    "ss",    "Semi-sparse RDA"),
+            clEnumValN(LLVMReachingDefinitionsAnalysisOptions::AnalysisType::demand, "demand", "Demand-driven RDA"),
+            clEnumValN(LLVMReachingDefinitionsAnalysisOptions::AnalysisType::mssa,   "mssa",   "Memory-SSA based RDA")
     #if LLVM_VERSION_MAJOR < 4
             , nullptr
     #endif
@@ -161,6 +218,10 @@ SlicerOptions parseSlicerOptions(int argc, char *argv[]) {
     options.preservedFunctions = splitList(preservedFuns);
     options.removeSlicingCriteria = removeSlicingCriteria;
     options.forwardSlicing = forwardSlicing;
+    options.twoPhaseSlicing = twoPhaseSlicing;
+    options.dgCacheFile = dgCacheFile;
+    options.timeReportFile = timeReportFile;
+    options.traceFile = traceFile;
 
     options.dgOptions.entryFunction = entryFunction;
     options.dgOptions.PTAOptions.entryFunction = entryFunction;
@@ -169,12 +230,15 @@ SlicerOptions parseSlicerOptions(int argc, char *argv[]) {
     options.dgOptions.PTAOptions.analysisType = ptaType;
 
     options.dgOptions.threads = threads;
+    options.dgOptions.buildThreads = buildThreads;
+    options.dgOptions.lazy = lazyDG;
     options.dgOptions.PTAOptions.threads = threads;
     options.dgOptions.RDAOptions.threads = threads;
 
     options.dgOptions.RDAOptions.entryFunction = entryFunction;
     options.dgOptions.RDAOptions.strongUpdateUnknown = rdaStrongUpdateUnknown;
     options.dgOptions.RDAOptions.undefinedArePure = undefinedArePure;
+    options.dgOptions.RDAOptions.modRefSummaries = rdaModRefSummaries;
     options.dgOptions.RDAOptions.analysisType = rdaType;
 
     options.dgOptions.DUOptions.undefinedArePure = undefinedArePure;
@@ -26,6 +26,24 @@ struct SlicerOptions {
     // do we perform forward slicing?
     bool forwardSlicing{false};
 
+    // use summary edges and the two-phase (context-sensitive)
+    // interprocedural slicing (backward slicing only)
+    bool twoPhaseSlicing{false};
+
+    // print the statistics of slicing (-statistics)
+    bool statistics{false};
+
+    // store the dependence graph into this file after it is built
+    // and load it from there if the file is up to date
+    std::string dgCacheFile{};
+
+    // write the time and memory spent in the phases into this file (JSON)
+    std::string timeReportFile{};
+
+    // write the trace of the analyses into this file
+    // (Chrome trace-event format)
+    std::string traceFile{};
+
     std::string slicingCriteria{};
     std::string secondarySlicingCriteria{};
     std::string inputFile{};
@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <set>
 #include <string>
 
@@ -37,6 +38,8 @@
 #include <llvm/Bitcode/ReaderWriter.h>
 #endif
 
+#include <llvm/IR/Constants.h>
+#include <llvm/IR/GlobalAlias.h>
 #include <llvm/IR/LLVMContext.h>
 #include <llvm/IR/Instructions.h>
 #include <llvm/Support/SourceMgr.h>
@@ -55,8 +58,24 @@
 #pragma GCC diagnostic pop
 #endif
 
+#include <atomic>
+#include <functional>
 #include <iostream>
 #include <fstream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+#ifdef LLVM_ON_UNIX
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
 
 #include "dg/ADT/Queue.h"
 #include "dg/llvm/LLVMDG2Dot.h"
@@ -107,19 +126,52 @@ llvm::cl::opt<std::string> annotationOpts("annotate",
     llvm::cl::value_desc("val1,val2,..."), llvm::cl::init(""),
     llvm::cl::cat(SlicingOpts));
 
+llvm::cl::opt<std::string> server("server",
+    llvm::cl::desc("Build the dependence graph once and then slice w.r.t.\n"
+                   "the requests read from the given path: '-' is the standard\n"
+                   "input, a named pipe is read as a file, otherwise a Unix\n"
+                   "socket is created at the path. A request is a line\n"
+                   "'backward|forward <output> <criteria> [<secondary criteria>]'\n"
+                   "and the answer is 'OK <output>' or 'ERROR <message>'.\n"
+                   "The line 'quit' stops the server."),
+    llvm::cl::value_desc("path"), llvm::cl::init(""),
+    llvm::cl::cat(SlicingOpts));
+
+llvm::cl::opt<unsigned> serverJobs("server-jobs",
+    llvm::cl::desc("The number of requests that the server slices at once\n"
+                   "(default=0, the number of cores)."),
+    llvm::cl::init(0), llvm::cl::cat(SlicingOpts));
+
+llvm::cl::opt<unsigned> sliceThreads("slice-threads",
+    llvm::cl::desc("Slice more groups of criteria ('-c foo;bar') by the given\n"
+                   "number of threads that prune copies of the module\n"
+                   "instead of slicing in child processes (default=0).\n"),
+    llvm::cl::init(0), llvm::cl::cat(SlicingOpts));
+
 
-// mapping of AllocaInst to the names of C variables
-std::map<const llvm::Value *, std::string> valuesToVariables;
 
 class ModuleWriter {
     const SlicerOptions& options;
     llvm::Module *M;
+    dg::util::TimeReport *timeReport{nullptr};
+    // taken while printing if more threads save their modules at once
+    std::mutex *outputLock{nullptr};
+
+    std::unique_lock<std::mutex> lockOutput()
+    {
+        if (!outputLock)
+            return std::unique_lock<std::mutex>();
+        return std::unique_lock<std::mutex>(*outputLock);
+    }
 
 public:
     ModuleWriter(const SlicerOptions& o,
                  llvm::Module *m)
     : options(o), M(m) {}
 
+    void setTimeReport(dg::util::TimeReport *report) { timeReport = report; }
+    void setOutputLock(std::mutex *lock) { outputLock = lock; }
+
     int cleanAndSaveModule(bool should_verify_module = true) {
         // remove unneeded parts of the module
         removeUnusedFromModule();
@@ -132,19 +184,33 @@ public:
 
     int saveModule(bool should_verify_module = true)
     {
+        dg::util::TimeReport::Scope phase(timeReport, "saving module");
         if (should_verify_module)
             return verifyAndWriteModule();
         else
             return writeModule();
     }
 
+    // Remove the functions, global variables and aliases that are not
+    // reachable over the uses from the entry function and the functions
+    // that we must keep. Everything is removed at once, so also the chains
+    // and cycles of dead functions that reference each other.
     void removeUnusedFromModule()
     {
-        bool fixpoint;
-
-        do {
-            fixpoint = _removeUnusedFromModule();
-        } while (fixpoint);
+        dg::util::TimeReport::Scope phase(timeReport, "removing unused");
+        dg::debug::TimeMeasure tm;
+        tm.start();
+
+        size_t removed = _removeUnusedFromModule();
+        if (timeReport)
+            timeReport->addCounter("removed", removed);
+
+        tm.stop();
+        if (statistics) {
+            auto guard = lockOutput();
+            tm.report("INFO: Removing " + std::to_string(removed) +
+                      " unused functions and globals took");
+        }
     }
 
     // after we slice the LLVM, we somethimes have troubles
@@ -184,7 +250,10 @@ private:
         llvm::raw_os_ostream ostream(ofs);
 
         // write the module
-        errs() << "INFO: saving sliced module to: " << fl.c_str() << "\n";
+        {
+            auto guard = lockOutput();
+            errs() << "INFO: saving sliced module to: " << fl.c_str() << "\n";
+        }
 
     #if (LLVM_VERSION_MAJOR > 6)
         llvm::WriteBitcodeToFile(*M, ostream);
@@ -201,7 +270,13 @@ private:
         // are no errors
 
 #if ((LLVM_VERSION_MAJOR >= 4) || (LLVM_VERSION_MINOR >= 5))
-        return !llvm::verifyModule(*M, &llvm::errs());
+        // print the errors at once, the output may be shared by more threads
+        std::string errors;
+        llvm::raw_string_ostream ss(errors);
+        bool ret = !llvm::verifyModule(*M, &ss);
+        auto guard = lockOutput();
+        errs() << ss.str();
+        return ret;
 #else
        return !llvm::verifyModule(*M, llvm::PrintMessageAction);
 #endif
@@ -211,12 +286,14 @@ private:
     int verifyAndWriteModule()
     {
         if (!verifyModule()) {
+            auto guard = lockOutput();
             errs() << "ERR: Verifying module failed, the IR is not valid\n";
             errs() << "INFO: Saving anyway so that you can check it\n";
             return 1;
         }
 
         if (!writeModule()) {
+            auto guard = lockOutput();
             errs() << "Saving sliced module failed\n";
             return 1;
         }
@@ -225,7 +302,7 @@ private:
         return 0;
     }
 
-    bool _removeUnusedFromModule()
+    size_t _removeUnusedFromModule()
     {
         using namespace llvm;
         // do not slice away these functions no matter what
@@ -234,47 +311,89 @@ private:
         const char *keep[] = {options.dgOptions.entryFunction.c_str(),
                               "klee_assume", nullptr};
 
-        // when erasing while iterating the slicer crashes
-        // so set the to be erased values into container
-        // and then erase them
-        std::set<Function *> funs;
-        std::set<GlobalVariable *> globals;
-        std::set<GlobalAlias *> aliases;
-
-        for (auto I = M->begin(), E = M->end(); I != E; ++I) {
-            Function *func = &*I;
-            if (array_match(func->getName(), keep))
-                continue;
+        std::set<const GlobalValue *> live;
+        std::set<const Constant *> visitedConstants;
+        std::vector<const GlobalValue *> queue;
+
+        // mark the global values that the value refers to
+        // (possibly through constant expressions and initializers)
+        std::function<void(const Value *)> visit = [&](const Value *val) {
+            if (const GlobalValue *GV = dyn_cast<GlobalValue>(val)) {
+                if (live.insert(GV).second)
+                    queue.push_back(GV);
+            } else if (const Constant *C = dyn_cast<Constant>(val)) {
+                if (!visitedConstants.insert(C).second)
+                    return;
+                for (const Use& op : C->operands())
+                    visit(op.get());
+            }
+        };
 
-            // if the function is unused or we haven't constructed it
-            // at all in dependence graph, we can remove it
-            // (it may have some uses though - like when one
-            // unused func calls the other unused func
-            if (func->hasNUses(0))
-                funs.insert(func);
+        for (const Function& F : *M) {
+            if (array_match(F.getName(), keep))
+                visit(&F);
         }
+        for (const auto& fun : options.preservedFunctions) {
+            if (const Function *F = M->getFunction(fun))
+                visit(F);
+        }
+#if LLVM_VERSION_MAJOR >= 4
+        // we never remove ifuncs
+        for (const GlobalIFunc& gi : M->ifuncs())
+            visit(&gi);
+#endif
+
+        while (!queue.empty()) {
+            const GlobalValue *GV = queue.back();
+            queue.pop_back();
 
-        for (auto I = M->global_begin(), E = M->global_end(); I != E; ++I) {
-            GlobalVariable *gv = &*I;
-            if (gv->hasNUses(0))
-                globals.insert(gv);
+            // the initializer, aliasee, personality function...
+            for (const Use& op : GV->operands()) {
+                if (op.get())
+                    visit(op.get());
+            }
+
+            if (const Function *F = dyn_cast<Function>(GV)) {
+                for (const BasicBlock& B : *F) {
+                    for (const Instruction& I : B) {
+                        for (const Use& op : I.operands()) {
+                            if (isa<Constant>(op.get()))
+                                visit(op.get());
+                        }
+                    }
+                }
+            }
         }
 
+        std::vector<GlobalValue *> dead;
+        for (Function& F : *M) {
+            if (live.count(&F) == 0)
+                dead.push_back(&F);
+        }
+        for (GlobalVariable& gv : M->globals()) {
+            if (live.count(&gv) == 0)
+                dead.push_back(&gv);
+        }
         for (GlobalAlias& ga : M->getAliasList()) {
-            if (ga.hasNUses(0))
-                aliases.insert(&ga);
+            if (live.count(&ga) == 0)
+                dead.push_back(&ga);
         }
 
-        for (Function *f : funs)
-            f->eraseFromParent();
-        for (GlobalVariable *gv : globals)
-            gv->eraseFromParent();
-        for (GlobalAlias *ga : aliases)
-            ga->eraseFromParent();
+        // the dead values may refer to each other,
+        // so first drop all the references and erase them afterwards
+        for (GlobalValue *GV : dead)
+            GV->dropAllReferences();
+
+        for (GlobalValue *GV : dead) {
+            // only dead constant expressions can use the value now
+            GV->removeDeadConstantUsers();
+            if (!GV->use_empty())
+                GV->replaceAllUsesWith(UndefValue::get(GV->getType()));
+            GV->eraseFromParent();
+        }
 
-        return (!funs.empty() || !globals.empty() || !aliases.empty());
+        return dead.size();
     }
-
 };
 
 static void maybe_print_statistics(llvm::Module *M, const char *prefix = nullptr)
@@ -309,6 +428,37 @@ static void maybe_print_statistics(llvm::Module *M, const char *prefix = nullptr
            << gnum << " " << fnum << " " << bnum << " " << inum << "\n";
 }
 
+// print the functions for that computing control dependencies
+// took the most time, so that we can find the problematic ones
+static void maybe_print_cd_statistics(const LLVMDependenceGraph& dg,
+                                      size_t num = 10)
+{
+    if (!statistics)
+        return;
+
+    auto times = dg.getControlDependenceTimes();
+    if (times.empty())
+        return;
+
+    uint64_t total = 0;
+    for (auto& it : times)
+        total += it.second;
+
+    std::sort(times.begin(), times.end(),
+              [](const std::pair<const llvm::Function *, uint64_t>& a,
+                 const std::pair<const llvm::Function *, uint64_t>& b) {
+                    return a.second > b.second;
+              });
+
+    errs() << "Control dependencies of " << times.size()
+           << " functions took " << total / 1000 << " ms (summed per-function wall time)"
+           << ", the slowest functions:\n";
+    for (size_t i = 0; i < times.size() && i < num; ++i) {
+        errs() << "  " << times[i].first->getName() << ": "
+               << times[i].second << " us\n";
+    }
+}
+
 class DGDumper {
     const SlicerOptions& options;
     LLVMDependenceGraph *dg;
@@ -425,11 +575,9 @@ static bool usesTheVariable(LLVMDependenceGraph& dg,
             continue;
 
         if (const llvm::AllocaInst *AI = llvm::dyn_cast<llvm::AllocaInst>(alloca)) {
-            auto name = valuesToVariables.find(AI);
-            if (name != valuesToVariables.end()) {
-                if (name->second == var)
-                    return true;
-            }
+            auto name = dg.getCriteriaIndex()->getVariableName(AI);
+            if (name && *name == var)
+                return true;
         }
     }
 
@@ -464,45 +612,23 @@ static bool isLoadOfTheVar(LLVMDependenceGraph& dg,
 }
 
 
+// the criterion 'line:var' or 'file:line:var', the line is -1
+// for the criterion ':var' (a global variable)
+struct LineCriterion {
+    std::string file;
+    int line;
+    std::string var;
+};
+
 static bool instMatchesCrit(LLVMDependenceGraph& dg,
                             const llvm::Instruction& I,
-                            const std::vector<std::pair<int, std::string>>& parsedCrit)
-{
-    for (const auto& c : parsedCrit) {
-        auto& Loc = I.getDebugLoc();
-#if (LLVM_VERSION_MAJOR == 3 && LLVM_VERSION_MINOR < 7)
-        if (Loc.getLine() <= 0) {
-#else
-        if (!Loc) {
-#endif
-            continue;
-        }
-
-        if (static_cast<int>(Loc.getLine()) != c.first)
-            continue;
-
-        if (isStoreToTheVar(dg, I, c.second) ||
-            isLoadOfTheVar(dg, I, c.second)) {
-            llvm::errs() << "Matched line " << c.first << " with variable "
-                         << c.second << " to:\n" << I << "\n";
-            return true;
-        }
-    }
-
-    return false;
-}
-
-static bool globalMatchesCrit(const llvm::GlobalVariable& G,
-                              const std::vector<std::pair<int, std::string>>& parsedCrit)
+                            const LineCriterion& c)
 {
-    for (const auto& c : parsedCrit) {
-        if (c.first != -1)
-            continue;
-        if (c.second == G.getName().str()) {
-            llvm::errs() << "Matched global variable "
-                         << c.second << " to:\n" << G << "\n";
-            return true;
-        }
+    if (isStoreToTheVar(dg, I, c.var) ||
+        isLoadOfTheVar(dg, I, c.var)) {
+        llvm::errs() << "Matched line " << c.line << " with variable "
+                     << c.var << " to:\n" << I << "\n";
+        return true;
     }
 
     return false;
@@ -524,19 +650,24 @@ static void getLineCriteriaNodes(LLVMDependenceGraph& dg,
 {
     assert(!criteria.empty() && "No criteria given");
 
-    std::vector<std::pair<int, std::string>> parsedCrit;
+    std::vector<LineCriterion> parsedCrit;
     for (auto& crit : criteria) {
         auto parts = splitList(crit, ':');
+        std::string file;
+        if (parts.size() == 3) {
+            file = parts[0];
+            parts.erase(parts.begin());
+        }
         assert(parts.size() == 2);
 
         // parse the line number
         if (parts[0].empty()) {
             // global variable
-            parsedCrit.emplace_back(-1, parts[1]);
+            parsedCrit.push_back({file, -1, parts[1]});
         } else if (isNumber(parts[0])) {
             int line = atoi(parts[0].c_str());
             if (line > 0)
-                parsedCrit.emplace_back(line, parts[1]);
+                parsedCrit.push_back({file, line, parts[1]});
         } else {
             llvm::errs() << "Invalid line: '" << parts[0] << "'. "
                          << "Needs to be a number or empty for global variables.\n";
@@ -549,21 +680,11 @@ static void getLineCriteriaNodes(LLVMDependenceGraph& dg,
     llvm::errs() << "WARNING: Variables names matching is not supported for LLVM older than 3.7\n";
     llvm::errs() << "WARNING: The slicing criteria with variables names will not work\n";
 #else
-    // create the mapping from LLVM values to C variable names
-    for (auto& it : getConstructedFunctions()) {
-        for (auto& I : llvm::instructions(*llvm::cast<llvm::Function>(it.first))) {
-            if (const llvm::DbgDeclareInst *DD = llvm::dyn_cast<llvm::DbgDeclareInst>(&I)) {
-                auto val = DD->getAddress();
-                valuesToVariables[val] = DD->getVariable()->getName().str();
-            } else if (const llvm::DbgValueInst *DV
-                        = llvm::dyn_cast<llvm::DbgValueInst>(&I)) {
-                auto val = DV->getValue();
-                valuesToVariables[val] = DV->getVariable()->getName().str();
-            }
-        }
-    }
+    if (!dg.getCriteriaIndex())
+        dg.buildCriteriaIndex();
+    const LLVMCriteriaIndex *index = dg.getCriteriaIndex();
 
-    if (valuesToVariables.empty()) {
+    if (!index->hasDebugInfo()) {
         llvm::errs() << "No debugging information found in program,\n"
                      << "slicing criteria with lines and variables will not work.\n"
                      << "You can still use the criteria based on call sites ;)\n";
@@ -571,21 +692,28 @@ static void getLineCriteriaNodes(LLVMDependenceGraph& dg,
     }
 
     // map line criteria to nodes
-    for (auto& it : getConstructedFunctions()) {
-        for (auto& I : llvm::instructions(*llvm::cast<llvm::Function>(it.first))) {
-            if (instMatchesCrit(dg, I, parsedCrit)) {
-                LLVMNode *nd = dg.getNode(&I);
-                assert(nd);
-                nodes.insert(nd);
-            }
-        }
-    }
+    for (const auto& c : parsedCrit) {
+        if (c.line == -1) {
+            llvm::GlobalVariable *G
+                = dg.getModule()->getGlobalVariable(c.var, true);
+            if (!G)
+                continue;
 
-    for (auto& G : dg.getModule()->globals()) {
-        if (globalMatchesCrit(G, parsedCrit)) {
-            LLVMNode *nd = dg.getGlobalNode(&G);
+            llvm::errs() << "Matched global variable "
+                         << c.var << " to:\n" << *G << "\n";
+            LLVMNode *nd = dg.getGlobalNode(G);
             assert(nd);
             nodes.insert(nd);
+            continue;
+        }
+
+        for (llvm::Instruction *I : index->getInstructionsOnLine(c.line, c.file)) {
+            if (!instMatchesCrit(dg, *I, c))
+                continue;
+
+            LLVMNode *nd = dg.getOrBuildNode(I);
+            assert(nd && "Do not have the node of the instruction");
+            nodes.insert(nd);
         }
     }
 #endif // LLVM > 3.6
@@ -649,48 +777,24 @@ parseSecondarySlicingCriteria(const std::string& slicingCriteria)
     return {control_criteria, data_criteria};
 }
 
-// FIXME: copied from LLVMDependenceGraph.cpp, do not duplicate the code
-static bool isCallTo(LLVMNode *callNode, const std::set<std::string>& names)
-{
-    using namespace llvm;
-
-    if (!isa<llvm::CallInst>(callNode->getValue())) {
-        return false;
-    }
-
-    // if the function is undefined, it has no subgraphs,
-    // but is not called via function pointer
-    if (!callNode->hasSubgraphs()) {
-        const CallInst *callInst = cast<CallInst>(callNode->getValue());
-        const Value *calledValue = callInst->getCalledValue();
-        const Function *func = dyn_cast<Function>(calledValue->stripPointerCasts());
-        // in the case we haven't run points-to analysis
-        if (!func)
-            return false;
-
-        return array_match(func->getName(), names);
-    } else {
-        // simply iterate over the subgraphs, get the entry node
-        // and check it
-        for (LLVMDependenceGraph *dg : callNode->getSubgraphs()) {
-            LLVMNode *entry = dg->getEntry();
-            assert(entry && "No entry node in graph");
-
-            const Function *func
-                = cast<Function>(entry->getValue()->stripPointerCasts());
-            return array_match(func->getName(), names);
-        }
-    }
-
-    return false;
-}
-
 // mark nodes that are going to be in the slice
 static
-bool findSecondarySlicingCriteria(std::set<LLVMNode *>& criteria_nodes,
+bool findSecondarySlicingCriteria(LLVMDependenceGraph& dg,
+                                  std::set<LLVMNode *>& criteria_nodes,
                                   const std::set<std::string>& secondaryControlCriteria,
                                   const std::set<std::string>& secondaryDataCriteria)
 {
+    // the call-sites of the secondary criteria
+    std::set<LLVMNode *> controlCalls, dataCalls;
+    dg.getCallSites(std::vector<std::string>(secondaryControlCriteria.begin(),
+                                             secondaryControlCriteria.end()),
+                    &controlCalls);
+    dg.getCallSites(std::vector<std::string>(secondaryDataCriteria.begin(),
+                                             secondaryDataCriteria.end()),
+                    &dataCalls);
+    if (controlCalls.empty() && dataCalls.empty())
+        return true;
+
     // FIXME: do this more efficiently (and use the new DFS class)
     std::set<LLVMBBlock *> visited;
     ADT::QueueLIFO<LLVMBBlock *> queue;
@@ -708,9 +812,9 @@ bool findSecondarySlicingCriteria(std::set<LLVMNode *>& criteria_nodes,
         for (auto nd : c->getBBlock()->getNodes()) {
             if (nd == c)
                 break;
-            if (isCallTo(nd, secondaryControlCriteria))
+            if (controlCalls.count(nd) > 0)
                 criteria_nodes.insert(nd);
-            if (isCallTo(nd, secondaryDataCriteria)) {
+            if (dataCalls.count(nd) > 0) {
                 llvm::errs() << "WARNING: Found possible data secondary slicing criterion: "
                             << *nd->getValue() << "\n";
                 llvm::errs() << "This is not fully supported, so adding to be sound\n";
@@ -724,9 +828,9 @@ bool findSecondarySlicingCriteria(std::set<LLVMNode *>& criteria_nodes,
         auto cur = queue.pop();
         for (auto pred : cur->predecessors()) {
             for (auto nd : pred->getNodes()) {
-                if (isCallTo(nd, secondaryControlCriteria))
+                if (controlCalls.count(nd) > 0)
                     criteria_nodes.insert(nd);
-                if (isCallTo(nd, secondaryDataCriteria)) {
+                if (dataCalls.count(nd) > 0) {
                     llvm::errs() << "WARNING: Found possible data secondary slicing criterion: "
                                 << *nd->getValue() << "\n";
                     llvm::errs() << "This is not fully supported, so adding to be sound\n";
@@ -784,6 +888,616 @@ std::unique_ptr<llvm::Module> parseModule(llvm::LLVMContext& context,
     return M;
 }
 
+// the i-th slice (counted from 1) is saved to <output>.i.bc
+static std::string getGroupOutputFile(const SlicerOptions& options,
+                                      size_t idx)
+{
+    std::string fl = options.outputFile.empty() ?
+                        options.inputFile : options.outputFile;
+    replace_suffix(fl, "." + std::to_string(idx) +
+                       (options.outputFile.empty() ? ".sliced" : ".bc"));
+    return fl;
+}
+
+#ifdef LLVM_ON_UNIX
+// Slice w.r.t. one group of the criteria and save the slice.
+// Slicing changes the graph and the module, so we do it in a child
+// process that has its own copy of them (copied on write,
+// so forking is cheap) and the other slices start from the original ones.
+// If 'batchIdx' is not -1, the nodes were already marked by markBatch().
+static bool sliceGroupInChild(Slicer& slicer, llvm::Module *M,
+                              const SlicerOptions& options,
+                              std::set<LLVMNode *>& criteria_nodes,
+                              size_t idx, int batchIdx)
+{
+    pid_t pid = fork();
+    if (pid < 0) {
+        perror("fork");
+        return false;
+    }
+
+    if (pid == 0) {
+        SlicerOptions groupOptions = options;
+        groupOptions.outputFile = getGroupOutputFile(options, idx);
+        ModuleWriter writer(groupOptions, M);
+
+        size_t num = 0;
+        if (criteria_nodes.empty()) {
+            llvm::errs() << "Did not find slicing criteria of the slice "
+                         << idx << "\n";
+            if (!slicer.createEmptyMain())
+                _exit(1);
+        } else {
+            if (batchIdx >= 0)
+                num = slicer.markBatchSlice(batchIdx, criteria_nodes);
+            else
+                slicer.mark(criteria_nodes);
+
+            if (!slicer.slice())
+                _exit(1);
+        }
+
+        if (num > 0)
+            llvm::errs() << "INFO: The slice " << idx << " has "
+                         << num << " nodes\n";
+
+        maybe_print_statistics(M, "Statistics after ");
+        // do not run the destructors of the shared state
+        _exit(writer.cleanAndSaveModule(should_verify_module));
+    }
+
+    int status;
+    if (waitpid(pid, &status, 0) < 0) {
+        perror("waitpid");
+        return false;
+    }
+
+    return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+#endif // LLVM_ON_UNIX
+
+// Slice w.r.t. more groups of criteria by 'threads' threads.
+// The threads only read the dependence graph: every thread marks
+// its slice into its own SliceSet and creates the sliced copy
+// of the module in its own LLVMContext (a context must not be shared
+// by more threads).
+static int sliceCriteriaGroupsInThreads(Slicer& slicer,
+                                        const SlicerOptions& options,
+                                        const std::vector<std::string>& groups,
+                                        std::vector<std::set<LLVMNode *>>& criteria,
+                                        unsigned threads)
+{
+    slicer.prepareReadOnlySlicing();
+
+    std::atomic<size_t> next{0};
+    std::atomic<int> ret{0};
+    std::mutex outputLock;
+
+    auto worker = [&]() {
+        size_t i;
+        while ((i = next++) < criteria.size()) {
+            llvm::LLVMContext ctx;
+            std::unique_ptr<llvm::Module> copy;
+            if (criteria[i].empty()) {
+                {
+                    std::lock_guard<std::mutex> guard(outputLock);
+                    llvm::errs() << "Did not find slicing criteria of the slice "
+                                 << i + 1 << "\n";
+                }
+                copy = slicer.sliceCopy(nullptr, ctx);
+                if (copy && !slicer.createEmptyMain(copy.get()))
+                    copy.reset();
+            } else {
+                dg::analysis::SliceSet<LLVMNode> slice;
+                slicer.markReadOnly(criteria[i], options.forwardSlicing, slice);
+                {
+                    std::lock_guard<std::mutex> guard(outputLock);
+                    llvm::errs() << "INFO: The slice " << i + 1 << " has "
+                                 << slice.size() << " nodes\n";
+                }
+                dg::analysis::SlicerStatistics st;
+                copy = slicer.sliceCopy(&slice, ctx, &st);
+                if (copy) {
+                    std::lock_guard<std::mutex> guard(outputLock);
+                    llvm::errs() << "INFO: Sliced away " << st.nodesRemoved
+                                 << " from " << st.nodesTotal
+                                 << " nodes in DG\n";
+                }
+            }
+
+            SlicerOptions groupOptions = options;
+            groupOptions.outputFile = getGroupOutputFile(options, i + 1);
+            ModuleWriter writer(groupOptions, copy.get());
+            writer.setOutputLock(&outputLock);
+            if (!copy || writer.cleanAndSaveModule(should_verify_module) != 0) {
+                std::lock_guard<std::mutex> guard(outputLock);
+                llvm::errs() << "ERROR: Slicing w.r.t. '" << groups[i]
+                             << "' failed\n";
+                ret = 1;
+            }
+        }
+    };
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < std::min<size_t>(threads, criteria.size()); ++t)
+        workers.emplace_back(worker);
+    worker();
+    for (auto& t : workers)
+        t.join();
+
+    return ret;
+}
+
+// Slice w.r.t. more groups of criteria ('-c foo;bar,baz') and save
+// every slice into a separate module. The dependence graph is built
+// only once and the slices of the backward slicing are marked together
+// by one walk (per BatchWalkAndMark::MAX_SLICES groups).
+static int sliceCriteriaGroups(Slicer& slicer, llvm::Module *M,
+                               const SlicerOptions& options,
+                               const std::vector<std::string>& groups)
+{
+    auto secondaryCriteria
+        = parseSecondarySlicingCriteria(options.secondarySlicingCriteria);
+
+    std::vector<std::set<LLVMNode *>> criteria;
+    criteria.reserve(groups.size());
+    for (const auto& group : groups) {
+        criteria.push_back(getSlicingCriteriaNodes(slicer.getDG(), group));
+        findSecondarySlicingCriteria(slicer.getDG(), criteria.back(),
+                                     secondaryCriteria.first,
+                                     secondaryCriteria.second);
+    }
+
+    if (sliceThreads > 0)
+        return sliceCriteriaGroupsInThreads(slicer, options, groups,
+                                            criteria, sliceThreads);
+
+#ifdef LLVM_ON_UNIX
+    using BatchWalkAndMark = dg::analysis::BatchWalkAndMark<LLVMNode>;
+
+    // the two-phase and forward slicing mark every slice separately
+    bool batch = !options.forwardSlicing && !options.twoPhaseSlicing;
+
+    slicer.computeDependencies();
+
+    int ret = 0;
+    for (size_t start = 0; start < criteria.size();
+         start += BatchWalkAndMark::MAX_SLICES) {
+        size_t end = std::min<size_t>(criteria.size(),
+                                      start + BatchWalkAndMark::MAX_SLICES);
+        if (batch)
+            slicer.markBatch(std::vector<std::set<LLVMNode *>>(
+                                criteria.begin() + start,
+                                criteria.begin() + end));
+
+        for (size_t i = start; i < end; ++i) {
+            if (!sliceGroupInChild(slicer, M, options, criteria[i], i + 1,
+                                   batch ? static_cast<int>(i - start) : -1)) {
+                llvm::errs() << "ERROR: Slicing w.r.t. '" << groups[i]
+                             << "' failed\n";
+                ret = 1;
+            }
+        }
+    }
+
+    return ret;
+#else
+    (void) M;
+    llvm::errs() << "ERROR: More groups of slicing criteria "
+                    "are supported only with -slice-threads on this system\n";
+    return 1;
+#endif // LLVM_ON_UNIX
+}
+
+#ifdef LLVM_ON_UNIX
+///
+// Slicing server: the dependence graph is built once and then the slicing
+// requests are read line by line from the standard input ('-'), a named
+// pipe or from the connections to a Unix socket. A request has the form
+//
+//   backward|forward <output file> <criteria> [<secondary criteria>]
+//
+// and it is answered by the line 'OK <output file>' or 'ERROR <message>'
+// (to the standard output or to the connection of the request).
+// The line 'quit' stops the server.
+//
+// Every request is sliced in a child process like the groups of criteria,
+// so the marks and the slicing never touch the graph and the module
+// of the server. There is nothing to reset between the requests
+// and more requests can be handled at once (the answers then do not
+// have to come in the order of the requests). The child answers
+// the request and exits with 0, if it dies without answering
+// (it is killed, fails an assertion, ...), the server answers
+// 'ERROR <output file> <message>' instead.
+class SlicingServer {
+    Slicer& slicer;
+    llvm::Module *M;
+    const SlicerOptions& options;
+    unsigned maxJobs;
+    bool quit{false};
+
+    // the file descriptors that the children do not need
+    std::vector<int> openFds;
+
+    // the request that a child slices
+    struct Job {
+        // a copy of the descriptor for the answer (the client
+        // may be closed by the server before the child finishes)
+        int replyFd;
+        std::string output;
+    };
+
+    std::map<pid_t, Job> jobs;
+
+    struct Request {
+        bool forward{false};
+        std::string output;
+        std::string criteria;
+        std::string secondaryCriteria;
+    };
+
+    static void respond(int fd, const std::string& msg)
+    {
+        std::string line = msg + "\n";
+        const char *data = line.c_str();
+        size_t len = line.size();
+        while (len > 0) {
+            ssize_t n = write(fd, data, len);
+            if (n < 0) {
+                if (errno == EINTR)
+                    continue;
+                return;
+            }
+
+            data += n;
+            len -= n;
+        }
+    }
+
+    bool parseRequest(const std::string& line, Request& req,
+                      std::string& err) const
+    {
+        std::istringstream ss(line);
+        std::string direction;
+        ss >> direction >> req.output >> req.criteria
+           >> req.secondaryCriteria;
+
+        if (direction == "forward")
+            req.forward = true;
+        else if (direction != "backward") {
+            err = "Unknown direction of slicing: '" + direction + "'";
+            return false;
+        }
+
+        if (req.criteria.empty()) {
+            err = "Expected: backward|forward <output> <criteria> "
+                  "[<secondary criteria>]";
+            return false;
+        }
+
+        // the graph loaded from the cache has no points-to information
+        if (req.criteria.find(':') != std::string::npos &&
+            !slicer.getDG().getPTA()) {
+            err = "The line criteria are not supported with -dg-cache";
+            return false;
+        }
+
+        if (req.secondaryCriteria.empty())
+            req.secondaryCriteria = options.secondarySlicingCriteria;
+
+        return true;
+    }
+
+    // wait for the children that finished (or for one child if 'block')
+    // and answer the requests of the children that did not answer them
+    void reap(bool block)
+    {
+        while (!jobs.empty()) {
+            int status;
+            pid_t pid = waitpid(-1, &status, block ? 0 : WNOHANG);
+            if (pid < 0 && errno == EINTR)
+                continue;
+            if (pid <= 0)
+                return;
+
+            auto it = jobs.find(pid);
+            if (it == jobs.end())
+                continue;
+
+            const Job& job = it->second;
+            if (WIFSIGNALED(status)) {
+                respond(job.replyFd, "ERROR " + job.output +
+                        " Slicing was killed by signal " +
+                        std::to_string(WTERMSIG(status)));
+            } else if (WIFEXITED(status) && WEXITSTATUS(status) != 0) {
+                respond(job.replyFd, "ERROR " + job.output +
+                        " Slicing exited with status " +
+                        std::to_string(WEXITSTATUS(status)));
+            }
+
+            close(job.replyFd);
+            jobs.erase(it);
+            if (block)
+                return;
+        }
+    }
+
+    void sliceInChild(const Request& req, int outFd)
+    {
+        for (int fd : openFds) {
+            if (fd != outFd)
+                close(fd);
+        }
+        for (auto& it : jobs)
+            close(it.second.replyFd);
+
+        SlicerOptions reqOptions = options;
+        reqOptions.outputFile = req.output;
+        reqOptions.forwardSlicing = req.forward;
+        reqOptions.secondarySlicingCriteria = req.secondaryCriteria;
+        ModuleWriter writer(reqOptions, M);
+
+        auto criteria_nodes = getSlicingCriteriaNodes(slicer.getDG(),
+                                                      req.criteria);
+        if (criteria_nodes.empty()) {
+            llvm::errs() << "Did not find slicing criteria: '"
+                         << req.criteria << "'\n";
+            if (!slicer.createEmptyMain()) {
+                respond(outFd, "ERROR Could not create an empty main");
+                _exit(0);
+            }
+        } else {
+            auto secondaryCriteria
+                = parseSecondarySlicingCriteria(req.secondaryCriteria);
+            findSecondarySlicingCriteria(slicer.getDG(), criteria_nodes,
+                                         secondaryCriteria.first,
+                                         secondaryCriteria.second);
+
+            if (!slicer.mark(criteria_nodes, req.forward) || !slicer.slice()) {
+                respond(outFd, "ERROR Slicing failed");
+                _exit(0);
+            }
+        }
+
+        maybe_print_statistics(M, "Statistics after ");
+        int ret = writer.cleanAndSaveModule(should_verify_module);
+        respond(outFd, ret == 0 ? "OK " + req.output
+                                : "ERROR Saving " + req.output + " failed");
+        // the request is answered (see reap()),
+        // do not run the destructors of the shared state
+        _exit(0);
+    }
+
+    void handle(std::string line, int outFd)
+    {
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+
+        auto start = line.find_first_not_of(" \t");
+        if (start == std::string::npos || line[start] == '#')
+            return;
+
+        if (line.compare(start, std::string::npos, "quit") == 0) {
+            quit = true;
+            return;
+        }
+
+        Request req;
+        std::string err;
+        if (!parseRequest(line, req, err)) {
+            respond(outFd, "ERROR " + err);
+            return;
+        }
+
+        while (jobs.size() >= maxJobs)
+            reap(true);
+
+        int replyFd = dup(outFd);
+        if (replyFd < 0) {
+            perror("dup");
+            respond(outFd, "ERROR Could not duplicate the descriptor");
+            return;
+        }
+
+        pid_t pid = fork();
+        if (pid < 0) {
+            perror("fork");
+            close(replyFd);
+            respond(outFd, "ERROR Could not fork");
+            return;
+        }
+
+        if (pid == 0) {
+            close(replyFd);
+            sliceInChild(req, outFd);
+        }
+
+        jobs.emplace(pid, Job{replyFd, req.output});
+    }
+
+    // read what is available on 'fd' and handle the complete lines.
+    // Return false on the end of the input
+    bool readRequests(int fd, std::string& buffer, int outFd)
+    {
+        char buf[4096];
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n < 0 && errno == EINTR)
+            return true;
+
+        if (n <= 0) {
+            // the last line does not need to be terminated
+            if (!buffer.empty())
+                handle(buffer, outFd);
+            buffer.clear();
+            return false;
+        }
+
+        buffer.append(buf, n);
+        size_t pos;
+        while (!quit && (pos = buffer.find('\n')) != std::string::npos) {
+            std::string line = buffer.substr(0, pos);
+            buffer.erase(0, pos + 1);
+            handle(line, outFd);
+        }
+
+        return true;
+    }
+
+    // the standard input or a named pipe (that is opened again
+    // when the writer closes it)
+    int serveFile(const std::string& path)
+    {
+        bool isStdin = path == "-";
+        while (!quit) {
+            int fd = isStdin ? STDIN_FILENO : open(path.c_str(), O_RDONLY);
+            if (fd < 0) {
+                perror(path.c_str());
+                return 1;
+            }
+
+            openFds = {fd};
+            std::string buffer;
+            while (!quit) {
+                // wake up from time to time to wait for finished children
+                struct pollfd pfd{fd, POLLIN, 0};
+                int n = poll(&pfd, 1, 1000);
+                if (n < 0 && errno != EINTR) {
+                    perror("poll");
+                    break;
+                }
+
+                reap(false);
+                if (n > 0 && !readRequests(fd, buffer, STDOUT_FILENO))
+                    break;
+            }
+
+            if (isStdin)
+                break;
+            close(fd);
+        }
+
+        return 0;
+    }
+
+    int serveSocket(const std::string& path)
+    {
+        struct sockaddr_un addr;
+        if (path.size() >= sizeof(addr.sun_path)) {
+            llvm::errs() << "ERROR: The path of the socket is too long: "
+                         << path << "\n";
+            return 1;
+        }
+
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1);
+
+        int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (sock < 0) {
+            perror("socket");
+            return 1;
+        }
+
+        if (bind(sock, reinterpret_cast<struct sockaddr *>(&addr),
+                 sizeof(addr)) < 0 || listen(sock, 16) < 0) {
+            perror(path.c_str());
+            close(sock);
+            return 1;
+        }
+
+        llvm::errs() << "INFO: Listening on " << path << "\n";
+
+        // client -> its unfinished line
+        std::map<int, std::string> clients;
+        while (!quit) {
+            std::vector<struct pollfd> fds{{sock, POLLIN, 0}};
+            for (auto& it : clients)
+                fds.push_back({it.first, POLLIN, 0});
+
+            openFds.clear();
+            for (auto& pfd : fds)
+                openFds.push_back(pfd.fd);
+
+            // wake up from time to time to wait for finished children
+            if (poll(fds.data(), fds.size(), 1000) < 0 && errno != EINTR) {
+                perror("poll");
+                break;
+            }
+
+            reap(false);
+
+            for (auto& pfd : fds) {
+                if (quit || !(pfd.revents & (POLLIN | POLLHUP | POLLERR)))
+                    continue;
+
+                if (pfd.fd == sock) {
+                    int client = accept(sock, nullptr, nullptr);
+                    if (client >= 0)
+                        clients.emplace(client, std::string());
+                    continue;
+                }
+
+                if (!readRequests(pfd.fd, clients[pfd.fd], pfd.fd)) {
+                    // the children that answer the client have
+                    // their own copy of the descriptor
+                    close(pfd.fd);
+                    clients.erase(pfd.fd);
+                }
+            }
+        }
+
+        for (auto& it : clients)
+            close(it.first);
+        close(sock);
+        unlink(path.c_str());
+        return 0;
+    }
+
+public:
+    SlicingServer(Slicer& slicer, llvm::Module *M,
+                  const SlicerOptions& options, unsigned jobs)
+    : slicer(slicer), M(M), options(options),
+      maxJobs(jobs > 0 ? jobs : std::max(1u, std::thread::hardware_concurrency())) {}
+
+    int run(const std::string& input)
+    {
+        // the children do the marking on their copies of the graph
+        slicer.computeDependencies();
+
+        // a client may go away before it gets the answer
+        signal(SIGPIPE, SIG_IGN);
+
+        struct stat st;
+        int ret;
+        if (input == "-" ||
+            (stat(input.c_str(), &st) == 0 && S_ISFIFO(st.st_mode)))
+            ret = serveFile(input);
+        else
+            ret = serveSocket(input);
+
+        while (!jobs.empty())
+            reap(true);
+
+        return ret;
+    }
+};
+#endif // LLVM_ON_UNIX
+
+static int serveSlicingRequests(Slicer& slicer, llvm::Module *M,
+                                const SlicerOptions& options)
+{
+#ifdef LLVM_ON_UNIX
+    SlicingServer srv(slicer, M, options, serverJobs);
+    return srv.run(server);
+#else
+    (void) slicer;
+    (void) M;
+    (void) options;
+    llvm::errs() << "ERROR: The server mode is not supported on this system\n";
+    return 1;
+#endif // LLVM_ON_UNIX
+}
+
 #ifndef USING_SANITIZERS
 void setupStackTraceOnError(int argc, char *argv[])
 {
@@ -806,13 +1520,28 @@ int main(int argc, char *argv[])
     setupStackTraceOnError(argc, argv);
 
     SlicerOptions options = parseSlicerOptions(argc, argv);
+    options.statistics = statistics;
 
     // dump_dg_only implies dumg_dg
     if (dump_dg_only)
         dump_dg = true;
 
+    if (options.slicingCriteria.empty() && server.empty()) {
+        llvm::errs() << "ERROR: No slicing criteria given (use -c)\n";
+        return 1;
+    }
+
+    // written into the file when main() returns
+    dg::debug::TimeReportFile timeReport(options.timeReportFile, "llvm-slicer");
+    if (!options.traceFile.empty())
+        dg::debug::startTracing(options.traceFile);
+
     llvm::LLVMContext context;
-    std::unique_ptr<llvm::Module> M = parseModule(context, options);
+    std::unique_ptr<llvm::Module> M;
+    {
+        dg::util::TimeReport::Scope phase(timeReport.get(), "loading module");
+        M = parseModule(context, options);
+    }
     if (!M) {
         llvm::errs() << "Failed parsing '" << options.inputFile << "' file:\n";
         return 1;
@@ -828,6 +1557,7 @@ int main(int argc, char *argv[])
 
     // remove unused from module, we don't need that
     ModuleWriter writer(options, M.get());
+    writer.setTimeReport(timeReport.get());
     writer.removeUnusedFromModule();
 
     if (remove_unused_only) {
@@ -849,7 +1579,37 @@ int main(int argc, char *argv[])
         "klee_assume",
     };
 
+    // the stored graph does not have the results of pointer analysis
+    // and reaching definitions that these criteria and annotations need
+    if (!options.dgCacheFile.empty()) {
+        auto annotOpts = parseAnnotationOptions(annotationOpts);
+        if (options.slicingCriteria.find(':') != std::string::npos ||
+            (annotOpts & (AnnotationOptsT::ANNOTATE_PTR |
+                          AnnotationOptsT::ANNOTATE_RD))) {
+            llvm::errs() << "WARNING: The line criteria and annotations "
+                            "with pta or rd need the analyses, "
+                            "not using the cache of the graph\n";
+            options.dgCacheFile.clear();
+        }
+    }
+
+    // the lazy graph gets its dependencies while marking one slice
+    if (options.dgOptions.lazy &&
+        (options.forwardSlicing || options.twoPhaseSlicing ||
+         options.dgOptions.threads ||
+         options.dgOptions.cdAlgorithm != CD_ALG::CLASSIC ||
+         !options.dgCacheFile.empty() || !server.empty() ||
+         options.slicingCriteria.find(';') != std::string::npos ||
+         !annotationOpts.empty() || dump_dg)) {
+        llvm::errs() << "WARNING: The lazy dependence graph works only with "
+                        "the backward slicing w.r.t. one group of criteria "
+                        "without annotations and dumping the graph, "
+                        "building the whole graph\n";
+        options.dgOptions.lazy = false;
+    }
+
     Slicer slicer(M.get(), options);
+    slicer.setTimeReport(timeReport.get());
     if (!slicer.buildDG()) {
         errs() << "ERROR: Failed building DG\n";
         return 1;
@@ -858,8 +1618,30 @@ int main(int argc, char *argv[])
     ModuleAnnotator annotator(options, &slicer.getDG(),
                               parseAnnotationOptions(annotationOpts));
 
-    auto criteria_nodes = getSlicingCriteriaNodes(slicer.getDG(),
-                                                  options.slicingCriteria);
+    if (!server.empty()) {
+        if (annotator.shouldAnnotate() || dump_dg)
+            llvm::errs() << "WARNING: Annotating and dumping the graph "
+                            "is not supported by the server\n";
+
+        return serveSlicingRequests(slicer, M.get(), options);
+    }
+
+    auto criteriaGroups = splitList(options.slicingCriteria, ';');
+    if (criteriaGroups.size() > 1) {
+        if (annotator.shouldAnnotate() || dump_dg)
+            llvm::errs() << "WARNING: Annotating and dumping the graph "
+                            "is not supported with more groups of criteria\n";
+
+        return sliceCriteriaGroups(slicer, M.get(), options, criteriaGroups);
+    }
+
+    std::set<LLVMNode *> criteria_nodes;
+    {
+        dg::util::TimeReport::Scope phase(timeReport.get(), "slicing criteria");
+        criteria_nodes = getSlicingCriteriaNodes(slicer.getDG(),
+                                                 options.slicingCriteria);
+    }
+
     if (criteria_nodes.empty()) {
         llvm::errs() << "Did not find slicing criteria: '"
                      << options.slicingCriteria << "'\n";
@@ -881,7 +1663,7 @@ int main(int argc, char *argv[])
     const auto& secondaryDataCriteria = secondaryCriteria.second;
 
     // mark nodes that are going to be in the slice
-    if (!findSecondarySlicingCriteria(criteria_nodes,
+    if (!findSecondarySlicingCriteria(slicer.getDG(), criteria_nodes,
                                       secondaryControlCriteria,
                                       secondaryDataCriteria)) {
         llvm::errs() << "Finding dependent nodes failed\n";
@@ -894,6 +1676,8 @@ int main(int argc, char *argv[])
         return 1;
     }
 
+    maybe_print_cd_statistics(slicer.getDG());
+
     // print debugging llvm IR if user asked for it
     if (annotator.shouldAnnotate())
         annotator.annotate(&criteria_nodes);
@@ -21,7 +21,10 @@
 
 #include "dg/llvm/LLVMDependenceGraph.h"
 #include "dg/llvm/LLVMDependenceGraphBuilder.h"
+#include "dg/llvm/LLVMDGCache.h"
+#include "dg/llvm/LLVMSliceExtractor.h"
 #include "dg/llvm/LLVMSlicer.h"
+#include "dg/util/TimeReport.h"
 
 #include "llvm/LLVMDGAssemblyAnnotationWriter.h"
 #include "llvm-slicer-opts.h"
@@ -62,12 +65,100 @@ class Slicer {
     dg::LLVMSlicer slicer;
     uint32_t slice_id = 0;
     bool _computed_deps{false};
+    // the graph was loaded from the cache file
+    bool _loaded_dg{false};
+    uint64_t _cache_hash{0};
+
+    // the slices marked at once by markBatch()
+    std::unique_ptr<dg::analysis::BatchWalkAndMark<dg::LLVMNode>> _batch{};
+
+    // read-only slicing (see prepareReadOnlySlicing())
+    std::unique_ptr<dg::LLVMSliceExtractor> _extractor{};
+    std::unique_ptr<dg::analysis::SummaryEdges<dg::LLVMNode>> _summaries{};
+
+    // measure the phases into this report (if set)
+    dg::util::TimeReport *_timeReport{nullptr};
+
+    // add the criteria that are in every slice
+    // and set up the functions that we do not slice
+    void prepareMarking(std::set<dg::LLVMNode *>& criteria_nodes)
+    {
+        _dg->getCallSites(_options.additionalSlicingCriteria, &criteria_nodes);
+
+        for (auto& funcName : _options.preservedFunctions)
+            slicer.keepFunctionUntouched(funcName.c_str());
+    }
+
+    // the options that the graph depends on,
+    // the cached graph is used only with the same options
+    std::string getGraphConfig() const
+    {
+        const auto& opts = _options.dgOptions;
+        std::string cfg = "entry=" + opts.entryFunction;
+        cfg += ";pta=" + std::to_string(static_cast<int>(opts.PTAOptions.analysisType));
+        cfg += ";pta-fs=" + std::to_string(*opts.PTAOptions.fieldSensitivity);
+        cfg += ";rda=" + std::to_string(static_cast<int>(opts.RDAOptions.analysisType));
+        cfg += ";rda-su=" + std::to_string(opts.RDAOptions.strongUpdateUnknown);
+        cfg += ";rda-pure=" + std::to_string(opts.RDAOptions.undefinedArePure);
+        cfg += ";rda-max=" + std::to_string(*opts.RDAOptions.maxSetSize);
+        cfg += ";rda-modref=" + std::to_string(opts.RDAOptions.modRefSummaries);
+        cfg += ";du-pure=" + std::to_string(opts.DUOptions.undefinedArePure);
+        cfg += ";cd=" + std::to_string(static_cast<int>(opts.cdAlgorithm));
+        cfg += ";termination=" + std::to_string(opts.terminationSensitive);
+        cfg += ";threads=" + std::to_string(opts.threads);
+        for (const auto& it : opts.PTAOptions.allocationFunctions)
+            cfg += ";alloc=" + it.first + ":"
+                   + std::to_string(static_cast<int>(it.second));
+        return cfg;
+    }
+
+    // Load the graph from the cache file if it is up to date.
+    // Return false if there is no such graph in the file.
+    bool loadDG()
+    {
+        dg::util::TimeReport::Scope phase(_timeReport, "loading graph");
+        dg::debug::TimeMeasure tm;
+
+        tm.start();
+        _cache_hash = dg::LLVMDGCache::hash(*M, getGraphConfig());
+        _dg = dg::LLVMDGCache::load(M, _cache_hash, _options.dgCacheFile);
+        if (!_dg) {
+            llvm::errs() << "INFO: No up-to-date dependence graph in "
+                         << _options.dgCacheFile << ", building it\n";
+            return false;
+        }
+
+        tm.stop();
+        tm.report("INFO: Loading the dependence graph took");
+
+        // we cannot build the graph anymore if this fails,
+        // the functions of the module are taken by the loaded graph
+        if (_options.dgOptions.verifyGraph && !_dg->verify()) {
+            llvm::errs() << "ERROR: The dependence graph in "
+                         << _options.dgCacheFile << " is broken\n";
+            _dg.reset();
+            return true;
+        }
+
+        // the stored graph has all the dependencies
+        _computed_deps = true;
+        _loaded_dg = true;
+        return true;
+    }
 
 public:
     Slicer(llvm::Module *mod, const SlicerOptions& opts)
     : M(mod), _options(opts),
       _builder(mod, _options.dgOptions) { assert(mod && "Need module"); }
 
+    // Measure the phases of building the graph and slicing into the report.
+    // The report must live as long as the slicer.
+    void setTimeReport(dg::util::TimeReport *report)
+    {
+        _timeReport = report;
+        _builder.setTimeReport(report);
+    }
+
     const dg::LLVMDependenceGraph& getDG() const { return *_dg.get(); }
     dg::LLVMDependenceGraph& getDG() { return *_dg.get(); }
 
@@ -76,8 +167,12 @@ public:
     // 'compute_deps' parameter is set to true.
     // Otherwise, dependencies must be computed later
     // using computeDependencies().
+    //
+    // If the cache file is set, the graph is loaded from it
+    // (with the dependencies computed) if the file is up to date.
     bool buildDG(bool compute_deps = false) {
-        _dg = std::move(_builder.constructCFGOnly());
+        if (_options.dgCacheFile.empty() || !loadDG())
+            _dg = std::move(_builder.constructCFGOnly());
 
         if (!_dg) {
             llvm::errs() << "Building the dependence graph failed!\n";
@@ -94,19 +189,61 @@ public:
     // This method can be used to compute dependencies without
     // calling mark() afterwards (mark() calls this function).
     // It must not be called before calling mark() in the future.
+    // If the cache file is set, the graph with the dependencies
+    // is stored there.
     void computeDependencies() {
+        // the loaded graph has the dependencies already
+        if (_loaded_dg)
+            return;
+
         assert(!_computed_deps && "Already called computeDependencies()");
         // must call buildDG() before this function
         assert(_dg && "Must build dg before computing dependencies");
 
         _dg = _builder.computeDependencies(std::move(_dg));
         _computed_deps = true;
+
+        // the lazy graph computes the dependencies of a function
+        // when the marking reaches it
+        if (_dg && _dg->isLazy()) {
+            slicer.setGraphCallback([this](dg::DependenceGraph<dg::LLVMNode> *graph) {
+                _builder.computeFunctionDependencies(
+                    static_cast<dg::LLVMDependenceGraph *>(graph));
+            });
+        }
+
+        if (_dg && !_options.dgCacheFile.empty()) {
+            dg::util::TimeReport::Scope phase(_timeReport, "storing graph");
+            dg::debug::TimeMeasure tm;
+
+            tm.start();
+            if (dg::LLVMDGCache::save(_dg.get(), _cache_hash,
+                                      _options.dgCacheFile))
+                llvm::errs() << "INFO: Stored the dependence graph to "
+                             << _options.dgCacheFile << "\n";
+            tm.stop();
+            tm.report("INFO: Storing the dependence graph took");
+        }
+
+        const auto *demandRDA = _builder.getRDA()->getDemandDrivenRDA();
+        if (demandRDA && _options.statistics) {
+            const auto& st = demandRDA->getStatistics();
+            llvm::errs() << "INFO: Reaching definitions answered " << st.queries
+                         << " queries (" << st.cacheHits << " cache hits, "
+                         << st.visitedNodes << " nodes visited)\n";
+        }
     }
 
     // Mark the nodes from the slice.
     // This method calls computeDependencies(),
     // but buildDG() must be called before.
     bool mark(std::set<dg::LLVMNode *>& criteria_nodes)
+    {
+        return mark(criteria_nodes, _options.forwardSlicing);
+    }
+
+    // the same as above, but the direction of slicing is given explicitly
+    bool mark(std::set<dg::LLVMNode *>& criteria_nodes, bool forward)
     {
         assert(_dg && "mark() called without the dependence graph built");
         assert(!criteria_nodes.empty() && "Do not have slicing criteria");
@@ -114,7 +251,8 @@ public:
         dg::debug::TimeMeasure tm;
 
         // compute dependece edges
-        computeDependencies();
+        if (!_computed_deps)
+            computeDependencies();
 
         // unmark this set of nodes after marking the relevant ones.
         // Used to mimic the Weissers algorithm
@@ -123,16 +261,22 @@ public:
         if (_options.removeSlicingCriteria)
             unmark = criteria_nodes;
 
-        _dg->getCallSites(_options.additionalSlicingCriteria, &criteria_nodes);
-
-        for (auto& funcName : _options.preservedFunctions)
-            slicer.keepFunctionUntouched(funcName.c_str());
+        prepareMarking(criteria_nodes);
 
         slice_id = 0xdead;
 
+        dg::util::TimeReport::Scope phase(_timeReport, "marking");
         tm.start();
-        for (dg::LLVMNode *start : criteria_nodes)
-            slice_id = slicer.mark(start, slice_id, _options.forwardSlicing);
+        if (_options.twoPhaseSlicing && !forward) {
+            markTwoPhase(criteria_nodes);
+        } else {
+            if (_options.twoPhaseSlicing)
+                llvm::errs() << "WARNING: Two-phase slicing works only with "
+                                "backward slicing, ignoring it\n";
+
+            for (dg::LLVMNode *start : criteria_nodes)
+                slice_id = slicer.mark(start, slice_id, forward);
+        }
 
         assert(slice_id != 0 && "Somethig went wrong when marking nodes");
 
@@ -146,11 +290,156 @@ public:
         return true;
     }
 
+    // Mark the slices w.r.t. more sets of criteria by one walk
+    // (backward slicing only, at most BatchWalkAndMark::MAX_SLICES sets).
+    // The nodes of the i-th slice are then marked by markBatchSlice().
+    void markBatch(const std::vector<std::set<dg::LLVMNode *>>& criteria)
+    {
+        assert(_dg && "markBatch() called without the dependence graph built");
+
+        if (!_computed_deps)
+            computeDependencies();
+
+        auto groups = criteria;
+        for (auto& group : groups)
+            prepareMarking(group);
+
+        dg::util::TimeReport::Scope phase(_timeReport, "marking");
+        dg::debug::TimeMeasure tm;
+
+        tm.start();
+        _batch.reset(new dg::analysis::BatchWalkAndMark<dg::LLVMNode>());
+        _batch->mark(groups);
+        tm.stop();
+        tm.report("INFO: Finding dependent nodes of " +
+                  std::to_string(groups.size()) + " slices took");
+    }
+
+    // Mark the nodes of the i-th slice computed by markBatch(),
+    // so that the slice can be sliced by slice().
+    // Return the number of the nodes in the slice.
+    size_t markBatchSlice(unsigned idx,
+                          const std::set<dg::LLVMNode *>& criteria_nodes)
+    {
+        assert(_batch && "Must run markBatch() before markBatchSlice()");
+
+        slice_id = 0xdead;
+        size_t num = _batch->materialize(idx, slice_id);
+        if (_options.removeSlicingCriteria) {
+            for (dg::LLVMNode *nd : criteria_nodes)
+                nd->setSlice(0);
+        }
+
+        return num;
+    }
+
+    // mark the nodes using the summary edges. With the statistics,
+    // report also how many nodes it saved compared to the usual walk
+    void markTwoPhase(const std::set<dg::LLVMNode *>& criteria_nodes)
+    {
+        dg::debug::TimeMeasure tm;
+
+        tm.start();
+        dg::analysis::SummaryEdges<dg::LLVMNode> summaries;
+        summaries.compute(_dg.get());
+        tm.stop();
+        tm.report("INFO: Computing summary edges took");
+        llvm::errs() << "INFO: Computed " << summaries.size()
+                     << " summary edges\n";
+
+        dg::analysis::TwoPhaseWalkAndMark<dg::LLVMNode> twm(summaries);
+        twm.mark(criteria_nodes, slice_id);
+
+        if (!_options.statistics) {
+            llvm::errs() << "INFO: Two-phase slicing marked "
+                         << twm.getMarkedNodesNum() << " nodes\n";
+            return;
+        }
+
+        // the context-insensitive slice just for the comparison,
+        // it does not touch the graph
+        dg::analysis::SliceSet<dg::LLVMNode> slice;
+        dg::analysis::ReadOnlyWalkAndMark<dg::LLVMNode>::mark(criteria_nodes, slice);
+
+        llvm::errs() << "INFO: Two-phase slicing marked "
+                     << twm.getMarkedNodesNum() << " nodes vs "
+                     << slice.size()
+                     << " with the context-insensitive walk\n";
+    }
+
+    // Prepare the slicing that does not change the graph and the module:
+    // the slices are marked by markReadOnly() into SliceSets
+    // and sliceCopy() then creates the sliced copies of the module.
+    // After this call, markReadOnly() and sliceCopy() can be called
+    // from more threads at once.
+    void prepareReadOnlySlicing()
+    {
+        assert(_dg && "Must run buildDG() before");
+
+        if (!_computed_deps)
+            computeDependencies();
+
+        if (_options.twoPhaseSlicing) {
+            _summaries.reset(new dg::analysis::SummaryEdges<dg::LLVMNode>());
+            _summaries->compute(_dg.get());
+        }
+
+        dg::debug::TimeMeasure tm;
+
+        tm.start();
+        _extractor.reset(new dg::LLVMSliceExtractor(_dg.get()));
+        for (auto& funcName : _options.preservedFunctions)
+            _extractor->keepFunctionUntouched(funcName);
+        tm.stop();
+        tm.report("INFO: Preparing the read-only slicing took");
+    }
+
+    // Mark the slice into 'slice', the graph is only read
+    void markReadOnly(std::set<dg::LLVMNode *> criteria_nodes, bool forward,
+                      dg::analysis::SliceSet<dg::LLVMNode>& slice) const
+    {
+        assert(_extractor && "Must run prepareReadOnlySlicing() before");
+
+        std::set<dg::LLVMNode *> start = criteria_nodes;
+        _dg->getCallSites(_options.additionalSlicingCriteria, &start);
+
+        if (_options.twoPhaseSlicing && !forward) {
+            dg::analysis::TwoPhaseWalkAndMark<dg::LLVMNode> twm(*_summaries);
+            twm.mark(start, slice);
+        } else {
+            dg::analysis::ReadOnlyWalkAndMark<dg::LLVMNode>::mark(start, slice,
+                                                                   forward);
+        }
+
+        if (_options.removeSlicingCriteria) {
+            for (dg::LLVMNode *nd : criteria_nodes)
+                slice.erase(nd);
+        }
+    }
+
+    // Create the sliced copy of the module in the context 'ctx'
+    // (or an unsliced copy if 'slice' is nullptr) and store
+    // the statistics of the slicing into 'st' (if given).
+    // Nothing is printed, so that the threads can print under their lock.
+    std::unique_ptr<llvm::Module>
+    sliceCopy(const dg::analysis::SliceSet<dg::LLVMNode> *slice,
+              llvm::LLVMContext& ctx,
+              dg::analysis::SlicerStatistics *st = nullptr) const
+    {
+        assert(_extractor && "Must run prepareReadOnlySlicing() before");
+
+        if (!slice)
+            return _extractor->copy(ctx);
+
+        return _extractor->extract(*slice, ctx, st);
+    }
+
     bool slice()
     {
         assert(_dg && "Must run buildDG() and computeDependencies()");
         assert(slice_id != 0 && "Must run mark() method before slice()");
 
+        dg::util::TimeReport::Scope phase(_timeReport, "slicing");
         dg::debug::TimeMeasure tm;
 
         tm.start();
@@ -160,6 +449,10 @@ public:
         tm.report("INFO: Slicing dependence graph took");
 
         dg::analysis::SlicerStatistics& st = slicer.getStatistics();
+        if (_timeReport) {
+            _timeReport->setCounter("nodes", st.nodesTotal);
+            _timeReport->setCounter("removed nodes", st.nodesRemoved);
+        }
         llvm::errs() << "INFO: Sliced away " << st.nodesRemoved
                      << " from " << st.nodesTotal << " nodes in DG\n";
 
@@ -172,10 +465,16 @@ public:
     // otherwise the main is going to be empty
     bool createEmptyMain(bool call_entry = false)
     {
-        llvm::LLVMContext& ctx = M->getContext();
-        llvm::Function *main_func = M->getFunction("main");
+        return createEmptyMain(M, call_entry);
+    }
+
+    // the same as above, but in the given module (e.g., a copy of the module)
+    bool createEmptyMain(llvm::Module *mod, bool call_entry = false) const
+    {
+        llvm::LLVMContext& ctx = mod->getContext();
+        llvm::Function *main_func = mod->getFunction("main");
         if (!main_func) {
-            auto C = M->getOrInsertFunction("main",
+            auto C = mod->getOrInsertFunction("main",
                                             llvm::Type::getInt32Ty(ctx)
 #if LLVM_VERSION_MAJOR < 5
                                             , nullptr
@@ -203,7 +502,7 @@ public:
         llvm::BasicBlock* blk = llvm::BasicBlock::Create(ctx, "entry", main_func);
 
         if (call_entry && _options.dgOptions.entryFunction != "main") {
-            llvm::Function *entry = M->getFunction(_options.dgOptions.entryFunction);
+            llvm::Function *entry = mod->getFunction(_options.dgOptions.entryFunction);
             assert(entry && "The entry function is not present in the module");
 
             // TODO: we should set the arguments to undef